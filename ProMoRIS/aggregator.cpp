@@ -0,0 +1,289 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "aggregator.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+// values closer to zero are counted as zero
+#define SKETCH_MIN_VALUE 1e-9
+
+// SKETCH
+
+quantileSketch::quantileSketch() : zero_count(0), total(0) {
+	gamma = (1.0 + SKETCH_ACCURACY) / (1.0 - SKETCH_ACCURACY);
+	log_gamma = std::log(gamma);
+	positive.bins.assign(SKETCH_MAX_BINS, 0);
+	negative.bins.assign(SKETCH_MAX_BINS, 0);
+	positive.count = negative.count = 0;
+	clearStore(positive);
+	clearStore(negative);
+}
+
+void quantileSketch::clearStore(store_t& store) {
+	if (store.count > 0) {
+		for (int key = store.min_key; key <= store.max_key; ++key) store.bins[key - store.base] = 0;
+	}
+	store.base = 0;
+	store.min_key = std::numeric_limits<int>::max();
+	store.max_key = std::numeric_limits<int>::min();
+	store.count = 0;
+}
+
+void quantileSketch::clear() {
+	clearStore(positive);
+	clearStore(negative);
+	zero_count = 0;
+	total = 0;
+}
+
+// count key in store, the range of bins is moved to the new key
+// keys which do not fit anymore are collapsed into the lowest bin
+void quantileSketch::addKey(store_t& store, int key) {
+	if (store.count == 0) {
+		// room for keys below and above the first one
+		store.base = key - SKETCH_MAX_BINS / 2;
+	} else if (key < store.base) {
+		if (store.max_key - key < SKETCH_MAX_BINS) {
+			// move the bins up
+			int shift = store.base - key;
+			memmove(&store.bins[shift], &store.bins[0], (SKETCH_MAX_BINS - shift) * sizeof (uint64_t));
+			memset(&store.bins[0], 0, shift * sizeof (uint64_t));
+			store.base = key;
+		} else {
+			key = store.base;
+		}
+	} else if (key >= store.base + SKETCH_MAX_BINS) {
+		// move the bins down, collapsing the lowest ones
+		int new_base = key - SKETCH_MAX_BINS + 1;
+		uint64_t collapsed = 0;
+		for (int k = store.min_key; k < new_base && k <= store.max_key; ++k) {
+			collapsed += store.bins[k - store.base];
+			store.bins[k - store.base] = 0;
+		}
+		int shift = new_base - store.base;
+		if (shift < SKETCH_MAX_BINS) {
+			memmove(&store.bins[0], &store.bins[shift], (SKETCH_MAX_BINS - shift) * sizeof (uint64_t));
+			memset(&store.bins[SKETCH_MAX_BINS - shift], 0, shift * sizeof (uint64_t));
+		}
+		store.base = new_base;
+		if (collapsed > 0) {
+			store.bins[0] += collapsed;
+			store.min_key = new_base;
+		}
+		if (store.min_key < new_base) store.min_key = new_base;
+	}
+	++store.bins[key - store.base];
+	if (key < store.min_key) store.min_key = key;
+	if (key > store.max_key) store.max_key = key;
+	++store.count;
+}
+
+void quantileSketch::add(double value) {
+	if (std::isnan(value)) return;
+	++total;
+	if (std::fabs(value) < SKETCH_MIN_VALUE) {
+		++zero_count;
+		return;
+	}
+	double magnitude = std::min(std::fabs(value), std::numeric_limits<double>::max());
+	int key = static_cast<int> (std::ceil(std::log(magnitude) / log_gamma));
+	addKey(value > 0 ? positive : negative, key);
+}
+
+// center of a bin, relative error at most SKETCH_ACCURACY for all values of the bin
+double quantileSketch::keyValue(int key) const {
+	return 2.0 * std::pow(gamma, key) / (gamma + 1.0);
+}
+
+double quantileSketch::quantile(double q) const {
+	uint64_t rank = static_cast<uint64_t> (q * (total - 1) + 0.5);
+	uint64_t seen = 0;
+	// negative values: the largest magnitude first
+	for (int key = negative.max_key; negative.count > 0 && key >= negative.min_key; --key) {
+		seen += negative.bins[key - negative.base];
+		if (seen > rank) return -keyValue(key);
+	}
+	seen += zero_count;
+	if (seen > rank) return 0.0;
+	for (int key = positive.min_key; positive.count > 0 && key <= positive.max_key; ++key) {
+		seen += positive.bins[key - positive.base];
+		if (seen > rank) return keyValue(key);
+	}
+	return positive.count > 0 ? keyValue(positive.max_key) : 0.0;
+}
+
+// AGGREGATOR
+
+void windowAggregator::addSource(sampleBuffer* buffer, const std::vector<field_type_t>& types,
+		const std::vector<int>& indices, bool all) {
+	source_state_t source;
+	source.buffer = buffer;
+	// samples published before the start are not aggregated
+	source.cursor = all ? buffer->begin() : buffer->end();
+	source.count = 0;
+	source.last_time = 0;
+	for (int col_i : indices) {
+		column_stats_t column;
+		column.type = types[col_i];
+		column.field = col_i;
+		column.last.i = 0;
+		source.columns.push_back(column);
+	}
+	sources.push_back(std::move(source));
+}
+
+std::vector<column_t> windowAggregator::expandColumns(const std::vector<column_t>& columns) const {
+	std::vector<column_t> expanded;
+	if (columns.empty()) return expanded;
+
+	column_t count_column = columns[0];
+	count_column.label = "count";
+	count_column.type = FIELD_INT64;
+	count_column.width = std::max<int> (count_column.prefix.size() + 7, 8);
+	expanded.push_back(count_column);
+
+	for (auto &column : columns) {
+		if (!numeric(column.type)) {
+			expanded.push_back(column);
+			continue;
+		}
+		std::vector<std::string> stats = {"min", "max", "mean", "stddev"};
+		for (double percentile : percentiles) {
+			char name[32];
+			snprintf(name, sizeof (name), "p%g", percentile);
+			stats.push_back(name);
+		}
+		for (auto &stat : stats) {
+			column_t stat_column = column;
+			stat_column.label = column.label + "." + stat;
+			if (stat != "min" && stat != "max") stat_column.type = FIELD_DOUBLE;
+			stat_column.width = std::max<int> (column.width, column.prefix.size() + stat_column.label.size() + 2);
+			expanded.push_back(stat_column);
+		}
+	}
+	return expanded;
+}
+
+uint64_t windowAggregator::aggregate(int source_i, std::vector<cell_t>& row, int64_t until) {
+	source_state_t& source = sources[source_i];
+	sampleBuffer* buffer = source.buffer;
+
+	// samples of the window
+	uint64_t end = buffer->end();
+	if (source.cursor < buffer->begin()) {
+		lost_samples += buffer->begin() - source.cursor;
+		source.cursor = buffer->begin();
+	}
+	for (; source.cursor < end; ++source.cursor) {
+		sample_t sample = *buffer->at(source.cursor);
+		if (!buffer->valid(source.cursor)) {
+			++lost_samples;
+			continue;
+		}
+		if (sample.time > until) break;
+		++source.count;
+		source.last_time = sample.time;
+		for (auto &column : source.columns) {
+			if (!numeric(column.type)) {
+				column.last = sample.fields[column.field];
+				continue;
+			}
+			double value = column.type == FIELD_INT64 ? static_cast<double> (sample.fields[column.field].i)
+					: sample.fields[column.field].d;
+			if (source.count == 1) {
+				column.min = column.max = value;
+				column.mean = column.m2 = 0.0;
+			}
+			column.min = std::min(column.min, value);
+			column.max = std::max(column.max, value);
+			double delta = value - column.mean;
+			column.mean += delta / source.count;
+			column.m2 += delta * (value - column.mean);
+			column.sketch.add(value);
+		}
+	}
+
+	cell_t cell;
+	cell.type = FIELD_INT64;
+	cell.empty = false;
+	cell.value.i = source.count;
+	row.push_back(cell);
+
+	for (auto &column : source.columns) {
+		cell.empty = (source.count == 0);
+		if (!numeric(column.type)) {
+			cell.type = column.type;
+			if (column.type == FIELD_TIME) cell.value.i = source.last_time;
+			else cell.value = column.last;
+			row.push_back(cell);
+			continue;
+		}
+		for (int stat_i = 0; stat_i < 4 + percentiles.size(); ++stat_i) {
+			cell.type = FIELD_DOUBLE;
+			if (cell.empty) {
+				row.push_back(cell);
+				continue;
+			}
+			switch (stat_i) {
+				case 0:
+				case 1:
+				{
+					double value = stat_i == 0 ? column.min : column.max;
+					cell.type = column.type;
+					if (column.type == FIELD_INT64) cell.value.i = static_cast<int64_t> (value);
+					else cell.value.d = value;
+					break;
+				}
+				case 2: cell.value.d = column.mean;
+					break;
+				case 3: cell.value.d = source.count > 1 ? std::sqrt(column.m2 / (source.count - 1)) : 0.0;
+					break;
+				default:
+					// the estimate is within the observed range
+					cell.value.d = std::min(column.max, std::max(column.min,
+							column.sketch.quantile(percentiles[stat_i - 4] / 100.0)));
+					break;
+			}
+			row.push_back(cell);
+		}
+		column.sketch.clear();
+	}
+	uint64_t count = source.count;
+	source.count = 0;
+	return count;
+}
+
+bool windowAggregator::parsePercentiles(const char* text, std::vector<double>& percentiles) {
+	percentiles.clear();
+	if (strcmp(text, "-") == 0) return true;
+	const char* p = text;
+	while (*p != '\0') {
+		char* end;
+		double percentile = strtod(p, &end);
+		if (end == p || percentile < 0.0 || percentile > 100.0) return false;
+		percentiles.push_back(percentile);
+		p = end;
+		if (*p == ',') ++p;
+		else if (*p != '\0') return false;
+	}
+	return !percentiles.empty();
+}
@@ -0,0 +1,133 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "main.h"
+#include "module.h"
+#include "encoder.h"
+
+// relative accuracy of the percentiles
+#define SKETCH_ACCURACY 0.01
+// bins per sign of a sketch, the lowest ones are collapsed when values span a larger range
+// (with 1% accuracy, 2048 bins cover about 17 orders of magnitude)
+#define SKETCH_MAX_BINS 2048
+
+/*
+ * Constant-memory quantile sketch with relative error guarantees (DDSketch):
+ * values are counted in logarithmically sized bins, every bin covers values
+ * within +-SKETCH_ACCURACY of its center.
+ */
+class quantileSketch {
+public:
+	quantileSketch();
+	void add(double value);
+	// value at quantile q (0 - 1), count() must not be 0
+	double quantile(double q) const;
+	uint64_t count() const {
+		return total;
+	}
+	void clear();
+private:
+	// bins of the positive or negative values, keys are log_gamma(|value|)
+	typedef struct store_t {
+		std::vector<uint64_t> bins;
+		// key of bins[0]
+		int base;
+		// range of keys with counts
+		int min_key;
+		int max_key;
+		uint64_t count;
+	} store_t;
+	store_t positive;
+	store_t negative;
+	uint64_t zero_count;
+	uint64_t total;
+	double gamma;
+	double log_gamma;
+	static void addKey(store_t& store, int key);
+	static void clearStore(store_t& store);
+	double keyValue(int key) const;
+};
+
+/*
+ * Aggregation stage between the sample buffers and the output: instead of the latest sample,
+ * every row contains the count and min, max, mean, standard deviation and percentiles of every
+ * numeric column over all samples published since the previous row (the output window).
+ * Time and string columns contain the value of the latest sample.
+ * Every source (module and target) has a cursor into its buffer, so the buffer must hold
+ * the samples of a window (-b).
+ */
+class windowAggregator {
+public:
+	windowAggregator(const std::vector<double>& percentiles) : percentiles(percentiles), lost_samples(0) {}
+	// source with the types of all columns of the module and the indices of the requested ones
+	// samples already in the buffer are only aggregated with all (converted traces)
+	void addSource(sampleBuffer* buffer, const std::vector<field_type_t>& types, const std::vector<int>& indices,
+			bool all = false);
+	// output columns of a module for its requested columns
+	std::vector<column_t> expandColumns(const std::vector<column_t>& columns) const;
+	// append the aggregated cells of the window of source source_i to row and start a new window
+	// samples after until (same unit as sample_t::time) are left for the next window (offline conversion)
+	// returns the number of samples of the window
+	uint64_t aggregate(int source_i, std::vector<cell_t>& row, int64_t until = INT64_MAX);
+	// time stamp of the latest sample of source source_i
+	int64_t lastTime(int source_i) const {
+		return sources[source_i].last_time;
+	}
+	// samples overwritten before they were aggregated
+	uint64_t lost() const {
+		return lost_samples;
+	}
+	// parse a list of percentiles like "50,90,99.9" or "-" for none
+	static bool parsePercentiles(const char* text, std::vector<double>& percentiles);
+private:
+	typedef struct column_stats_t {
+		field_type_t type;
+		// index of the field in sample_t
+		int field;
+		double min;
+		double max;
+		// running mean and sum of squared deviations (Welford)
+		double mean;
+		double m2;
+		// string or time of the latest sample
+		field_t last;
+		quantileSketch sketch;
+	} column_stats_t;
+	typedef struct source_state_t {
+		sampleBuffer* buffer;
+		uint64_t cursor;
+		uint64_t count;
+		int64_t last_time;
+		std::vector<column_stats_t> columns;
+	} source_state_t;
+	std::vector<double> percentiles;
+	std::vector<source_state_t> sources;
+	uint64_t lost_samples;
+	static bool numeric(field_type_t type) {
+		return type == FIELD_INT64 || type == FIELD_DOUBLE;
+	}
+};
+
+#endif /* AGGREGATOR_H */
@@ -0,0 +1,103 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "alignment.h"
+#include <cmath>
+#include <cstring>
+
+void alignmentEngine::addModule(sampleBuffer* buffer, const std::vector<field_type_t>& types) {
+	cursor_t cursor;
+	cursor.buffer = buffer;
+	cursor.types = types;
+	cursor.next = 0;
+	cursor.has_before = false;
+	cursors.push_back(cursor);
+}
+
+const sample_t* alignmentEngine::align(int mod_i, int64_t t) {
+	cursor_t& c = cursors[mod_i];
+	sampleBuffer* buffer = c.buffer;
+
+	uint64_t end = buffer->end();
+	// samples overwritten before they were looked at are skipped
+	uint64_t begin = buffer->begin();
+	if (c.next < begin) c.next = begin;
+
+	// first sample after t among the samples published since the last call
+	uint64_t low = c.next, high = end;
+	while (low < high) {
+		uint64_t mid = low + (high - low) / 2;
+		if (buffer->at(mid)->time <= t) low = mid + 1;
+		else high = mid;
+	}
+
+	// copy the new latest sample not after t, keep the old one if it was overwritten while copying
+	if (low > c.next) {
+		sample_t latest = *buffer->at(low - 1);
+		if (buffer->valid(low - 1)) {
+			c.before = latest;
+			c.has_before = true;
+		}
+		c.next = low;
+	}
+
+	if (policy == ALIGN_LAST) return c.has_before ? &c.before : nullptr;
+
+	bool has_after = false;
+	if (c.next < end) {
+		c.after = *buffer->at(c.next);
+		has_after = buffer->valid(c.next);
+	}
+
+	if (!has_after) return c.has_before ? &c.before : nullptr;
+	// no extrapolation into the past
+	if (!c.has_before) return policy == ALIGN_NEAREST ? &c.after : nullptr;
+
+	bool before_nearer = (t - c.before.time <= c.after.time - t);
+	if (policy == ALIGN_NEAREST) return before_nearer ? &c.before : &c.after;
+
+	// ALIGN_LINEAR
+	double fraction = static_cast<double> (t - c.before.time) / (c.after.time - c.before.time);
+	const sample_t& nearest = before_nearer ? c.before : c.after;
+	c.interpolated.time = t;
+	for (size_t i = 0; i < c.types.size(); ++i) {
+		switch (c.types[i]) {
+			case FIELD_INT64:
+				c.interpolated.fields[i].i = c.before.fields[i].i + static_cast<int64_t> (std::llround(
+						(c.after.fields[i].i - c.before.fields[i].i) * fraction));
+				break;
+			case FIELD_DOUBLE:
+				c.interpolated.fields[i].d = c.before.fields[i].d +
+						(c.after.fields[i].d - c.before.fields[i].d) * fraction;
+				break;
+			default:
+				c.interpolated.fields[i] = nearest.fields[i];
+				break;
+		}
+	}
+	return &c.interpolated;
+}
+
+bool alignmentEngine::parsePolicy(const char* name, align_policy_t& policy) {
+	if (strcmp(name, "nearest") == 0) policy = ALIGN_NEAREST;
+	else if (strcmp(name, "last") == 0) policy = ALIGN_LAST;
+	else if (strcmp(name, "linear") == 0) policy = ALIGN_LINEAR;
+	else return false;
+	return true;
+}
@@ -0,0 +1,71 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ALIGNMENT_H
+#define ALIGNMENT_H
+
+#include <vector>
+#include "module.h"
+
+// how a sample is chosen for the alignment time
+typedef enum align_policy_t {
+	// sample with the time stamp closest to the alignment time
+	ALIGN_NEAREST,
+	// latest sample with a time stamp not after the alignment time
+	ALIGN_LAST,
+	// numeric values interpolated linearly between the samples before and after the alignment time
+	ALIGN_LINEAR
+} align_policy_t;
+
+/*
+ * Aligns the samples of all modules to a common, monotonically increasing alignment time.
+ * Every module has a cursor into its sample buffer which only moves forward,
+ * so the samples published since the last row are searched (binary search on the time stamps)
+ * instead of the whole history.
+ * Time stamps of the samples of one module must not decrease.
+ */
+class alignmentEngine {
+public:
+	alignmentEngine(align_policy_t policy) : policy(policy) {}
+	void addModule(sampleBuffer* buffer, const std::vector<field_type_t>& types);
+	// sample of module mod_i aligned to time t (same unit as sample_t::time)
+	// returns nullptr if there is no sample to be used
+	// the pointer stays valid until the next call for the same module
+	const sample_t* align(int mod_i, int64_t t);
+	// convert the name of a policy (nearest, last, linear)
+	static bool parsePolicy(const char* name, align_policy_t& policy);
+private:
+	typedef struct cursor_t {
+		sampleBuffer* buffer;
+		std::vector<field_type_t> types;
+		// first sequence number not known to be before or at the alignment time
+		uint64_t next;
+		// latest sample with a time stamp not after the alignment time
+		bool has_before;
+		sample_t before;
+		// first sample after the alignment time
+		sample_t after;
+		// interpolated sample
+		sample_t interpolated;
+	} cursor_t;
+	align_policy_t policy;
+	std::vector<cursor_t> cursors;
+};
+
+#endif /* ALIGNMENT_H */
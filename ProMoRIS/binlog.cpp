@@ -0,0 +1,141 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "binlog.h"
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+binlogReader::binlogReader() : data(nullptr), size(0), time_per_second(1), index_recovered(false) {
+}
+
+binlogReader::~binlogReader() {
+	if (data != nullptr) munmap(const_cast<char*> (data), size);
+}
+
+bool binlogReader::open(const char* path, std::string& error) {
+	int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		error = std::string("cannot open file: ") + strerror(errno);
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t> (sizeof (binlog_header_t))) {
+		::close(fd);
+		error = "file too small";
+		return false;
+	}
+	size = st.st_size;
+	void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mapped == MAP_FAILED) {
+		error = std::string("cannot map file: ") + strerror(errno);
+		return false;
+	}
+	data = static_cast<const char*> (mapped);
+
+	// header
+	const binlog_header_t* header = reinterpret_cast<const binlog_header_t*> (data);
+	if (memcmp(header->magic, BINLOG_MAGIC, 8) != 0) {
+		error = "not a ProMoRIS binary log";
+		return false;
+	}
+	if (header->version != BINLOG_VERSION || header->byte_order != BINLOG_BYTE_ORDER) {
+		error = "unsupported version or byte order";
+		return false;
+	}
+	time_per_second = header->time_per_second;
+
+	// column descriptions
+	size_t pos = sizeof (binlog_header_t);
+	for (uint32_t col_i = 0; col_i < header->column_count; ++col_i) {
+		if (pos + sizeof (binlog_column_header_t) > size) {
+			error = "truncated column descriptions";
+			return false;
+		}
+		const binlog_column_header_t* column = reinterpret_cast<const binlog_column_header_t*> (data + pos);
+		pos += sizeof (binlog_column_header_t);
+		if (pos + column->prefix_length + column->label_length > size) {
+			error = "truncated column descriptions";
+			return false;
+		}
+		binlog_column_t col;
+		col.type = static_cast<field_type_t> (column->type);
+		col.prefix.assign(data + pos, column->prefix_length);
+		pos += column->prefix_length;
+		col.label.assign(data + pos, column->label_length);
+		pos += column->label_length;
+		column_list.push_back(col);
+	}
+	pos = (pos + 7) / 8 * 8;
+
+	// index via trailer
+	const binlog_trailer_t* trailer = reinterpret_cast<const binlog_trailer_t*> (data + size - sizeof (binlog_trailer_t));
+	if (size >= pos + sizeof (binlog_trailer_t) && memcmp(trailer->magic, BINLOG_TRAILER_MAGIC, 8) == 0
+			&& trailer->index_offset + sizeof (binlog_index_header_t) <= size) {
+		const binlog_index_header_t* index_header = reinterpret_cast<const binlog_index_header_t*> (data + trailer->index_offset);
+		const binlog_index_entry_t* entries = reinterpret_cast<const binlog_index_entry_t*> (index_header + 1);
+		if (trailer->index_offset + sizeof (binlog_index_header_t)
+				+ index_header->block_count * sizeof (binlog_index_entry_t) <= size) {
+			index.assign(entries, entries + index_header->block_count);
+			return true;
+		}
+	}
+
+	// no valid trailer: rebuild the index from the block headers
+	index_recovered = true;
+	while (pos + sizeof (binlog_block_header_t) <= size) {
+		const binlog_block_header_t* block_header = reinterpret_cast<const binlog_block_header_t*> (data + pos);
+		if (block_header->magic != BINLOG_BLOCK_MAGIC ||
+				pos + sizeof (binlog_block_header_t) + block_header->body_bytes > size) break;
+		binlog_index_entry_t entry;
+		entry.offset = pos;
+		entry.first_time = block_header->first_time;
+		entry.last_time = block_header->last_time;
+		entry.rows = block_header->rows;
+		index.push_back(entry);
+		pos += sizeof (binlog_block_header_t) + block_header->body_bytes;
+	}
+
+	return true;
+}
+
+size_t binlogReader::findBlock(int64_t start) const {
+	size_t low = 0, high = index.size();
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (index[mid].last_time < start) low = mid + 1;
+		else high = mid;
+	}
+	return low;
+}
+
+binlog_block_t binlogReader::block(size_t block_i) const {
+	const binlog_block_header_t* block_header = reinterpret_cast<const binlog_block_header_t*> (data + index[block_i].offset);
+	binlog_block_t block;
+	block.rows = block_header->rows;
+	block.times = reinterpret_cast<const int64_t*> (block_header + 1);
+	block.columns = reinterpret_cast<const char*> (block.times + block.rows);
+	block.bitmap_bytes = binlogBitmapBytes(block.rows);
+	block.heap = block.columns + column_list.size() * (block.bitmap_bytes + 8 * block.rows);
+	return block;
+}
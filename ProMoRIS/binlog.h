@@ -0,0 +1,166 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "module.h"
+
+/*
+ * Binary columnar log format (-O binary)
+ *
+ * file:   file header, column descriptions, blocks, index, trailer
+ * header: binlog_header_t, then per column: binlog_column_header_t, prefix, label
+ * block:  binlog_block_header_t, then with n = rows:
+ *         row times: int64_t[n]
+ *         per column: presence bitmap (bit r set if row r has a value, padded to 8 bytes),
+ *                     values: field_t[n] (strings: offset into the string heap)
+ *         string heap: null-terminated strings
+ * index:  binlog_index_header_t, binlog_index_entry_t per block (sparse time index)
+ * trailer: binlog_trailer_t
+ *
+ * All values are stored in host byte order (checked with byte_order).
+ * If the trailer is missing (ProMoRIS was killed), readers walk the block headers instead.
+ */
+
+#define BINLOG_MAGIC "PMRSBIN1"
+#define BINLOG_TRAILER_MAGIC "PMRSIDX1"
+#define BINLOG_VERSION 1
+#define BINLOG_BYTE_ORDER 0x01020304u
+#define BINLOG_BLOCK_MAGIC 0x4b4c4250u
+
+typedef struct binlog_header_t {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t column_count;
+	uint32_t block_rows;
+	// units of the time stamps per second
+	int64_t time_per_second;
+} binlog_header_t;
+
+typedef struct binlog_column_header_t {
+	uint32_t type;
+	uint32_t prefix_length;
+	uint32_t label_length;
+	uint32_t reserved;
+} binlog_column_header_t;
+
+typedef struct binlog_block_header_t {
+	uint32_t magic;
+	uint32_t rows;
+	int64_t first_time;
+	int64_t last_time;
+	// bytes following this header
+	uint64_t body_bytes;
+} binlog_block_header_t;
+
+typedef struct binlog_index_header_t {
+	uint64_t block_count;
+} binlog_index_header_t;
+
+typedef struct binlog_index_entry_t {
+	uint64_t offset;
+	int64_t first_time;
+	int64_t last_time;
+	uint64_t rows;
+} binlog_index_entry_t;
+
+typedef struct binlog_trailer_t {
+	uint64_t index_offset;
+	char magic[8];
+} binlog_trailer_t;
+
+// bytes of the presence bitmap of one column
+inline uint64_t binlogBitmapBytes(uint64_t rows) {
+	return (rows + 63) / 64 * 8;
+}
+
+typedef struct binlog_column_t {
+	std::string prefix;
+	std::string label;
+	field_type_t type;
+} binlog_column_t;
+
+// one block of a memory-mapped log, values are read in place
+typedef struct binlog_block_t {
+	uint32_t rows;
+	const int64_t* times;
+	const char* columns;
+	const char* heap;
+	uint64_t bitmap_bytes;
+
+	bool present(uint32_t col, uint32_t row) const {
+		const uint8_t* bitmap = reinterpret_cast<const uint8_t*> (columns + col * (bitmap_bytes + 8 * rows));
+		return (bitmap[row / 8] >> (row % 8)) & 1;
+	}
+
+	field_t value(uint32_t col, uint32_t row) const {
+		const field_t* values = reinterpret_cast<const field_t*> (columns + col * (bitmap_bytes + 8 * rows) + bitmap_bytes);
+		return values[row];
+	}
+
+	const char* string(uint32_t col, uint32_t row) const {
+		return heap + value(col, row).i;
+	}
+} binlog_block_t;
+
+/*
+ * Reads a binary log through mmap.
+ * Blocks are found via the index, so reading a time range only touches the blocks in the range,
+ * and reading a subset of the columns only touches the pages of these columns.
+ */
+class binlogReader {
+public:
+	binlogReader();
+	~binlogReader();
+	// returns false and sets error if the file cannot be read
+	bool open(const char* path, std::string& error);
+	const std::vector<binlog_column_t>& columns() const {
+		return column_list;
+	}
+	int64_t timePerSecond() const {
+		return time_per_second;
+	}
+	size_t blockCount() const {
+		return index.size();
+	}
+	const binlog_index_entry_t& blockInfo(size_t block_i) const {
+		return index[block_i];
+	}
+	// first block which may contain rows with a time stamp not before start
+	size_t findBlock(int64_t start) const;
+	binlog_block_t block(size_t block_i) const;
+	// index was rebuilt from the block headers because the trailer was missing
+	bool recovered() const {
+		return index_recovered;
+	}
+private:
+	const char* data;
+	size_t size;
+	int64_t time_per_second;
+	std::vector<binlog_column_t> column_list;
+	std::vector<binlog_index_entry_t> index;
+	bool index_recovered;
+};
+
+#endif /* BINLOG_H */
@@ -0,0 +1,115 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "changefilter.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+changeFilter::changeFilter(const std::vector<epsilon_t>& epsilons, const std::vector<bool>& compared, int64_t heartbeat_ns) :
+epsilons(epsilons), compared(compared), heartbeat_ns(heartbeat_ns), changed_cells(compared.size(), true), suppressed_rows(0) {
+}
+
+bool changeFilter::differs(const cell_t& last, const cell_t& cell, const epsilon_t& epsilon) const {
+	if (last.empty || cell.empty) return last.empty != cell.empty;
+	switch (cell.type) {
+		case FIELD_INT64:
+		{
+			double diff = std::fabs(static_cast<double> (cell.value.i - last.value.i));
+			return diff > epsilon.absolute && diff > epsilon.relative * std::fabs(static_cast<double> (last.value.i));
+		}
+		case FIELD_DOUBLE:
+		{
+			// NaN never equals itself, it only counts as a change when it appears or disappears
+			if (std::isnan(cell.value.d) || std::isnan(last.value.d)) return std::isnan(cell.value.d) != std::isnan(last.value.d);
+			double diff = std::fabs(cell.value.d - last.value.d);
+			return diff > epsilon.absolute && diff > epsilon.relative * std::fabs(last.value.d);
+		}
+		case FIELD_STRING:
+		{
+			// the same pointer may hold a new string, so only missing strings are decided without comparing
+			if (cell.value.s == nullptr || last.value.s == nullptr) return cell.value.s != last.value.s;
+			return strcmp(cell.value.s, last.value.s) != 0;
+		}
+		default:
+			return cell.value.i != last.value.i;
+	}
+}
+
+// make cell the reference of column col_i, strings are copied
+void changeFilter::remember(key_state_t& state, size_t col_i, const cell_t& cell) {
+	state.cells[col_i] = cell;
+	if (cell.type != FIELD_STRING || cell.empty || cell.value.s == nullptr) return;
+	state.strings[col_i] = cell.value.s;
+	state.cells[col_i].value.s = state.strings[col_i].c_str();
+}
+
+bool changeFilter::pass(int key, int64_t time, const std::vector<cell_t>& row) {
+	if (key >= keys.size()) keys.resize(key + 1, key_state_t{false, 0, {}, {}});
+	key_state_t& state = keys[key];
+
+	// first row and heartbeats are printed completely
+	if (!state.printed || (heartbeat_ns > 0 && time - state.time >= heartbeat_ns)) {
+		state.printed = true;
+		state.time = time;
+		state.cells.resize(row.size());
+		state.strings.resize(row.size());
+		for (size_t col_i = 0; col_i < row.size(); ++col_i) remember(state, col_i, row[col_i]);
+		changed_cells.assign(row.size(), true);
+		return true;
+	}
+
+	bool any_changed = false;
+	for (size_t col_i = 0; col_i < row.size(); ++col_i) {
+		changed_cells[col_i] = !compared[col_i] || differs(state.cells[col_i], row[col_i], epsilons[col_i]);
+		any_changed = any_changed || (compared[col_i] && changed_cells[col_i]);
+	}
+	if (!any_changed) {
+		++suppressed_rows;
+		return false;
+	}
+
+	// only the changed cells move the reference, unchanged ones may still drift by up to epsilon
+	for (size_t col_i = 0; col_i < row.size(); ++col_i) {
+		if (changed_cells[col_i]) remember(state, col_i, row[col_i]);
+	}
+	state.time = time;
+	return true;
+}
+
+bool changeFilter::parseEpsilon(const char* text, std::string& column, epsilon_t& epsilon) {
+	const char* value = strrchr(text, '=');
+	if (value != nullptr) {
+		column.assign(text, value - text);
+		if (column.empty()) return false;
+		++value;
+	} else {
+		column.clear();
+		value = text;
+	}
+	char* end;
+	double number = strtod(value, &end);
+	if (end == value || number < 0 || !std::isfinite(number)) return false;
+	epsilon.absolute = 0;
+	epsilon.relative = 0;
+	if (strcmp(end, "%") == 0) epsilon.relative = number / 100;
+	else if (*end == '\0') epsilon.absolute = number;
+	else return false;
+	return true;
+}
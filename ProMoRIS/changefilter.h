@@ -0,0 +1,80 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANGEFILTER_H
+#define CHANGEFILTER_H
+
+#include <string>
+#include <vector>
+#include "main.h"
+#include "encoder.h"
+
+// tolerance of a column: a value counts as changed when it differs from the
+// last printed one by more than absolute and by more than relative * |last printed|
+// (one of them is 0, values are compared exactly if both are)
+typedef struct epsilon_t {
+	double absolute;
+	double relative;
+} epsilon_t;
+
+/*
+ * Change-based output suppression: a row is only printed when a value differs from
+ * the last printed row of the same key (target) by more than the epsilon of its column,
+ * or when the last printed row is older than the heartbeat.
+ * Time and diagnostic columns are never compared, they always change.
+ * For delta output, changed() tells which cells have to be printed; values within the
+ * epsilon are compared to the last printed value, so slow drifts are still reported.
+ */
+class changeFilter {
+public:
+	// compared[col_i] is false for columns which are always printed
+	changeFilter(const std::vector<epsilon_t>& epsilons, const std::vector<bool>& compared, int64_t heartbeat_ns);
+	// true if the row of key (index of the target, 0 for wide rows) at time has to be printed
+	bool pass(int key, int64_t time, const std::vector<cell_t>& row);
+	// cells of the last passed row which differ from the previous printed one
+	// (all cells for the first row of a key and for heartbeats)
+	const std::vector<bool>& changed() const {
+		return changed_cells;
+	}
+	// rows which were not printed
+	uint64_t suppressed() const {
+		return suppressed_rows;
+	}
+	// parse "EPSILON" or "EPSILON%" (relative), optionally prefixed by "COLUMN="
+	static bool parseEpsilon(const char* text, std::string& column, epsilon_t& epsilon);
+private:
+	typedef struct key_state_t {
+		bool printed;
+		int64_t time;
+		// last printed value of every cell
+		std::vector<cell_t> cells;
+		// copies of the strings of cells, modules may reuse their buffers
+		std::vector<std::string> strings;
+	} key_state_t;
+	std::vector<epsilon_t> epsilons;
+	std::vector<bool> compared;
+	int64_t heartbeat_ns;
+	std::vector<key_state_t> keys;
+	std::vector<bool> changed_cells;
+	uint64_t suppressed_rows;
+	bool differs(const cell_t& last, const cell_t& cell, const epsilon_t& epsilon) const;
+	void remember(key_state_t& state, size_t col_i, const cell_t& cell);
+};
+
+#endif /* CHANGEFILTER_H */
@@ -0,0 +1,378 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "encoder.h"
+#include "scheduler.h"
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// rows per block of the binary log
+#define BINLOG_BLOCK_ROWS 4096
+// a block of the binary log is written at least every second
+#define BINLOG_BLOCK_NS 1000000000LL
+
+char* writeTime(char* p, int64_t time, const time_format_t& time_format) {
+	static const int64_t divisors[] = {1000000000LL, 100000000LL, 10000000LL, 1000000LL, 100000LL,
+		10000LL, 1000LL, 100LL, 10LL, 1LL};
+	int64_t wall_ns = time + time_format.wall_offset_ns;
+	// seconds are truncated like time(), also before 1970
+	int64_t seconds = wall_ns / 1000000000LL;
+	int64_t fraction = wall_ns % 1000000000LL;
+	if (fraction < 0) {
+		--seconds;
+		fraction += 1000000000LL;
+	}
+	p = std::to_chars(p, p + CELL_TEXT_MAX, seconds).ptr;
+	if (time_format.precision <= 0) return p;
+
+	// fraction with leading zeros
+	int precision = time_format.precision > 9 ? 9 : time_format.precision;
+	*p++ = '.';
+	int64_t digits = fraction / divisors[precision];
+	for (int i = precision - 1; i >= 0; --i) {
+		p[i] = '0' + digits % 10;
+		digits /= 10;
+	}
+	return p + precision;
+}
+
+char* writeNumber(char* p, const cell_t& cell, const time_format_t& time_format) {
+	switch (cell.type) {
+		case FIELD_TIME:
+			return writeTime(p, cell.value.i, time_format);
+		case FIELD_INT64:
+			return std::to_chars(p, p + CELL_TEXT_MAX, cell.value.i).ptr;
+		case FIELD_DOUBLE:
+		{
+			std::to_chars_result result = std::to_chars(p, p + CELL_TEXT_MAX, cell.value.d, std::chars_format::fixed, 2);
+			// too large for fixed notation
+			if (result.ec != std::errc()) result = std::to_chars(p, p + CELL_TEXT_MAX, cell.value.d, std::chars_format::scientific, 2);
+			return result.ptr;
+		}
+		default:
+			return p;
+	}
+}
+
+rowEncoder* rowEncoder::create(const char* format, outputWriter* writer, const std::vector<column_t>& columns) {
+	if (strcmp(format, "table") == 0) return new tableEncoder(writer, columns);
+	if (strcmp(format, "csv") == 0) return new separatedEncoder(writer, columns, ',');
+	if (strcmp(format, "tsv") == 0) return new separatedEncoder(writer, columns, '\t');
+	if (strcmp(format, "ndjson") == 0) return new ndjsonEncoder(writer, columns);
+	if (strcmp(format, "binary") == 0) return new binaryEncoder(writer, columns);
+	return nullptr;
+}
+
+// TEXT
+
+// initial capacity of the line buffer
+#define LINE_RESERVE 1024
+
+textEncoder::textEncoder(outputWriter* writer, const std::vector<column_t>& columns) :
+rowEncoder(writer, columns), cell_prefixes(columns.size()), row_suffix("\n"), finite_only(false), omit_unchanged(false) {
+	line.reserve(LINE_RESERVE);
+}
+
+void textEncoder::pushLine() {
+	size_t capacity = line.capacity();
+	writer->push(std::move(line));
+	// the writer took the buffer, the next row gets one of the same size
+	line = std::string();
+	line.reserve(capacity);
+}
+
+void textEncoder::row(int64_t time, const std::vector<cell_t>& cells) {
+	encode(cells, nullptr);
+}
+
+void textEncoder::deltaRow(int64_t time, const std::vector<cell_t>& cells, const std::vector<bool>& changed) {
+	encode(cells, &changed);
+}
+
+void textEncoder::encode(const std::vector<cell_t>& cells, const std::vector<bool>* changed) {
+	line = row_prefix;
+	for (size_t col_i = 0; col_i < cells.size(); ++col_i) {
+		const cell_t& cell = cells[col_i];
+		if (changed != nullptr && !(*changed)[col_i]) {
+			if (omit_unchanged) continue;
+			line += cell_prefixes[col_i];
+			endCell(col_i, line.size());
+			continue;
+		}
+		if (omit_unchanged && col_i > 0 && line.size() == row_prefix.size()) line.append(cell_prefixes[col_i], 1, std::string::npos);
+		else line += cell_prefixes[col_i];
+		size_t start = line.size();
+		if (cell.empty || (finite_only && cell.type == FIELD_DOUBLE && !std::isfinite(cell.value.d))) {
+			// an empty cell of a delta row means unchanged, so a cell which became empty is marked
+			if (changed != nullptr && !omit_unchanged) line += DELTA_EMPTY_CELL;
+			else appendEmpty();
+		} else if (cell.type == FIELD_STRING) {
+			appendString(cell.value.s != nullptr ? cell.value.s : "");
+		} else {
+			line.resize(start + CELL_TEXT_MAX);
+			char* end = writeNumber(&line[start], cell, time_format);
+			line.resize(end - line.data());
+		}
+		endCell(col_i, start);
+	}
+	line += row_suffix;
+	pushLine();
+}
+
+// TABLE
+
+void tableEncoder::header() {
+	size_t end = 0;
+	for (auto &column : columns) {
+		end += column.width;
+		column_ends.push_back(end);
+	}
+	line.clear();
+	for (size_t col_i = 0; col_i < columns.size(); ++col_i) {
+		size_t start = line.size();
+		line += columns[col_i].prefix + ":" + columns[col_i].label;
+		endCell(col_i, start);
+	}
+	line += '\n';
+	pushLine();
+}
+
+void tableEncoder::appendString(const char* s) {
+	line += s;
+}
+
+// pad to the end of the column, at least one space follows a value
+// after a value wider than its column, the following columns catch up as soon as possible
+void tableEncoder::endCell(size_t col_i, size_t start) {
+	if (col_i + 1 == columns.size()) {
+		// keep the trailing padding of the last column like the header
+		if (line.size() < column_ends[col_i]) line.append(column_ends[col_i] - line.size(), ' ');
+		return;
+	}
+	if (line.size() < column_ends[col_i]) line.append(column_ends[col_i] - line.size(), ' ');
+	else line += ' ';
+}
+
+// CSV / TSV
+
+void separatedEncoder::header() {
+	for (size_t col_i = 1; col_i < columns.size(); ++col_i) cell_prefixes[col_i] = std::string(1, separator);
+	line.clear();
+	for (size_t col_i = 0; col_i < columns.size(); ++col_i) {
+		line += cell_prefixes[col_i];
+		appendString((columns[col_i].prefix + ":" + columns[col_i].label).c_str());
+	}
+	line += '\n';
+	pushLine();
+}
+
+void separatedEncoder::appendString(const char* s) {
+	if (separator == '\t') {
+		// TSV has no quoting, separators and line breaks in values are replaced
+		for (; *s != '\0'; ++s) line += (*s == '\t' || *s == '\n' || *s == '\r') ? ' ' : *s;
+		return;
+	}
+	if (strpbrk(s, ",\"\r\n") == nullptr) {
+		line += s;
+		return;
+	}
+	line += '"';
+	for (; *s != '\0'; ++s) {
+		if (*s == '"') line += '"';
+		line += *s;
+	}
+	line += '"';
+}
+
+// NDJSON
+
+ndjsonEncoder::ndjsonEncoder(outputWriter* writer, const std::vector<column_t>& columns) : textEncoder(writer, columns) {
+	finite_only = true;
+	omit_unchanged = true;
+	row_prefix = "{";
+	row_suffix = "}\n";
+}
+
+// the keys are prepared once, there is no header line
+void ndjsonEncoder::header() {
+	for (size_t col_i = 0; col_i < columns.size(); ++col_i) {
+		line.clear();
+		if (col_i > 0) line += ',';
+		appendString((columns[col_i].prefix + ":" + columns[col_i].label).c_str());
+		line += ':';
+		cell_prefixes[col_i] = line;
+	}
+	line.clear();
+}
+
+void ndjsonEncoder::appendString(const char* s) {
+	static const char hex[] = "0123456789abcdef";
+	line += '"';
+	for (; *s != '\0'; ++s) {
+		unsigned char c = *s;
+		if (c == '"' || c == '\\') {
+			line += '\\';
+			line += c;
+		} else if (c < 0x20) {
+			line += "\\u00";
+			line += hex[c >> 4];
+			line += hex[c & 0xf];
+		} else {
+			line += c;
+		}
+	}
+	line += '"';
+}
+
+void ndjsonEncoder::appendEmpty() {
+	line += "null";
+}
+
+// BINARY
+
+template<typename T>
+static void appendRaw(std::string& data, const T& value) {
+	data.append(reinterpret_cast<const char*> (&value), sizeof (T));
+}
+
+// pad to a multiple of 8 bytes, so all arrays in the file are aligned
+static void appendPadding(std::string& data) {
+	data.append((8 - data.size() % 8) % 8, '\0');
+}
+
+binaryEncoder::binaryEncoder(outputWriter* writer, const std::vector<column_t>& columns) :
+rowEncoder(writer, columns), offset(0), block_start_ns(0),
+bitmaps(columns.size()), values(columns.size()) {
+}
+
+// the file is only readable if nothing is missing, so the writer waits for room in the queue instead of dropping
+void binaryEncoder::push(std::string&& data) {
+	offset += data.size();
+	writer->push(std::move(data), true);
+}
+
+void binaryEncoder::header() {
+	std::string data;
+	binlog_header_t file_header;
+	memset(&file_header, 0, sizeof (file_header));
+	memcpy(file_header.magic, BINLOG_MAGIC, 8);
+	file_header.version = BINLOG_VERSION;
+	file_header.byte_order = BINLOG_BYTE_ORDER;
+	file_header.column_count = columns.size();
+	file_header.block_rows = BINLOG_BLOCK_ROWS;
+	file_header.time_per_second = SAMPLE_TIME_PER_SECOND;
+	appendRaw(data, file_header);
+	for (auto &column : columns) {
+		binlog_column_header_t column_header;
+		column_header.type = column.type;
+		column_header.prefix_length = column.prefix.size();
+		column_header.label_length = column.label.size();
+		column_header.reserved = 0;
+		appendRaw(data, column_header);
+		data += column.prefix;
+		data += column.label;
+	}
+	appendPadding(data);
+	push(std::move(data));
+}
+
+void binaryEncoder::row(int64_t time, const std::vector<cell_t>& cells) {
+	if (times.empty()) block_start_ns = monotonicNs();
+
+	size_t row_i = times.size();
+	times.push_back(time + time_format.wall_offset_ns);
+	for (size_t col_i = 0; col_i < cells.size(); ++col_i) {
+		std::vector<uint8_t>& bitmap = bitmaps[col_i];
+		if (row_i % 8 == 0) bitmap.push_back(0);
+		field_t value;
+		value.i = 0;
+		if (!cells[col_i].empty) {
+			bitmap.back() |= 1 << (row_i % 8);
+			value = cells[col_i].value;
+			if (cells[col_i].type == FIELD_TIME) value.i += time_format.wall_offset_ns;
+			// strings are stored once per block in the heap
+			if (cells[col_i].type == FIELD_STRING) {
+				std::string s = cells[col_i].value.s != nullptr ? cells[col_i].value.s : "";
+				auto known = heap_offsets.emplace(s, heap.size());
+				if (known.second) heap.append(s.c_str(), s.size() + 1);
+				value.i = known.first->second;
+			}
+		}
+		values[col_i].push_back(value);
+	}
+
+	if (times.size() >= BINLOG_BLOCK_ROWS || monotonicNs() - block_start_ns >= BINLOG_BLOCK_NS) closeBlock();
+}
+
+void binaryEncoder::closeBlock() {
+	if (times.empty()) return;
+
+	uint32_t rows = times.size();
+	uint64_t bitmap_bytes = binlogBitmapBytes(rows);
+
+	std::string data;
+	data.reserve(sizeof (binlog_block_header_t) + 8 * rows + columns.size() * (bitmap_bytes + 8 * rows) + heap.size() + 8);
+	binlog_block_header_t block_header;
+	block_header.magic = BINLOG_BLOCK_MAGIC;
+	block_header.rows = rows;
+	block_header.first_time = times.front();
+	block_header.last_time = times.back();
+	block_header.body_bytes = 0;
+	appendRaw(data, block_header);
+	data.append(reinterpret_cast<const char*> (times.data()), 8 * rows);
+	for (size_t col_i = 0; col_i < columns.size(); ++col_i) {
+		data.append(reinterpret_cast<const char*> (bitmaps[col_i].data()), bitmaps[col_i].size());
+		data.append(bitmap_bytes - bitmaps[col_i].size(), '\0');
+		data.append(reinterpret_cast<const char*> (values[col_i].data()), 8 * rows);
+		bitmaps[col_i].clear();
+		values[col_i].clear();
+	}
+	data += heap;
+	appendPadding(data);
+	reinterpret_cast<binlog_block_header_t*> (&data[0])->body_bytes = data.size() - sizeof (binlog_block_header_t);
+
+	binlog_index_entry_t entry;
+	entry.offset = offset;
+	entry.first_time = times.front();
+	entry.last_time = times.back();
+	entry.rows = rows;
+	push(std::move(data));
+	index.push_back(entry);
+
+	times.clear();
+	heap.clear();
+	heap_offsets.clear();
+}
+
+void binaryEncoder::finish() {
+	closeBlock();
+
+	std::string data;
+	binlog_index_header_t index_header;
+	index_header.block_count = index.size();
+	appendRaw(data, index_header);
+	data.append(reinterpret_cast<const char*> (index.data()), index.size() * sizeof (binlog_index_entry_t));
+	binlog_trailer_t trailer;
+	trailer.index_offset = offset;
+	memcpy(trailer.magic, BINLOG_TRAILER_MAGIC, 8);
+	appendRaw(data, trailer);
+	push(std::move(data));
+}
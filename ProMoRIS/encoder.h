@@ -0,0 +1,187 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "main.h"
+#include "binlog.h"
+#include "writer.h"
+
+// one column of the output
+typedef struct column_t {
+	// prefix of the module (without ':')
+	std::string prefix;
+	std::string label;
+	field_type_t type;
+	// width in the table format
+	int width;
+} column_t;
+
+// conversion of time stamps (sample_t::time, CLOCK_MONOTONIC) to UNIX time stamps
+typedef struct time_format_t {
+	// added to the time stamps, see wallClockOffsetNs()
+	int64_t wall_offset_ns;
+	// decimal places of the seconds in text formats (0 - 9)
+	int precision;
+} time_format_t;
+
+// space needed for the text of a time stamp or number
+#define CELL_TEXT_MAX 32
+// cell of a delta row which became empty in the formats leaving unchanged cells empty (table, csv, tsv)
+#define DELTA_EMPTY_CELL "-"
+
+// writes a time stamp as text to p (UNIX time in seconds with precision decimal places)
+// p must have room for CELL_TEXT_MAX characters, returns the end of the text
+char* writeTime(char* p, int64_t time, const time_format_t& time_format);
+
+// writes the value of a time, integer or double cell as text to p, like writeTime
+char* writeNumber(char* p, const cell_t& cell, const time_format_t& time_format);
+
+/*
+ * Converts the rows to an output format and passes them to the writer thread.
+ */
+class rowEncoder {
+public:
+	rowEncoder(outputWriter* writer, const std::vector<column_t>& columns) : writer(writer), columns(columns) {
+		time_format.wall_offset_ns = 0;
+		time_format.precision = 0;
+	}
+	virtual ~rowEncoder() {}
+	// must be set before header() is called
+	void setTimeFormat(const time_format_t& format) {
+		time_format = format;
+	}
+	virtual void header() = 0;
+	// time is the time stamp of the row (same unit as sample_t::time)
+	virtual void row(int64_t time, const std::vector<cell_t>& cells) = 0;
+	// delta encoding: like row(), but the cells which are false in changed did not change
+	// since the previous row of the same target, formats supporting it leave them out
+	virtual void deltaRow(int64_t time, const std::vector<cell_t>& cells, const std::vector<bool>& changed) {
+		row(time, cells);
+	}
+	// called before the writer is stopped
+	virtual void finish() {}
+	// encoder for a format name, nullptr if the format is unknown
+	static rowEncoder* create(const char* format, outputWriter* writer, const std::vector<column_t>& columns);
+protected:
+	outputWriter* writer;
+	std::vector<column_t> columns;
+	time_format_t time_format;
+};
+
+/*
+ * Base of the text formats: a row is rendered into one reused line buffer,
+ * numbers are converted with std::to_chars and the text around the cells
+ * (separators, keys) is prepared once per column in header().
+ */
+class textEncoder : public rowEncoder {
+public:
+	textEncoder(outputWriter* writer, const std::vector<column_t>& columns);
+	void row(int64_t time, const std::vector<cell_t>& cells);
+	void deltaRow(int64_t time, const std::vector<cell_t>& cells, const std::vector<bool>& changed);
+protected:
+	std::string line;
+	// text in front of the first cell
+	std::string row_prefix;
+	// text in front of the cell of each column
+	std::vector<std::string> cell_prefixes;
+	// text after the last cell
+	std::string row_suffix;
+	// NaN and infinity are written as empty cells
+	bool finite_only;
+	// unchanged cells of delta rows are left out completely instead of being written empty,
+	// the first character of the prefix of a cell is a separator dropped when it is the first one
+	bool omit_unchanged;
+	// render the cells, changed is nullptr for complete rows
+	void encode(const std::vector<cell_t>& cells, const std::vector<bool>* changed);
+	// pass the line to the writer and start a new one
+	void pushLine();
+	// appends a string value (escaped or quoted as the format needs)
+	virtual void appendString(const char* s) = 0;
+	// appends an empty cell
+	virtual void appendEmpty() {}
+	// called after the value of column col_i, which starts at line position start
+	virtual void endCell(size_t col_i, size_t start) {}
+};
+
+// space-padded table, columns are realigned after values wider than their column
+class tableEncoder : public textEncoder {
+public:
+	tableEncoder(outputWriter* writer, const std::vector<column_t>& columns) : textEncoder(writer, columns) {}
+	void header();
+protected:
+	void appendString(const char* s);
+	void endCell(size_t col_i, size_t start);
+private:
+	// position of the end of each column in the line
+	std::vector<size_t> column_ends;
+};
+
+// comma- (RFC 4180) or tab-separated values with a header line
+class separatedEncoder : public textEncoder {
+public:
+	separatedEncoder(outputWriter* writer, const std::vector<column_t>& columns, char separator) :
+	textEncoder(writer, columns), separator(separator) {}
+	void header();
+protected:
+	void appendString(const char* s);
+private:
+	char separator;
+};
+
+// one JSON object per row and line, keys are PREFIX:LABEL, empty cells are null
+// unchanged cells of delta rows are left out
+class ndjsonEncoder : public textEncoder {
+public:
+	ndjsonEncoder(outputWriter* writer, const std::vector<column_t>& columns);
+	void header();
+protected:
+	void appendString(const char* s);
+	void appendEmpty();
+};
+
+// binary columnar log, see binlog.h
+// time stamps are stored as UNIX time in nanoseconds
+class binaryEncoder : public rowEncoder {
+public:
+	binaryEncoder(outputWriter* writer, const std::vector<column_t>& columns);
+	void header();
+	void row(int64_t time, const std::vector<cell_t>& cells);
+	void finish();
+private:
+	// bytes passed to the writer so far
+	uint64_t offset;
+	int64_t block_start_ns;
+	std::vector<int64_t> times;
+	std::vector<std::vector<uint8_t>> bitmaps;
+	std::vector<std::vector<field_t>> values;
+	std::string heap;
+	// offsets of the strings in the heap of the current block, by content
+	// (modules may reuse a buffer for different strings)
+	std::unordered_map<std::string, int64_t> heap_offsets;
+	std::vector<binlog_index_entry_t> index;
+	void closeBlock();
+	void push(std::string&& data);
+};
+
+#endif /* ENCODER_H */
@@ -0,0 +1,256 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "epollreactor.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#include <sys/wait.h>
+
+// interval for polling processes when pidfds are not supported
+#define PROCESS_POLL_NS 100000000LL
+
+epollReactor::epollReactor() : next_id(0), stopped(false) {
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
+		std::cerr << "Could not create epoll instance: " << strerror(errno) << std::endl;
+	}
+}
+
+epollReactor::~epollReactor() {
+	for (auto &entry : sources) {
+		if (entry.second->own_fd) close(entry.second->fd);
+	}
+	close(epoll_fd);
+}
+
+int epollReactor::addSource(std::unique_ptr<source_t> source) {
+	int id = next_id++;
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.u64 = id;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, source->fd, &event) != 0) {
+		if (source->own_fd) close(source->fd);
+		return -1;
+	}
+	sources[id] = std::move(source);
+	return id;
+}
+
+int epollReactor::addLines(int fd, lineCallback_t on_line, closeCallback_t on_close) {
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	std::unique_ptr<source_t> source(new source_t());
+	source->kind = SOURCE_LINES;
+	source->fd = fd;
+	source->own_fd = false;
+	source->on_line = on_line;
+	source->on_close = on_close;
+	return addSource(std::move(source));
+}
+
+int epollReactor::addTimer(int64_t first_ns, int64_t interval_ns, timerCallback_t on_timer) {
+	int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (fd < 0) return -1;
+	itimerspec spec;
+	spec.it_value.tv_sec = first_ns / 1000000000LL;
+	spec.it_value.tv_nsec = first_ns % 1000000000LL;
+	spec.it_interval.tv_sec = interval_ns / 1000000000LL;
+	spec.it_interval.tv_nsec = interval_ns % 1000000000LL;
+	if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+		close(fd);
+		return -1;
+	}
+	std::unique_ptr<source_t> source(new source_t());
+	source->kind = SOURCE_TIMER;
+	source->fd = fd;
+	source->own_fd = true;
+	source->on_timer = on_timer;
+	return addSource(std::move(source));
+}
+
+int epollReactor::addProcess(pid_t pid, processCallback_t on_exit) {
+	std::unique_ptr<source_t> source(new source_t());
+	source->pid = pid;
+	source->own_fd = true;
+	source->on_exit = on_exit;
+#ifdef SYS_pidfd_open
+	source->kind = SOURCE_PROCESS;
+	source->fd = syscall(SYS_pidfd_open, pid, 0);
+#else
+	source->fd = -1;
+#endif
+	if (source->fd < 0) {
+		if (errno == ESRCH) return -1;
+		// no pidfd support, poll instead
+		source->kind = SOURCE_PROCESS_POLL;
+		source->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+		if (source->fd < 0) return -1;
+		itimerspec spec;
+		spec.it_value.tv_sec = spec.it_interval.tv_sec = 0;
+		spec.it_value.tv_nsec = spec.it_interval.tv_nsec = PROCESS_POLL_NS;
+		timerfd_settime(source->fd, 0, &spec, nullptr);
+	}
+	return addSource(std::move(source));
+}
+
+int epollReactor::addSignal(int signum, signalCallback_t on_signal) {
+	// the signal must be blocked in all threads, so it is only delivered to the signalfd
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, signum);
+	pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+	int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+	if (fd < 0) return -1;
+	std::unique_ptr<source_t> source(new source_t());
+	source->kind = SOURCE_SIGNAL;
+	source->fd = fd;
+	source->own_fd = true;
+	source->signum = signum;
+	source->on_signal = on_signal;
+	return addSource(std::move(source));
+}
+
+int epollReactor::addReadable(int fd, readableCallback_t on_readable) {
+	std::unique_ptr<source_t> source(new source_t());
+	source->kind = SOURCE_READABLE;
+	source->fd = fd;
+	source->own_fd = false;
+	source->on_readable = on_readable;
+	return addSource(std::move(source));
+}
+
+void epollReactor::remove(int id) {
+	auto entry = sources.find(id);
+	if (entry == sources.end()) return;
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, entry->second->fd, nullptr);
+	if (entry->second->own_fd) close(entry->second->fd);
+	removed.push_back(std::move(entry->second));
+	sources.erase(entry);
+}
+
+// true if process pid terminated, children are not reaped
+bool epollReactor::processExited(pid_t pid) {
+	siginfo_t info;
+	info.si_pid = 0;
+	if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == 0) return info.si_pid == pid;
+	// not a child of ProMoRIS
+	return kill(pid, 0) != 0 && errno == ESRCH;
+}
+
+void epollReactor::readLines(int id, source_t* source) {
+	char buffer[65536];
+	while (true) {
+		ssize_t n = read(source->fd, buffer, sizeof (buffer));
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+		if (n <= 0) {
+			// end of file: pass on an incomplete last line
+			if (!source->pending.empty()) source->on_line(source->pending.c_str());
+			source->pending.clear();
+			closeCallback_t on_close = source->on_close;
+			remove(id);
+			if (on_close) on_close();
+			return;
+		}
+
+		// pass on every complete line, keep the rest for the next read
+		source->pending.append(buffer, n);
+		size_t start = 0, end;
+		while ((end = source->pending.find('\n', start)) != std::string::npos) {
+			source->pending[end] = '\0';
+			source->on_line(&source->pending[start]);
+			// the callback may have removed the source
+			if (sources.find(id) == sources.end()) return;
+			start = end + 1;
+		}
+		source->pending.erase(0, start);
+	}
+}
+
+void epollReactor::dispatch(int id) {
+	auto entry = sources.find(id);
+	// removed by an earlier callback of the same epoll_wait
+	if (entry == sources.end()) return;
+	source_t* source = entry->second.get();
+
+	switch (source->kind) {
+		case SOURCE_LINES:
+			readLines(id, source);
+			break;
+		case SOURCE_TIMER:
+		{
+			uint64_t expirations;
+			if (read(source->fd, &expirations, sizeof (expirations)) == sizeof (expirations)) {
+				source->on_timer(expirations);
+			}
+			break;
+		}
+		case SOURCE_PROCESS_POLL:
+		{
+			uint64_t expirations;
+			if (read(source->fd, &expirations, sizeof (expirations)) != sizeof (expirations)) break;
+			if (!processExited(source->pid)) break;
+		}
+			// fall through
+		case SOURCE_PROCESS:
+		{
+			processCallback_t on_exit = source->on_exit;
+			pid_t pid = source->pid;
+			remove(id);
+			on_exit(pid);
+			break;
+		}
+		case SOURCE_SIGNAL:
+		{
+			signalfd_siginfo info;
+			while (read(source->fd, &info, sizeof (info)) == sizeof (info)) {
+				source->on_signal(info.ssi_signo);
+				if (sources.find(id) == sources.end()) break;
+			}
+			break;
+		}
+		case SOURCE_READABLE:
+			source->on_readable();
+			break;
+	}
+}
+
+void epollReactor::run() {
+	epoll_event events[64];
+	while (!stopped) {
+		int n = epoll_wait(epoll_fd, events, 64, -1);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			std::cerr << "epoll_wait failed: " << strerror(errno) << std::endl;
+			return;
+		}
+		for (int i = 0; i < n && !stopped; ++i) {
+			dispatch(static_cast<int> (events[i].data.u64));
+		}
+		removed.clear();
+	}
+}
+
+void epollReactor::stop() {
+	stopped = true;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EPOLLREACTOR_H
+#define EPOLLREACTOR_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "reactor.h"
+
+/*
+ * eventReactor based on epoll: lines are read from non-blocking pipes, timers are
+ * timerfds, processes are watched with pidfds and signals are received with signalfds.
+ * Without pidfd support (Linux < 5.3), processes are polled every 100 ms instead.
+ */
+class epollReactor : public eventReactor {
+public:
+	epollReactor();
+	~epollReactor();
+	int addLines(int fd, lineCallback_t on_line, closeCallback_t on_close);
+	int addTimer(int64_t first_ns, int64_t interval_ns, timerCallback_t on_timer);
+	int addProcess(pid_t pid, processCallback_t on_exit);
+	int addSignal(int signum, signalCallback_t on_signal);
+	void remove(int id);
+	int addReadable(int fd, readableCallback_t on_readable);
+	// dispatch events until stop() is called
+	void run();
+	void stop();
+private:
+
+	typedef enum source_kind_t {
+		SOURCE_LINES,
+		SOURCE_TIMER,
+		SOURCE_PROCESS,
+		SOURCE_PROCESS_POLL,
+		SOURCE_SIGNAL,
+		SOURCE_READABLE
+	} source_kind_t;
+
+	typedef struct source_t {
+		source_kind_t kind;
+		int fd;
+		// fd was created by the reactor and is closed on removal
+		bool own_fd;
+		pid_t pid;
+		int signum;
+		// incomplete line read from fd
+		std::string pending;
+		lineCallback_t on_line;
+		closeCallback_t on_close;
+		timerCallback_t on_timer;
+		processCallback_t on_exit;
+		signalCallback_t on_signal;
+		readableCallback_t on_readable;
+	} source_t;
+
+	int epoll_fd;
+	int next_id;
+	bool stopped;
+	std::unordered_map<int, std::unique_ptr<source_t>> sources;
+	// sources removed while dispatching, deleted after their callback returned
+	std::vector<std::unique_ptr<source_t>> removed;
+	int addSource(std::unique_ptr<source_t> source);
+	void dispatch(int id);
+	void readLines(int id, source_t* source);
+	static bool processExited(pid_t pid);
+};
+
+#endif /* EPOLLREACTOR_H */
@@ -24,6 +24,17 @@
 #include <stdio.h>
 #include "main.h"
 #include "module.h"
+#include "scheduler.h"
+#include "alignment.h"
+#include "aggregator.h"
+#include "changefilter.h"
+#include "overhead.h"
+#include "writer.h"
+#include "encoder.h"
+#include "targets.h"
+#include "epollreactor.h"
+#include "responder.h"
+#include "probe.h"
 #include <unistd.h>
 #include <iomanip>
 #include <csignal>
@@ -38,21 +49,38 @@
 #include <signal.h>
 #include <mutex>
 #include <tuple>
+#include <thread>
+#include <memory>
+#include <fcntl.h>
+#include <climits>
+#include <cerrno>
+
+// usage of ProMoRIS, printed by the help and on invalid arguments
+#define PROMORIS_USAGE "Usage as a regular expression:\n" \
+	"promoris (-m MODULE (-p PREFIX)? (-c COLUMN)* (-o OPTION)*)+ " \
+	"(-i INTERVAL | -I INTERVAL_MICRO)? (-b CAPACITY)? (-f LOGFILE)? (-O FORMAT)? (-F FLUSHPOLICY)? (-Q QUEUE_ROWS)? (-a | -A POLICY)? (-L LAG_MICRO)? (-d)? " \
+	"(-T LAYOUT)? (-t DIGITS)? (-g PERCENTILES)? (-e [COLUMN=]EPSILON)* (-H HEARTBEAT)? (-D)? (-S | -s)? (-r SPEED | --convert)? (-P TARGET+ | PROGRAM (PARAM)*)\n"
 
 std::vector<module*> modules_p;
 std::vector<destroyMod_t*> modules_destructors_p;
+// reactors accounting the callbacks of the module instances (-S, -s), destroyed after the modules
+std::vector<std::unique_ptr<accountingReactor>> modules_reactors;
 bool output_file;
-std::ofstream outfile;
+int output_fd = STDOUT_FILENO;
+// writes the rows in a separate thread
+outputWriter* output_writer = nullptr;
+// converts the rows to the output format
+rowEncoder* output_encoder = nullptr;
 bool exec_mode;
 
 // save the indices of the columns
 std::vector<std::vector<int>> modules_columns_indices;
-// vector of pointers to the value vectors of the modules
-std::vector<std::vector<std::vector < std::string>>*> modules_values_p;
-// vector of pointers to the mutexes of the value vectors
-std::vector<std::mutex*> modules_values_mp;
-// column width
-std::vector<int> columns_width;
+// types of the columns of every module
+std::vector<std::vector<field_type_t>> modules_columns_types;
+// sample sources of the modules, indexed by module and target
+std::vector<std::vector<source_t>> modules_sources;
+// columns of the output
+std::vector<column_t> output_columns;
 
 param_t modules_param;
 std::vector<std::string> modules_load_list;
@@ -60,16 +88,67 @@ std::vector<std::vector < std::string>> modules_columns_list;
 std::vector<std::vector < std::string>> modules_options_list;
 std::vector<std::string> modules_prefix_list;
 
-// for alternative alignment: last time stamp
-long alignment_timestamp = -1;
-// for alternative alignment: last skip vector
-std::vector<bool> alignment_skip;
+// PIDs of the processes to be monitored
+std::vector<pid_t> targets;
+// targets which do not exist anymore
+std::vector<bool> targets_terminated;
+// several processes were requested, so rows or columns are labelled with the PID
+bool multi_target = false;
+// all targets in one row instead of one row per target
+bool wide_rows = false;
+
+// event loop of the main thread, shared with the modules
+epollReactor* reactor = nullptr;
+// grid of deadlines the rows are created on
+tickScheduler* tick_scheduler = nullptr;
+// print the diagnostic columns of the scheduler
+bool tick_diagnostics = false;
+
+// use the alternative alignment (-a, -A)
+bool alternative_alignment = false;
+// for alternative alignment: aligns the samples of all modules to the time of the row
+alignmentEngine* alignment_engine = nullptr;
+// for alternative alignment: rows are aligned to the time alignment_lag before the tick
+int64_t alignment_lag = 0;
+// aggregation of all samples of the output window instead of the latest one (-g)
+windowAggregator* aggregator = nullptr;
+// rows are only printed when a value changed by more than its epsilon (-e, -H, -D)
+changeFilter* change_filter = nullptr;
+// print only the changed cells of a row (-D)
+bool delta_output = false;
+// self-overhead instrumentation (-S, -s)
+overheadMonitor* overhead_monitor = nullptr;
+// print the overhead columns (-S)
+bool overhead_columns = false;
+// modules replay their traces instead of running their tools (-r), see modules_param.replay_speed
+bool replay_mode = false;
+// offline conversion of the traces of the modules (--convert), see module::convertTrace
+bool convert_mode = false;
+// part of the overhead monitor of every module instance (parallel to modules_p)
+std::vector<int> modules_overhead_parts;
+// part of the writer thread
+int writer_part = -1;
+// totals of the output and the time of the last tick for the overhead columns
+uint64_t overhead_last_bytes = 0;
+int64_t overhead_last_flush_ns = 0;
+int64_t overhead_last_rows_ns = 0;
 
 void shutDown(int retval) {
 
+	// write remaining rows
+	if (output_encoder != nullptr) {
+		output_encoder->finish();
+	}
+	if (output_writer != nullptr) {
+		output_writer->stop();
+		if (output_writer->dropped() > 0) {
+			std::cerr << "Dropped " << output_writer->dropped() << " rows because the output was too slow" << std::endl;
+		}
+	}
+
 	// close output file
 	if (output_file) {
-		outfile.close();
+		close(output_fd);
 	}
 
 	exit(retval);
@@ -78,175 +157,311 @@ void shutDown(int retval) {
 
 void exitHandler(int signum) {
 
+	// self-overhead summary, before the threads of the modules are stopped
+	if (overhead_monitor != nullptr) {
+		overhead_monitor->summary(std::cerr, modules_load_list,
+				output_writer != nullptr ? output_writer->writtenBytes() : 0,
+				output_writer != nullptr ? output_writer->flushNs() : 0,
+				output_writer != nullptr ? output_writer->flushes() : 0,
+				output_writer != nullptr ? output_writer->dropped() : 0);
+	}
+
 	// stop every monitoring module
 	for (auto mod : modules_p) {
 		mod->stopMon();
 	}
 
+	// report samples which could not be aggregated
+	if (aggregator != nullptr && aggregator->lost() > 0) {
+		std::cerr << "Lost " << aggregator->lost() << " samples for the aggregation, "
+				"increase the buffer capacity (-b)" << std::endl;
+	}
+
+	// report deadlines missed by the main loop
+	if (tick_scheduler != nullptr && tick_scheduler->missed() > 0) {
+		std::cerr << "Missed " << tick_scheduler->missed() << " of "
+				<< tick_scheduler->tick() << " ticks" << std::endl;
+	}
+
+	// destroy every module instance
+	for (int mod_i = 0; mod_i < modules_p.size(); ++mod_i) {
+		modules_destructors_p[mod_i](modules_p[mod_i]);
+	}
+	modules_p.clear();
+	modules_reactors.clear();
+
 	if (signum == -1) shutDown(1);
 	shutDown(0);
 
 }
 
-// create a new row by collecting the outputs (timing / alignment)
+// add the cells of the selected columns of a sample to a row
+void pushCells(std::vector<cell_t>& row, int mod_i, const sample_t* sample) {
+	for (int i = 0; i < modules_columns_indices[mod_i].size(); ++i) {
+		int col_i = modules_columns_indices[mod_i][i];
+		cell_t cell;
+		cell.type = modules_columns_types[mod_i][col_i];
+		cell.empty = (sample == nullptr);
+		if (sample != nullptr) {
+			if (cell.type == FIELD_TIME) cell.value.i = sample->time;
+			else cell.value = sample->fields[col_i];
+		}
+		row.push_back(cell);
+	}
+}
+
+// add the cells of sample seq of the buffer of module mod_i for target target_i to a row
+// returns false and adds empty cells if the sample was overwritten while copying it
+bool pushSample(std::vector<cell_t>& row, int mod_i, int target_i, uint64_t seq, int64_t& sample_time) {
+	sampleBuffer* buffer = modules_sources[mod_i][target_i].buffer;
+	sample_time = buffer->at(seq)->time;
+	pushCells(row, mod_i, buffer->at(seq));
+	if (buffer->valid(seq)) return true;
+	row.resize(row.size() - modules_columns_indices[mod_i].size());
+	pushCells(row, mod_i, nullptr);
+	return false;
+}
 
-std::vector<std::string> createRow() {
+// add the overhead columns of module mod_i for target target_i to a row
+void pushOverheadCells(std::vector<cell_t>& row, int mod_i, int target_i) {
+	int source_i = mod_i * targets.size() + target_i;
+	cell_t cell;
+	cell.empty = false;
+	cell.type = FIELD_DOUBLE;
+	cell.value.d = overhead_monitor->windowCpu(overhead_monitor->sourcePart(source_i));
+	row.push_back(cell);
+	cell.type = FIELD_INT64;
+	cell.value.i = overhead_monitor->windowSamples(source_i);
+	row.push_back(cell);
+	cell.value.i = overhead_monitor->lastLatency(source_i);
+	cell.empty = cell.value.i < 0;
+	row.push_back(cell);
+}
 
-	int mod_i;
-	std::mutex* mt_values_mp;
-	std::vector<std::vector < std::string>>*mt_values_p;
+// check whether module mod_i still delivers samples for target target_i
+// a module may stop when its target terminated, otherwise ProMoRIS is terminated
+bool checkRunning(int mod_i, int target_i) {
+	if (targets_terminated[target_i]) return false;
+	if (modules_sources[mod_i][target_i].mod->running()) return true;
+	// the samples of a finished replay stay valid, ProMoRIS terminates after the row (replayFinished)
+	// converted traces are complete before the first row
+	if (replay_mode || convert_mode) return true;
+	if (!targetAlive(targets[target_i])) {
+		targets_terminated[target_i] = true;
+		return false;
+	}
+	std::cerr << "Module " << modules_load_list[mod_i] << " stopped running." << std::endl;
+	exitHandler(-1);
+	return false;
+}
 
-	std::vector<std::string> current_row;
-	mod_i = -1;
-	for (auto &mod : modules_p) {
-		++mod_i;
-		mt_values_mp = modules_values_mp[mod_i];
-		mt_values_p = modules_values_p[mod_i];
-		// check if module is still running, if not, terminate program
-		if (!mod->running()) {
-			std::cerr << "Module " << modules_load_list[mod_i] << " stopped running." << std::endl;
-			exitHandler(-1);
-		}
-		
-		std::unique_lock<std::mutex> values_lock(*mt_values_mp, std::defer_lock);
-		values_lock.lock();
-		if (mt_values_p->empty()) {
+// add the cells of all modules for target target_i to a row by collecting the outputs (timing / alignment)
+void createRow(std::vector<cell_t>& current_row, int target_i, int64_t row_time) {
+
+	for (int mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+		uint64_t seq;
+		if (!checkRunning(mod_i, target_i) ||
+				modules_sources[mod_i][target_i].buffer->peekLatest(seq) == nullptr) {
 			// push empty values if no row of values available
-			for (int i = 0; i < modules_columns_indices[mod_i].size(); ++i)
-				current_row.push_back("");
+			pushCells(current_row, mod_i, nullptr);
 		} else {
 			// only push the values in the columns the user wants to have
-			std::vector<std::string> mt_values_back = mt_values_p->back();
-			for (int i = 0; i < modules_columns_indices[mod_i].size(); ++i)
-				current_row.push_back(mt_values_back[modules_columns_indices[mod_i][i]]);
+			int64_t sample_time;
+			bool complete = pushSample(current_row, mod_i, target_i, seq, sample_time);
+			if (overhead_monitor != nullptr) {
+				int source_i = mod_i * targets.size() + target_i;
+				if (complete) overhead_monitor->sampleEmitted(source_i, sample_time, row_time);
+				else overhead_monitor->sampleOverwritten(source_i);
+			}
 		}
-		values_lock.unlock();
+		if (overhead_columns) pushOverheadCells(current_row, mod_i, target_i);
 	}
 
-	return current_row;
 }
 
 
 // alternative alignment
-// requires that the time stamp is saved in col 0 for every module
-// to work with microseconds, microsecond time stamp must be in col 0
-std::vector<std::string> createRowAlt() {
+// uses the time stamps of the samples (sample_t::time) to choose the samples for the current time
+// the alignment engine has one cursor per module and target
+void createRowAlt(std::vector<cell_t>& current_row, int target_i, int64_t alignment_time) {
+
+	for (int mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+		int source_i = mod_i * targets.size() + target_i;
+		if (!checkRunning(mod_i, target_i)) {
+			pushCells(current_row, mod_i, nullptr);
+		} else {
+			const sample_t* sample = alignment_engine->align(source_i, alignment_time);
+			pushCells(current_row, mod_i, sample);
+			if (overhead_monitor != nullptr && sample != nullptr) {
+				overhead_monitor->sampleEmitted(source_i, sample->time, alignment_time + alignment_lag);
+			}
+		}
+		if (overhead_columns) pushOverheadCells(current_row, mod_i, target_i);
+	}
 
-	int mod_i;
-	std::mutex* mt_values_mp;
-	std::vector<std::vector < std::string>>*mt_values_p;
+}
 
-	// alternative alignment: find last timestamp with data set by every module
-	// ignore modules with empty vector, do not fetch a time stamp twice
-	mod_i = -1;
-	// earliest timestamp which is greater than alignment_timestamp (last one printed)
-	long timestamp_earliest = -1;
+// aggregation
+// statistics of all samples published since the last row
+// the aggregator has one cursor per module and target
+void createRowAgg(std::vector<cell_t>& current_row, int target_i, int64_t row_time) {
+
+	for (int mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+		int source_i = mod_i * targets.size() + target_i;
+		// samples published before the module stopped are still aggregated
+		checkRunning(mod_i, target_i);
+		// converted traces contain the samples of all windows
+		uint64_t samples = aggregator->aggregate(source_i, current_row, convert_mode ? row_time : INT64_MAX);
+		if (overhead_monitor != nullptr && samples > 0) {
+			overhead_monitor->sampleEmitted(source_i, aggregator->lastTime(source_i), row_time, samples);
+		}
+		if (overhead_columns) pushOverheadCells(current_row, mod_i, target_i);
+	}
 
-	// values to be skipped because no unused value is available in the vector
-	std::vector<bool> skip;
-	bool skipped_one = false;
+}
 
-	for (auto &mod : modules_p) {
-		++mod_i;
-		mt_values_mp = modules_values_mp[mod_i];
-		mt_values_p = modules_values_p[mod_i];
+// a target terminated, terminate ProMoRIS when no target is left
+void targetExited(pid_t pid) {
+	bool target_left = false;
+	for (int target_i = 0; target_i < targets.size(); ++target_i) {
+		if (targets[target_i] == pid) targets_terminated[target_i] = true;
+		target_left = target_left || !targets_terminated[target_i];
+	}
+	if (!target_left) exitHandler(0);
+}
 
-		// check if module is still running, if not, terminate program
-		if (!mod->running()) {
-			std::cerr << "Module " << modules_load_list[mod_i] << " stopped running." << std::endl;
-			exitHandler(-1);
+// true when all modules finished replaying their traces
+bool replayFinished() {
+	for (auto &mod_sources : modules_sources) {
+		for (auto &src : mod_sources) {
+			if (src.mod->running()) return false;
 		}
+	}
+	return true;
+}
 
-		std::unique_lock<std::mutex> values_lock(*mt_values_mp, std::defer_lock);
-		values_lock.lock();
-
-		if (mt_values_p->empty()) {
-			values_lock.unlock();
-			skip.push_back(true);
-			skipped_one = true;
-		} else {
-			long timestamp_current = std::stol(mt_values_p->back()[0]);
-			values_lock.unlock();
-
-			// no earliest time stamp set yet
-			if (timestamp_earliest < 0) {
-				// data set with later or same time stamp already printed
-				if (alignment_timestamp >= timestamp_current) {
-					skip.push_back(true);
-					skipped_one = true;
-				} else {
-					timestamp_earliest = timestamp_current;
-					skip.push_back(false);
-				}
-			}				// earliest time stamp existing
-			else {
-				if (alignment_timestamp >= timestamp_current) {
-					skip.push_back(true);
-					skipped_one = true;
-				} else if (timestamp_earliest > timestamp_current) {
-					timestamp_earliest = timestamp_current;
-					skip.push_back(false);
-				} else {
-					skip.push_back(false);
-				}
+// print the rows for row_time, one per target or a single wide row
+void printRows(int64_t row_time, int64_t missed) {
+
+	std::vector<cell_t> current_row;
+	for (int target_i = 0; target_i < targets.size(); ++target_i) {
+		if (!wide_rows) {
+			if (targets_terminated[target_i]) continue;
+			current_row.clear();
+			if (multi_target) {
+				cell_t cell;
+				cell.type = FIELD_INT64;
+				cell.empty = false;
+				cell.value.i = targets[target_i];
+				current_row.push_back(cell);
 			}
-
 		}
 
-	}
+		if (aggregator != nullptr) createRowAgg(current_row, target_i, row_time);
+		else if (alternative_alignment) createRowAlt(current_row, target_i, row_time);
+		else createRow(current_row, target_i, row_time);
 
-	// alignment timestamp only increased if it has a data set for all modules
-	// OR: if the last skip time stamp was identical to avoid jumps back in time and allow moving forward
-	if(!skipped_one || skip == alignment_skip) alignment_timestamp = timestamp_earliest;
-	// update alignment_skip to current skip
-	alignment_skip = skip;
+		if (wide_rows && target_i < targets.size() - 1) continue;
 
-	// choose the latest time stamp coming closest to timestamp_earliest
-	std::vector<std::string> current_row;
-	mod_i = -1;
-	for (auto &mod : modules_p) {
-		++mod_i;
-		
-		if (skip[mod_i] == true) {
-			// push empty values if data set should be skipped
-			for (int i = 0; i < modules_columns_indices[mod_i].size(); ++i)
-				current_row.push_back("");
-			continue;
+		if (tick_diagnostics) {
+			for (int64_t diag_value : {tick_scheduler->tick(), tick_scheduler->drift(),
+					tick_scheduler->jitter(), missed}) {
+				cell_t cell;
+				cell.type = FIELD_INT64;
+				cell.empty = false;
+				cell.value.i = diag_value;
+				current_row.push_back(cell);
+			}
 		}
-		
-		mt_values_mp = modules_values_mp[mod_i];
-		mt_values_p = modules_values_p[mod_i];
-
-		std::unique_lock<std::mutex> values_lock(*mt_values_mp, std::defer_lock);
-		values_lock.lock();
-
-		// iterate through vector from back
-		std::vector<std::string> best;
-		long distance = 0;
-		for (int i = mt_values_p->size() - 1; i >= 0; --i) {
-			long ts_curr = std::stol(mt_values_p->at(i)[0]);
-			if (ts_curr > timestamp_earliest) {
-				best = mt_values_p->at(i);
-				distance = ts_curr - timestamp_earliest;
-			} else if (ts_curr == timestamp_earliest) {
-				best = mt_values_p->at(i);
-				break;
-			} else {
-				if (timestamp_earliest - ts_curr < distance) {
-					best = mt_values_p->at(i);
-				}
-				break;
+
+		// overhead of the main loop and the output
+		if (overhead_columns) {
+			cell_t cell;
+			cell.empty = false;
+			cell.type = FIELD_DOUBLE;
+			for (int part : {0, writer_part}) {
+				cell.value.d = overhead_monitor->windowCpu(part);
+				current_row.push_back(cell);
+			}
+			uint64_t bytes = output_writer->writtenBytes();
+			int64_t flush_ns = output_writer->flushNs();
+			cell.type = FIELD_INT64;
+			for (int64_t overhead_value : {overhead_last_rows_ns, static_cast<int64_t> (bytes - overhead_last_bytes),
+					flush_ns - overhead_last_flush_ns}) {
+				cell.value.i = overhead_value;
+				current_row.push_back(cell);
 			}
 		}
 
-		// only push the values in the columns the user wants to have
-		for (int i = 0; i < modules_columns_indices[mod_i].size(); ++i)
-			current_row.push_back(best[modules_columns_indices[mod_i][i]]);
+		// suppress rows without changes
+		if (change_filter != nullptr && !change_filter->pass(wide_rows ? 0 : target_i, row_time, current_row)) continue;
+
+		// print the row (written by the writer thread)
+		if (delta_output) output_encoder->deltaRow(row_time, current_row, change_filter->changed());
+		else output_encoder->row(row_time, current_row);
+	}
+
+}
+
+// create and print the rows of a tick
+void createRows(uint64_t expirations) {
+
+	int64_t missed = tick_scheduler->advance(expirations);
+	int64_t rows_start = 0;
+	if (overhead_monitor != nullptr) {
+		rows_start = monotonicNs();
+		overhead_monitor->tick(rows_start);
+	}
+
+	// alternative alignment when -a option present
+	printRows(sampleTime() - alignment_lag, missed);
+
+	if (overhead_monitor != nullptr) {
+		overhead_last_rows_ns = monotonicNs() - rows_start;
+		overhead_monitor->rowsCreated(overhead_last_rows_ns);
+		overhead_last_bytes = output_writer->writtenBytes();
+		overhead_last_flush_ns = output_writer->flushNs();
+	}
+
+	if (replay_mode && replayFinished()) exitHandler(0);
+
+}
 
-		values_lock.unlock();
+// offline conversion: print the rows on the grid of INTERVAL (UNIX time) over the time span of all samples
+void convertRows() {
+	int64_t interval_ns = modules_param.interval_micro > 0 ? modules_param.interval_micro * 1000LL : modules_param.interval * SAMPLE_TIME_PER_SECOND;
+	int64_t first = INT64_MAX;
+	int64_t last = INT64_MIN;
+	for (auto &mod_sources : modules_sources) {
+		for (auto &source : mod_sources) {
+			if (source.buffer->empty()) continue;
+			first = std::min(first, source.buffer->at(source.buffer->begin())->time);
+			last = std::max(last, source.buffer->at(source.buffer->end() - 1)->time);
+		}
 	}
+	if (first > last) return;
 
-	return current_row;
+	// the last row is not before the latest sample, so every sample is in a window of the aggregation
+	int64_t row_time = (first / interval_ns + (first % interval_ns > 0 ? 1 : 0)) * interval_ns;
+	while (true) {
+		printRows(row_time, 0);
+		if (row_time >= last) break;
+		row_time += interval_ns;
+	}
+}
+
+// parse a decimal integer argument between minimum and maximum, false on any other text
+bool parseInteger(const char* text, long long minimum, long long maximum, long long& value) {
+	char* end;
+	errno = 0;
+	value = strtoll(text, &end, 10);
+	return end != text && *end == '\0' && errno != ERANGE && value >= minimum && value <= maximum;
+}
+
+// report an invalid argument with the usage, returns the exit status
+int invalidArgument(const char* message) {
+	std::cerr << message << "\n\n" << PROMORIS_USAGE << "Run promoris -h for the explanation of the arguments." << std::endl;
+	return 1;
 }
 
 /*
@@ -279,10 +494,7 @@ int main(int argc, char** argv) {
 		}// generic help
 		else {
 
-			std::cout << "Usage as a regular expression:\n"
-					"promoris (-m MODULE (-p PREFIX)? (-c COLUMN)* (-o OPTION)*)+ "
-					"(-i INTERVAL | -I INTERVAL_MICRO)? (-f LOGFILE)? (-a)? "
-					"(-P PID | PROGRAM (PARAM)*)\n\n"
+			std::cout << PROMORIS_USAGE "\n"
 					"Explanation:\n"
 					"-m MODULE\n"
 					"	Use module MODULE. MODULE must be a shared library (.so) "
@@ -297,6 +509,8 @@ int main(int argc, char** argv) {
 					"	Columns should be passed without prefix.\n"
 					"	To see all columns provided by a module, use the module specific help (see below).\n"
 					"	Invalid column names are ignored.\n"
+					"	The requested columns are passed on to the module, modules supporting it\n"
+					"	skip acquiring the other ones.\n"
 					"	If no -c options are passed for a module, all columns will be displayed.\n"
 					"-o OPTION\n"
 					"	OPTION will be passed on to MODULE.\n"
@@ -309,19 +523,127 @@ int main(int argc, char** argv) {
 					"	INTERVAL is set to 1 when INTERVAL_MICRO is provided for "
 					"modules which do not support microseconds.\n"
 					"	When both -i and -I are given, the last one will win.\n"
+					"-b CAPACITY\n"
+					"	Number of samples kept per module (rounded up to a power of 2). Default is 1024.\n"
+					"	Older samples are overwritten, so memory usage stays constant.\n"
 					"-f LOGFILE\n"
 					"	Write the data sets to LOGFILE instead of stdout.\n"
+					"-O FORMAT\n"
+					"	Output format:\n"
+					"	table: space-padded text table (default)\n"
+					"	csv: comma-separated values (RFC 4180) with a header line\n"
+					"	tsv: tab-separated values with a header line\n"
+					"	ndjson: one JSON object per row, keys are PREFIX:COLUMN, empty cells are null\n"
+					"	binary: binary columnar log with a time index, requires -f.\n"
+					"	Read it with promoris-read.\n"
+					"-F FLUSHPOLICY\n"
+					"	When the rows are written to the output by the writer thread, comma separated:\n"
+					"	row: every row is written immediately\n"
+					"	size=BYTES: rows are written when BYTES bytes are queued\n"
+					"	time=MS: rows are written when the oldest queued row waited MS milliseconds\n"
+					"	Default is row for terminals and size=65536,time=1000 otherwise.\n"
+					"-Q QUEUE_ROWS\n"
+					"	Maximum number of rows waiting for the output. Further rows are dropped and\n"
+					"	counted, so a slow output never stalls the monitoring. Default is 65536.\n"
+					"	Blocks of binary logs are never dropped, the main loop waits for room in the queue instead.\n"
 					"-a\n"
-					"	Use alternative alignment algorithm. Requires compatible modules (time stamp in column 0).\n"
-					"-P PID\n"
-					"	Monitor the existing process PID. Unreliable, please do not use.\n"
-					"	All arguments passed after PID will be truncated.\n"
+					"	Use alternative alignment algorithm, same as -A nearest.\n"
+					"-A POLICY\n"
+					"	Use alternative alignment algorithm: the samples of all modules are aligned to the time\n"
+					"	of the row using their time stamps. POLICY is one of:\n"
+					"	nearest: use the sample with the time stamp closest to the time of the row\n"
+					"	last: use the latest sample not taken after the time of the row\n"
+					"	linear: interpolate numeric values between the samples before and after the time of the row\n"
+					"-L LAG_MICRO\n"
+					"	For alternative alignment, align rows to the time LAG_MICRO microseconds before the row is\n"
+					"	printed. Needed for linear interpolation, which requires a sample after the time of the row.\n"
+					"	Should be at least the longest sampling interval of the modules. Default is 0.\n"
+					"-d\n"
+					"	Add diagnostic columns of the main loop:\n"
+					"	promoris:tick (number of the tick, rows are exactly INTERVAL apart on this grid),\n"
+					"	promoris:drift (ns the row was started after its deadline),\n"
+					"	promoris:jitter (difference of drift to the previous row in ns) and\n"
+					"	promoris:missed (ticks skipped before this row because the loop was too slow).\n"
+					"	Missed ticks are also reported when ProMoRIS terminates.\n"
+					"-r SPEED\n"
+					"	Replay the traces recorded by the modules (TRACEFILE option of modTop and modNethogs,\n"
+					"	JSONFILE of modIperf3) instead of running their tools, e.g. to test the output pipeline offline.\n"
+					"	SPEED 1 keeps the original timing, 2 replays twice as fast, it must be greater than 0,\n"
+					"	because rows are created on the clock of the replay (use --convert to process traces as fast as possible).\n"
+					"	Traces without time stamps (raw tool output, the default TRACEFORMAT) are replayed with a snapshot every INTERVAL,\n"
+					"	raw JSON output of modIperf3 is replayed as fast as possible.\n"
+					"	Requires -P with the PIDs of the recording, the processes do not need to exist.\n"
+					"	ProMoRIS terminates when all traces were replayed. Samples get the time of the replay.\n"
+					"--convert\n"
+					"	Convert the traces of the modules (like -r) offline instead of monitoring: every trace is parsed\n"
+					"	completely in a thread of its own, then the rows are created on the grid of INTERVAL over the\n"
+					"	time span of the traces (UNIX time) and written as fast as possible in any output format.\n"
+					"	Samples are chosen by the alignment policy (-A, implies -a) or aggregated (-g).\n"
+					"	Traces without time stamps (raw tool output) start at the UNIX epoch, a snapshot every INTERVAL,\n"
+					"	modIperf3 always uses the time stamps reported by iperf3. The sample buffers hold the whole traces.\n"
+					"	Requires -P with the PIDs of the recording, cannot be combined with -r, -d, -S or -s.\n"
+					"-P TARGET+\n"
+					"	Monitor existing processes. All arguments after -P are targets, each one of:\n"
+					"	PID: the process PID\n"
+					"	pgid:PGID: all processes of the process group PGID\n"
+					"	comm:REGEX: all processes whose name matches the extended regular expression REGEX\n"
+					"	cmdline:REGEX: all processes whose command line matches REGEX\n"
+					"	Patterns are resolved once at startup. Batched modules sample all targets in one pass,\n"
+					"	for other modules one instance is loaded per target.\n"
+					"	ProMoRIS terminates when all targets have terminated.\n"
+					"-T LAYOUT\n"
+					"	Output layout when more than a single PID is passed to -P:\n"
+					"	rows: one row per target and tick with the PID in the first column promoris:pid (default)\n"
+					"	wide: one row per tick, the columns of every target are prefixed with PREFIX@PID\n"
+					"-g PERCENTILES\n"
+					"	Aggregate all samples published by the modules since the previous row instead of printing\n"
+					"	the latest one: PREFIX:count is the number of samples, every numeric column COLUMN is replaced by\n"
+					"	COLUMN.min, COLUMN.max, COLUMN.mean, COLUMN.stddev and COLUMN.pP for every percentile P of the\n"
+					"	comma separated list PERCENTILES (e.g. 50,90,99.9, or - for none). Time and string columns show the\n"
+					"	latest sample. Percentiles have a relative error of at most 1% and constant memory.\n"
+					"	Modules should sample faster than INTERVAL, e.g. modProc with its sampling interval option.\n"
+					"	The buffer (-b) must hold the samples of one interval. Cannot be combined with -a or -A.\n"
+					"-e [COLUMN=]EPSILON\n"
+					"	Only print a row when a value differs from the last printed one by more than EPSILON,\n"
+					"	an absolute value (e.g. 0.5) or relative to the last printed value (e.g. 5%).\n"
+					"	COLUMN is a label (all modules and targets) or PREFIX:LABEL, without COLUMN the epsilon\n"
+					"	applies to all columns without an own one. Default epsilon is 0 (any change).\n"
+					"	Time stamps and the promoris columns are not compared. With several targets in rows layout,\n"
+					"	every target is handled on its own.\n"
+					"-H HEARTBEAT\n"
+					"	With -e or -D, print a complete row at least every HEARTBEAT seconds, 0 to disable. Default is 60.\n"
+					"-D\n"
+					"	Delta output, implies suppression like -e: text formats only print the cells which changed\n"
+					"	since the previous row of the same target, the first row and heartbeats are complete.\n"
+					"	table, csv and tsv leave unchanged cells empty and print - for cells which became empty\n"
+					"	(e.g. values of a module which disappeared), ndjson leaves their keys out and prints null.\n"
+					"	Binary logs always store complete rows.\n"
+					"-S\n"
+					"	Add self-overhead columns: PREFIX:self.cpu (CPU of the module instance in % of one core since\n"
+					"	the previous row, including its threads, its child processes and its callbacks on the main loop),\n"
+					"	PREFIX:self.samples (samples published since the previous row) and PREFIX:self.latency\n"
+					"	(ns from taking the printed sample to printing it) after the columns of every module, and\n"
+					"	promoris:cpu (main loop), promoris:writer_cpu (writer thread), promoris:row_ns (time needed for\n"
+					"	the rows of the previous tick), promoris:out_bytes and promoris:flush_ns (bytes written and time\n"
+					"	spent writing since the previous row) at the end. Implies -s.\n"
+					"-s\n"
+					"	Print a summary of the overhead of ProMoRIS to stderr when terminating: CPU time of the main loop,\n"
+					"	the writer and every module instance, samples published, printed and overwritten while reading,\n"
+					"	latency percentiles of the printed samples, row creation times and output statistics.\n"
+					"	There is no lock wait time: the modules publish to lock-free buffers.\n"
+					"-t DIGITS\n"
+					"	Print time stamps with DIGITS decimal places (0 - 9). Default is 6 with -I and 0 otherwise.\n"
+					"	Modules take their time stamps from CLOCK_MONOTONIC with nanosecond resolution,\n"
+					"	they are mapped to UNIX time once at startup, so adjustments of the system clock\n"
+					"	while ProMoRIS is running do not affect the output.\n"
 					"PROGRAM (PARAM)*\n"
 					"	Start process PROGRAM for monitoring.\n"
 					"	PROGRAM should be a relative or absolute path.\n"
 					"	All arguments after PROGRAM are passed to PROGRAM.\n\n"
 					"Get module specific help:\n"
-					"	promoris -h MODULE"
+					"	promoris -h MODULE\n\n"
+					"Respond to the throughput probe module (modProbe) on PORT (default 5301):\n"
+					"	promoris -R (PORT)?"
 					<< std::endl;
 
 		}
@@ -329,21 +651,49 @@ int main(int argc, char** argv) {
 		return 0;
 	}
 
-	signal(SIGTERM, exitHandler);
+	// responder mode for the throughput probe module
+	if (strcmp(argv[1], "-R") == 0) {
+		long long port = PROBE_DEFAULT_PORT;
+		if (argc > 2 && !parseInteger(argv[2], 1, 65535, port)) return invalidArgument("Port must be between 1 and 65535");
+		epollReactor responder_reactor;
+		probeResponder responder(&responder_reactor);
+		if (responder.start(port) != 0) return 1;
+		responder_reactor.addSignal(SIGTERM, [&responder_reactor](int signum) {
+			responder_reactor.stop();
+		});
+		responder_reactor.addSignal(SIGINT, [&responder_reactor](int signum) {
+			responder_reactor.stop();
+		});
+		std::cerr << "Responding to probes on port " << port << " (TCP and UDP)" << std::endl;
+		responder_reactor.run();
+		return 0;
+	}
 
 	// analyze arguments
 	/*
 	 * arg_mode: current argument should be
-	 * 0: "-m" or "-i" or "-I" or "-f" or "-a" or PID
+	 * 0: "-m" or "-i" or "-I" or "-b" or "-f" or "-O" or "-F" or "-Q" or "-a" or "-A" or "-L" or "-d" or "-T" or "-t" or "-g" or "-e" or "-H" or "-D" or "-S" or "-s" or "-r" or "--convert" or "-P"
 	 * 1: module (last was "-m")
-	 * 2: "-m" or "-c" or "-p" or "-o" or "-i" or "-I" or "-f" or "-a" or PID
+	 * 2: "-m" or "-c" or "-p" or "-o" or "-i" or "-I" or "-b" or "-f" or "-O" or "-F" or "-Q" or "-a" or "-A" or "-L" or "-d" or "-T" or "-t" or "-g" or "-e" or "-H" or "-D" or "-S" or "-s" or "-r" or "--convert" or "-P"
 	 * 3: column (last was "-c") (module specific)
 	 * 4: prefix (last was "-p") (module specific)
 	 * 5: options (last was "-o") (module specific)
 	 * 6: interval (last was "-i")
 	 * 7: output file (last was "-f")
-	 * 8: PID (last was "-P")
+	 * 8: targets (last was "-P")
 	 * 9: microseconds interval (last was "-I")
+	 * 10: buffer capacity (last was "-b")
+	 * 11: alignment policy (last was "-A")
+	 * 12: alignment lag (last was "-L")
+	 * 13: flush policy (last was "-F")
+	 * 14: queue size (last was "-Q")
+	 * 15: output format (last was "-O")
+	 * 16: target layout (last was "-T")
+	 * 17: time precision (last was "-t")
+	 * 18: percentiles of the aggregation (last was "-g")
+	 * 19: epsilon of a column (last was "-e")
+	 * 20: heartbeat (last was "-H")
+	 * 21: replay speed (last was "-r")
 	 * 
 	 */
 	int arg_mode = 0;
@@ -351,16 +701,36 @@ int main(int argc, char** argv) {
 	modules_param.interval = 10;
 	// microseconds interval
 	modules_param.interval_micro = 0;
+	// samples kept per module
+	modules_param.buffer_size = SAMPLE_BUFFER_DEFAULT;
+	// modules run their tools unless -r is passed
+	modules_param.replay_speed = -1;
 	// for redirecting output to file
-	std::ostream* out = &std::cout;
 	output_file = false;
+	bool flush_policy_set = false;
+	flush_policy_t flush_policy;
+	size_t queue_rows = 65536;
+	const char* output_format = "table";
+	// decimal places of the time stamps, depends on the interval if not set
+	int time_precision = -1;
+	// aggregate the samples of every output window
+	bool aggregate = false;
+	std::vector<double> aggregate_percentiles;
+	// print rows only when values changed
+	bool suppress_unchanged = false;
+	epsilon_t default_epsilon = {0, 0};
+	std::vector<std::pair<std::string, epsilon_t>> column_epsilons;
+	int64_t heartbeat_ns = 60 * SAMPLE_TIME_PER_SECOND;
+	// print the overhead of ProMoRIS when terminating (-s, implied by -S)
+	bool overhead_summary = false;
 	// exec mode for directly starting process
 	exec_mode = true;
 	bool program_passed = false;
+	std::vector<std::string> target_specs;
 	char* exec_program;
 	int exec_param_c;
 	char** exec_param_v;
-	bool alternative_alignment = false;
+	align_policy_t alignment_policy = ALIGN_NEAREST;
 	for (int i = 1, module_i = -1; i < argc; ++i) {
 		if (arg_mode == 1) {
 			++module_i;
@@ -380,34 +750,107 @@ int main(int argc, char** argv) {
 			modules_options_list[module_i].push_back(argv[i]);
 			arg_mode = 2;
 		} else if (arg_mode == 6) {
-			modules_param.interval = atoi(argv[i]);
+			long long value;
+			if (!parseInteger(argv[i], 1, INT_MAX, value)) return invalidArgument("Monitoring interval must be 1 or greater");
+			modules_param.interval = value;
 			modules_param.interval_micro = 0;
-			if (modules_param.interval < 1) {
-				std::cerr << "Monitoring interval must be 1 or greater" << std::endl;
-				return 1;
-			}
 			arg_mode = 0;
 		} else if (arg_mode == 7) {
-			outfile.open(argv[i]);
-			if (!outfile.is_open()) {
+			output_fd = open(argv[i], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+			if (output_fd < 0) {
 				std::cerr << "Output file could not be opened" << std::endl;
 				return 1;
 			}
 			output_file = true;
-			out = &outfile;
 			arg_mode = 0;
 		} else if (arg_mode == 8) {
-			modules_param.pid = argv[i];
+			// all remaining arguments are targets
+			target_specs.assign(argv + i, argv + argc);
 			exec_mode = false;
 			program_passed = true;
 			break;
 		} else if (arg_mode == 9) {
-			modules_param.interval_micro = atoi(argv[i]);
+			long long value;
+			if (!parseInteger(argv[i], 1, INT_MAX, value)) return invalidArgument("Microseconds monitoring interval must be 1 or greater");
+			modules_param.interval_micro = value;
 			modules_param.interval = 1;
-			if (modules_param.interval_micro < 1) {
-				std::cerr << "Microseconds monitoring interval must be 1 or greater" << std::endl;
+			arg_mode = 0;
+		} else if (arg_mode == 10) {
+			long long value;
+			if (!parseInteger(argv[i], 2, INT_MAX, value)) return invalidArgument("Buffer capacity must be 2 or greater");
+			modules_param.buffer_size = value;
+			arg_mode = 0;
+		} else if (arg_mode == 11) {
+			if (!alignmentEngine::parsePolicy(argv[i], alignment_policy)) {
+				std::cerr << "Unknown alignment policy " << argv[i] << std::endl;
 				return 1;
 			}
+			alternative_alignment = true;
+			arg_mode = 0;
+		} else if (arg_mode == 13) {
+			if (!outputWriter::parsePolicy(argv[i], flush_policy)) {
+				std::cerr << "Invalid flush policy " << argv[i] << std::endl;
+				return 1;
+			}
+			flush_policy_set = true;
+			arg_mode = 0;
+		} else if (arg_mode == 14) {
+			// parsed signed, so negative sizes are rejected instead of wrapping around
+			long long rows;
+			if (!parseInteger(argv[i], 1, LLONG_MAX, rows)) return invalidArgument("Queue size must be 1 or greater");
+			queue_rows = rows;
+			arg_mode = 0;
+		} else if (arg_mode == 15) {
+			output_format = argv[i];
+			arg_mode = 0;
+		} else if (arg_mode == 16) {
+			if (strcmp(argv[i], "wide") == 0) wide_rows = true;
+			else if (strcmp(argv[i], "rows") == 0) wide_rows = false;
+			else {
+				std::cerr << "Unknown layout " << argv[i] << std::endl;
+				return 1;
+			}
+			arg_mode = 0;
+		} else if (arg_mode == 17) {
+			long long value;
+			if (!parseInteger(argv[i], 0, 9, value)) return invalidArgument("Time precision must be between 0 and 9");
+			time_precision = value;
+			arg_mode = 0;
+		} else if (arg_mode == 18) {
+			if (!windowAggregator::parsePercentiles(argv[i], aggregate_percentiles)) {
+				std::cerr << "Invalid percentiles " << argv[i] << std::endl;
+				return 1;
+			}
+			aggregate = true;
+			arg_mode = 0;
+		} else if (arg_mode == 19) {
+			std::string column;
+			epsilon_t epsilon;
+			if (!changeFilter::parseEpsilon(argv[i], column, epsilon)) {
+				std::cerr << "Invalid epsilon " << argv[i] << std::endl;
+				return 1;
+			}
+			if (column.empty()) default_epsilon = epsilon;
+			else column_epsilons.push_back(std::make_pair(column, epsilon));
+			suppress_unchanged = true;
+			arg_mode = 0;
+		} else if (arg_mode == 20) {
+			long long value;
+			if (!parseInteger(argv[i], 0, INT64_MAX / SAMPLE_TIME_PER_SECOND, value)) return invalidArgument("Heartbeat must be a number of seconds, not negative");
+			heartbeat_ns = value * SAMPLE_TIME_PER_SECOND;
+			suppress_unchanged = true;
+			arg_mode = 0;
+		} else if (arg_mode == 21) {
+			char* end;
+			modules_param.replay_speed = strtod(argv[i], &end);
+			// rows are created on the clock of the replay, as fast as possible is --convert
+			if (end == argv[i] || *end != '\0' || !(modules_param.replay_speed > 0)) return invalidArgument("Replay speed must be a number greater than 0, use --convert to process traces as fast as possible");
+			replay_mode = true;
+			arg_mode = 0;
+		} else if (arg_mode == 12) {
+			long long value;
+			if (!parseInteger(argv[i], 0, INT64_MAX / 1000, value)) return invalidArgument("Alignment lag must be a number of microseconds, not negative");
+			alignment_lag = value * SAMPLE_TIME_PER_SECOND / 1000000;
 			arg_mode = 0;
 		} else if (strcmp(argv[i], "-m") == 0) {
 			arg_mode = 1;
@@ -433,13 +876,53 @@ int main(int argc, char** argv) {
 			arg_mode = 6;
 		} else if (strcmp(argv[i], "-f") == 0) {
 			arg_mode = 7;
+		} else if (strcmp(argv[i], "-O") == 0) {
+			arg_mode = 15;
+		} else if (strcmp(argv[i], "-F") == 0) {
+			arg_mode = 13;
+		} else if (strcmp(argv[i], "-Q") == 0) {
+			arg_mode = 14;
 		} else if (strcmp(argv[i], "-P") == 0) {
 			arg_mode = 8;
 		} else if (strcmp(argv[i], "-I") == 0) {
 			arg_mode = 9;
+		} else if (strcmp(argv[i], "-b") == 0) {
+			arg_mode = 10;
 		} else if (strcmp(argv[i], "-a") == 0) {
 			alternative_alignment = true;
 			arg_mode = 0;
+		} else if (strcmp(argv[i], "-A") == 0) {
+			arg_mode = 11;
+		} else if (strcmp(argv[i], "-L") == 0) {
+			arg_mode = 12;
+		} else if (strcmp(argv[i], "-d") == 0) {
+			tick_diagnostics = true;
+			arg_mode = 0;
+		} else if (strcmp(argv[i], "-T") == 0) {
+			arg_mode = 16;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			arg_mode = 17;
+		} else if (strcmp(argv[i], "-g") == 0) {
+			arg_mode = 18;
+		} else if (strcmp(argv[i], "-e") == 0) {
+			arg_mode = 19;
+		} else if (strcmp(argv[i], "-H") == 0) {
+			arg_mode = 20;
+		} else if (strcmp(argv[i], "-r") == 0) {
+			arg_mode = 21;
+		} else if (strcmp(argv[i], "--convert") == 0) {
+			convert_mode = true;
+			arg_mode = 0;
+		} else if (strcmp(argv[i], "-S") == 0) {
+			overhead_columns = true;
+			arg_mode = 0;
+		} else if (strcmp(argv[i], "-s") == 0) {
+			overhead_summary = true;
+			arg_mode = 0;
+		} else if (strcmp(argv[i], "-D") == 0) {
+			suppress_unchanged = true;
+			delta_output = true;
+			arg_mode = 0;
 		} else {
 			exec_program = argv[i];
 			// save params to pass to program
@@ -463,6 +946,37 @@ int main(int argc, char** argv) {
 		std::cerr << "Please pass at least one module as an argument" << std::endl;
 		shutDown(1);
 	}
+	if (strcmp(output_format, "binary") == 0 && !output_file) {
+		std::cerr << "Binary output requires an output file (-f)" << std::endl;
+		shutDown(1);
+	}
+	if (aggregate && alternative_alignment) {
+		std::cerr << "Aggregation (-g) cannot be combined with alternative alignment (-a, -A)" << std::endl;
+		shutDown(1);
+	}
+	if (convert_mode && (replay_mode || tick_diagnostics || overhead_columns || overhead_summary)) {
+		std::cerr << "Conversion (--convert) cannot be combined with -r, -d, -S or -s" << std::endl;
+		shutDown(1);
+	}
+	if (replay_mode || convert_mode) {
+		// the recorded processes are gone, the PIDs only select the records of the traces
+		const char* mode = replay_mode ? "Replay (-r)" : "Conversion (--convert)";
+		if (exec_mode) {
+			std::cerr << mode << " requires the recorded PIDs after -P instead of a program" << std::endl;
+			shutDown(1);
+		}
+		for (auto &spec : target_specs) {
+			if (spec.empty() || spec.find_first_not_of("0123456789") != std::string::npos) {
+				std::cerr << mode << " requires plain PIDs after -P: " << spec << std::endl;
+				shutDown(1);
+			}
+		}
+	}
+	// converted samples are aligned by their time stamps
+	if (convert_mode && !aggregate) alternative_alignment = true;
+	if (time_precision < 0) time_precision = modules_param.interval_micro > 0 ? 6 : 0;
+	// map the monotonic time stamps to wall-clock time before anything is sampled
+	wallClockOffsetNs();
 
 	// start process via fork and execve
 	if (exec_mode) {
@@ -473,19 +987,58 @@ int main(int argc, char** argv) {
 			std::cerr << "Could not start program" << std::endl;
 			exit(0);
 		} else {
-			modules_param.pid_struct = exec_pid;
-			modules_param.pid = std::to_string(exec_pid);
+			targets.push_back(exec_pid);
 			usleep(10000);
 			int exec_status;
-			pid_t tpid = waitpid(modules_param.pid_struct, &exec_status, WNOHANG);
-			if (tpid == modules_param.pid_struct) {
+			pid_t tpid = waitpid(exec_pid, &exec_status, WNOHANG);
+			if (tpid == exec_pid) {
 				shutDown(1);
 			}
 		}
+	} else {
+		// resolve the -P targets
+		std::string error;
+		if (!resolveTargets(target_specs, targets, error)) {
+			std::cerr << "Cannot resolve targets: " << error << std::endl;
+			shutDown(1);
+		}
+		if (targets.empty()) {
+			std::cerr << "No process matches the targets" << std::endl;
+			shutDown(1);
+		}
+		multi_target = multipleTargets(target_specs);
+	}
+	targets_terminated.assign(targets.size(), false);
+	modules_param.pid_struct = targets[0];
+	modules_param.pid = std::to_string(targets[0]);
+
+	// the event loop, signals are handled by it before any thread is started
+	reactor = new epollReactor();
+	reactor->addSignal(SIGTERM, exitHandler);
+	reactor->addSignal(SIGINT, exitHandler);
+	modules_param.reactor = reactor;
+
+	// self-overhead instrumentation, the started program is not part of ProMoRIS
+	if (overhead_columns || overhead_summary) {
+		overhead_monitor = new overheadMonitor();
+		overhead_monitor->claimTasks(-1);
+	}
+
+	// terminate when the started program or all targets terminated
+	if (exec_mode) {
+		reactor->addProcess(targets[0], [](pid_t pid) {
+			exitHandler(0);
+		});
+	} else if (!replay_mode && !convert_mode) {
+		for (auto target : targets) {
+			if (reactor->addProcess(target, targetExited) < 0) targetExited(target);
+		}
 	}
 
 	// load modules, creators and destructors
+	int mod_i = -1;
 	for (auto &modules_load_current : modules_load_list) {
+		++mod_i;
 		void* mlc_load = dlopen(modules_load_current.c_str(), RTLD_LAZY);
 		if (!mlc_load) {
 			std::cerr << "Cannot load module: " << dlerror() << std::endl;
@@ -509,10 +1062,74 @@ int main(int argc, char** argv) {
 		}
 		modules_destructors_p.push_back(mlc_destroy);
 
+		// refuse modules built against another version of module.h
+		getApiVersion_t * mlc_version = (getApiVersion_t*) dlsym(mlc_load, "getApiVersion");
+		dlsym_err = dlerror();
+		if (dlsym_err || mlc_version() != MODULE_API_VERSION) {
+			std::cerr << "Module " << modules_load_current << " was built for an incompatible "
+					"version of the module interface" << std::endl;
+			shutDown(1);
+		}
+
 		// create an object pointer
 		module * mlc_objp = mlc_create();
 		modules_p.push_back(mlc_objp);
 
+		// indices of the requested columns, passed on to the module
+		// if there is a list of columns for this module, only show those in the list
+		modules_columns_indices.push_back(std::vector<int>());
+		std::vector<std::string> labels = mlc_objp->getLabels();
+		for (int col_i = 0; col_i < labels.size(); ++col_i) {
+			if (modules_columns_list[mod_i].empty() ||
+					std::find(modules_columns_list[mod_i].begin(), modules_columns_list[mod_i].end(),
+					labels[col_i]) != modules_columns_list[mod_i].end()) {
+				modules_columns_indices[mod_i].push_back(col_i);
+			}
+		}
+
+		param_t par = modules_param;
+		par.options = modules_options_list[mod_i];
+		par.columns = modules_columns_indices[mod_i];
+		modules_sources.push_back(std::vector<source_t>());
+
+		// batched modules get all targets, a buffer per target
+		if (mlc_objp->batched()) {
+			par.targets = targets;
+			if (overhead_monitor != nullptr) {
+				int part = overhead_monitor->addPart(modules_prefix_list[mod_i].substr(0, modules_prefix_list[mod_i].size() - 1));
+				modules_overhead_parts.push_back(part);
+				modules_reactors.emplace_back(new accountingReactor(reactor, overhead_monitor, part));
+				par.reactor = modules_reactors.back().get();
+			}
+			mlc_objp->setParameters(par);
+			for (int target_i = 0; target_i < targets.size(); ++target_i) {
+				modules_sources[mod_i].push_back({mlc_objp, mlc_objp->getTargetBuffer(target_i)});
+			}
+			continue;
+		}
+
+		// otherwise, one instance per target
+		for (int target_i = 0; target_i < targets.size(); ++target_i) {
+			if (target_i > 0) {
+				mlc_objp = mlc_create();
+				modules_p.push_back(mlc_objp);
+				modules_destructors_p.push_back(mlc_destroy);
+			}
+			par.pid_struct = targets[target_i];
+			par.pid = std::to_string(targets[target_i]);
+			par.targets = {targets[target_i]};
+			if (overhead_monitor != nullptr) {
+				std::string part_name = modules_prefix_list[mod_i].substr(0, modules_prefix_list[mod_i].size() - 1);
+				if (targets.size() > 1) part_name += "@" + par.pid;
+				int part = overhead_monitor->addPart(part_name);
+				modules_overhead_parts.push_back(part);
+				modules_reactors.emplace_back(new accountingReactor(reactor, overhead_monitor, part));
+				par.reactor = modules_reactors.back().get();
+			}
+			mlc_objp->setParameters(par);
+			modules_sources[mod_i].push_back({mlc_objp, mlc_objp->getBuffer()});
+		}
+
 	}
 
 	if (modules_p.size() < 1) {
@@ -521,94 +1138,254 @@ int main(int argc, char** argv) {
 	}
 
 
+	// CONVERT THE TRACES, one thread per module instance
+
+	if (convert_mode) {
+		std::vector<std::thread> converters;
+		std::vector<char> converted(modules_p.size());
+		for (int inst_i = 0; inst_i < modules_p.size(); ++inst_i) {
+			converters.emplace_back([inst_i, &converted]() {
+				converted[inst_i] = modules_p[inst_i]->convertTrace();
+			});
+		}
+		for (auto &converter : converters) converter.join();
+		for (mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+			for (auto &source : modules_sources[mod_i]) {
+				int inst_i = std::find(modules_p.begin(), modules_p.end(), source.mod) - modules_p.begin();
+				if (converted[inst_i]) continue;
+				std::cerr << "Module " << modules_load_list[mod_i] << " could not convert its trace" << std::endl;
+				exitHandler(-1);
+			}
+		}
+	}
+
 	// START ALL MODULES
 
-	int mod_i = -1;
-	for (auto &mod : modules_p) {
-		++mod_i;
-		param_t par = modules_param;
-		par.options = modules_options_list[mod_i];
-		mod->setParameters(par);
-		mod->startMon();
+	for (int inst_i = 0; !convert_mode && inst_i < modules_p.size(); ++inst_i) {
+		int64_t start_cpu = threadCpuNs();
+		modules_p[inst_i]->startMon();
+		// threads and processes started by the module belong to it
+		if (overhead_monitor != nullptr) {
+			overhead_monitor->addCallbackCpu(modules_overhead_parts[inst_i], threadCpuNs() - start_cpu);
+			overhead_monitor->claimTasks(modules_overhead_parts[inst_i]);
+		}
 	}
 
-	// PRINT ALL ROW NAMES and get pointer to values and values_m
-	mod_i = -1;
-	for (auto &mod : modules_p) {
-		++mod_i;
-		// get pointers
-		modules_values_mp.push_back(mod->getValuesMPtr());
-		modules_values_p.push_back(mod->getValuesPtr());
-		// push an entry for the module to modules_columns_indices
-		modules_columns_indices.push_back(std::vector<int>());
+	// start the writer thread
+	if (!flush_policy_set) {
+		outputWriter::parsePolicy(isatty(output_fd) ? "row" : "size=65536,time=1000", flush_policy);
+	}
+	// conversion waits for the output instead of dropping rows
+	output_writer = new outputWriter(output_fd, queue_rows, flush_policy, convert_mode);
+	if (overhead_monitor != nullptr) {
+		writer_part = overhead_monitor->addPart("writer");
+		overhead_monitor->claimTasks(writer_part);
+		// sources in the order of the rows (module, target)
+		for (mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+			for (auto &source : modules_sources[mod_i]) {
+				int inst_i = std::find(modules_p.begin(), modules_p.end(), source.mod) - modules_p.begin();
+				overhead_monitor->addSource(mod_i, modules_overhead_parts[inst_i], source.buffer);
+			}
+		}
+	}
+
+	// COLLECT ALL COLUMN NAMES
+	std::vector<std::vector<column_t>> modules_columns;
+	for (mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+		module* mod = modules_sources[mod_i][0].mod;
+		modules_columns.push_back(std::vector<column_t>());
+		// column types
+		modules_columns_types.push_back(mod->getColTypes());
+		std::vector<std::string> labels = mod->getLabels();
+		if (modules_columns_types[mod_i].size() != labels.size() || labels.size() > SAMPLE_MAX_FIELDS) {
+			std::cerr << "Module " << modules_load_list[mod_i] << " provides an invalid column schema" << std::endl;
+			exitHandler(-1);
+		}
 		// row names
 		std::vector<int> colmaxsize = mod->getColMaxSize();
 		int col_i = -1;
-		for (auto &col_label : mod->getLabels()) {
+		for (auto &col_label : labels) {
 			++col_i;
 
-			// if there is a list of columns for this module, only show those in the list
-			if (!modules_columns_list[mod_i].empty() &&
-					std::find(modules_columns_list[mod_i].begin(),
-					modules_columns_list[mod_i].end(), col_label) == modules_columns_list[mod_i].end()) {
+			// only the requested columns
+			if (std::find(modules_columns_indices[mod_i].begin(), modules_columns_indices[mod_i].end(),
+					col_i) == modules_columns_indices[mod_i].end()) {
 				continue;
 			}
 
-			// save index of this column to modules_columns_indices
-			modules_columns_indices[mod_i].push_back(col_i);
+			column_t column;
+			column.prefix = modules_prefix_list[mod_i].substr(0, modules_prefix_list[mod_i].size() - 1);
+			column.label = col_label;
+			column.type = modules_columns_types[mod_i][col_i];
 
-			// prefix the col_label
+			// col width should be the greater one of colmaxsize+1 and prefixed label size +1
 			std::string col_label_prefixed = modules_prefix_list[mod_i] + col_label;
+			int max_size = colmaxsize[col_i];
+			// decimal places of time stamps
+			if (column.type == FIELD_TIME && time_precision > 0) max_size += 1 + time_precision;
+			if (col_label_prefixed.size() >= max_size)
+				column.width = col_label_prefixed.size() + 1;
+			else column.width = max_size + 1;
 
-			// col width should be the greater one of colmaxsize+1 and label size +1
-			int col_width_temp;
-			if (col_label_prefixed.size() >= colmaxsize[col_i])
-				col_width_temp = col_label_prefixed.size() + 1;
-			else col_width_temp = colmaxsize[col_i] + 1;
-			*out << std::setw(col_width_temp) << std::left << col_label_prefixed;
-
-			// save col width to columns_width
-			columns_width.push_back(col_width_temp);
+			modules_columns[mod_i].push_back(column);
 
 		}
 	}
-	*out << std::endl;
 
-	// COLLECT ALL OUTPUTS
+	// statistics columns instead of the values, one cursor per module and target
+	if (aggregate) {
+		aggregator = new windowAggregator(aggregate_percentiles);
+		for (mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+			for (auto &source : modules_sources[mod_i]) {
+				aggregator->addSource(source.buffer, modules_columns_types[mod_i], modules_columns_indices[mod_i], convert_mode);
+			}
+			modules_columns[mod_i] = aggregator->expandColumns(modules_columns[mod_i]);
+		}
+	}
 
-	// iterate through module outputs and print data
-	std::mutex* mt_values_mp;
-	std::vector<std::vector < std::string>>*mt_values_p;
-	while (true) {
+	// overhead of every module instance after its columns
+	if (overhead_columns) {
+		for (mod_i = 0; mod_i < modules_columns.size(); ++mod_i) {
+			std::string prefix = modules_prefix_list[mod_i].substr(0, modules_prefix_list[mod_i].size() - 1);
+			for (auto &self_column : std::vector<std::pair<const char*, field_type_t>>{
+					{"self.cpu", FIELD_DOUBLE}, {"self.samples", FIELD_INT64}, {"self.latency", FIELD_INT64}}) {
+				column_t column;
+				column.prefix = prefix;
+				column.label = self_column.first;
+				column.type = self_column.second;
+				column.width = std::max(prefix.size() + 1 + column.label.size() + 1, (size_t) 12);
+				modules_columns[mod_i].push_back(column);
+			}
+		}
+	}
 
-		// sleep for microseconds, if -I option is provided
-		if (modules_param.interval_micro > 0) {
-			usleep(modules_param.interval_micro);
-		} else {
-			sleep(modules_param.interval);
+	// columns of the targets
+	if (multi_target && !wide_rows) {
+		column_t column;
+		column.prefix = "promoris";
+		column.label = "pid";
+		column.type = FIELD_INT64;
+		column.width = 13;
+		output_columns.push_back(column);
+	}
+	for (int target_i = 0; target_i < (wide_rows ? targets.size() : 1); ++target_i) {
+		for (auto &columns : modules_columns) {
+			for (auto column : columns) {
+				if (multi_target && wide_rows) {
+					column.prefix += "@" + std::to_string(targets[target_i]);
+					column.width += 1 + std::to_string(targets[target_i]).size();
+				}
+				output_columns.push_back(column);
+			}
 		}
+	}
 
-		// check if process is still running, if not, terminate program
-		if (exec_mode) {
-			int exec_status;
-			pid_t tpid = waitpid(modules_param.pid_struct, &exec_status, WNOHANG);
-			if (tpid == modules_param.pid_struct) {
-				exitHandler(0);
+	// cursors of the alternative alignment, one per module and target
+	if (alternative_alignment) {
+		alignment_engine = new alignmentEngine(alignment_policy);
+		for (mod_i = 0; mod_i < modules_sources.size(); ++mod_i) {
+			// unrequested fields of projecting modules are undefined, they are copied instead of interpolated
+			std::vector<field_type_t> align_types = modules_columns_types[mod_i];
+			if (modules_sources[mod_i][0].mod->projection()) {
+				for (int col_i = 0; col_i < align_types.size(); ++col_i) {
+					if (std::find(modules_columns_indices[mod_i].begin(), modules_columns_indices[mod_i].end(),
+							col_i) == modules_columns_indices[mod_i].end()) {
+						align_types[col_i] = FIELD_STRING;
+					}
+				}
+			}
+			for (auto &source : modules_sources[mod_i]) {
+				alignment_engine->addModule(source.buffer, align_types);
 			}
 		}
+	}
 
-		// create the row
-		// alternative alignment when -a option present
-		std::vector<std::string> current_row;
-		if(alternative_alignment) current_row = createRowAlt();
-		else current_row = createRow();
+	// diagnostic columns of the main loop
+	if (tick_diagnostics) {
+		for (auto diag_label : {"tick", "drift", "jitter", "missed"}) {
+			column_t column;
+			column.prefix = "promoris";
+			column.label = diag_label;
+			column.type = FIELD_INT64;
+			column.width = 16;
+			output_columns.push_back(column);
+		}
+	}
 
-		// print the row
-		for (int i = 0; i < current_row.size(); ++i) {
-			*out << std::setw(columns_width[i]) << std::left << current_row[i];
+	// overhead columns of the main loop and the output
+	if (overhead_columns) {
+		for (auto overhead_label : {"cpu", "writer_cpu", "row_ns", "out_bytes", "flush_ns"}) {
+			column_t column;
+			column.prefix = "promoris";
+			column.label = overhead_label;
+			column.type = (strcmp(overhead_label, "cpu") == 0 || strcmp(overhead_label, "writer_cpu") == 0) ? FIELD_DOUBLE : FIELD_INT64;
+			column.width = 20;
+			output_columns.push_back(column);
 		}
-		*out << std::endl;
+	}
 
+	// change-based suppression, time stamps, the columns of ProMoRIS and the overhead are always printed
+	if (suppress_unchanged) {
+		std::vector<epsilon_t> epsilons(output_columns.size(), default_epsilon);
+		std::vector<bool> compared(output_columns.size());
+		for (int col_i = 0; col_i < output_columns.size(); ++col_i) {
+			compared[col_i] = output_columns[col_i].type != FIELD_TIME && output_columns[col_i].prefix != "promoris" &&
+					output_columns[col_i].label.compare(0, 5, "self.") != 0;
+		}
+		// COLUMN is a label (all modules and targets) or PREFIX:LABEL
+		for (auto &column_epsilon : column_epsilons) {
+			bool found = false;
+			for (int col_i = 0; col_i < output_columns.size(); ++col_i) {
+				if (column_epsilon.first == output_columns[col_i].label ||
+						column_epsilon.first == output_columns[col_i].prefix + ":" + output_columns[col_i].label) {
+					epsilons[col_i] = column_epsilon.second;
+					found = true;
+				}
+			}
+			if (!found) {
+				std::cerr << "Epsilon for unknown column " << column_epsilon.first << std::endl;
+				exitHandler(-1);
+			}
+		}
+		// rows are created with some jitter, heartbeats are due half an interval early so they are not delayed by a whole one
+		int64_t interval_ns = modules_param.interval_micro > 0 ? modules_param.interval_micro * 1000LL : modules_param.interval * 1000000000LL;
+		if (heartbeat_ns > 0) heartbeat_ns = std::max(heartbeat_ns - interval_ns / 2, (int64_t) 1);
+		change_filter = new changeFilter(epsilons, compared, heartbeat_ns);
+	}
+
+	// PRINT ALL ROW NAMES
+	output_encoder = rowEncoder::create(output_format, output_writer, output_columns);
+	if (output_encoder == nullptr) {
+		std::cerr << "Unknown output format " << output_format << std::endl;
+		exitHandler(-1);
+	}
+	time_format_t time_format;
+	// converted samples have UNIX time stamps
+	time_format.wall_offset_ns = convert_mode ? 0 : wallClockOffsetNs();
+	time_format.precision = time_precision;
+	output_encoder->setTimeFormat(time_format);
+	output_encoder->header();
+
+	// COLLECT ALL OUTPUTS
+
+	if (convert_mode) {
+		convertRows();
+		exitHandler(0);
+	}
+
+	// rows are created on a fixed grid of deadlines, -I option takes precedence
+	if (modules_param.interval_micro > 0) {
+		tick_scheduler = new tickScheduler(modules_param.interval_micro * 1000LL);
+	} else {
+		tick_scheduler = new tickScheduler(modules_param.interval * 1000000000LL);
 	}
 
+	// create the rows on every deadline, the modules are served by the same event loop
+	reactor->addTimer(tick_scheduler->first(), tick_scheduler->interval(), createRows);
+	reactor->run();
+
+	exitHandler(-1);
+
+	return 1;
+
 }
@@ -22,9 +22,25 @@
 
 #include <cstdlib>
 #include <string>
+#include "module.h"
 
 //using namespace std;
 
+// one cell of an output row
+// values stay typed until the row is printed
+typedef struct cell_t {
+	field_type_t type;
+	// no value available for this cell
+	bool empty;
+	field_t value;
+} cell_t;
+
+// source of samples: a module instance and the buffer of one of its targets
+typedef struct source_t {
+	module* mod;
+	sampleBuffer* buffer;
+} source_t;
+
 
 #endif /* MAIN_H */
 
@@ -24,16 +24,81 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <cstdint>
+#include <ctime>
 #include <unistd.h>
+#include "samplebuffer.h"
+#include "reactor.h"
+
+// version of the module interface
+// modules return it via getApiVersion, ProMoRIS refuses to load modules built for another version
+#define MODULE_API_VERSION 10
+
+// maximum number of columns a module can provide
+#define SAMPLE_MAX_FIELDS 16
 
 typedef struct param_t {
+	// first (or only) process to be monitored
 	std::string pid;
 	pid_t pid_struct;
+	// all processes to be monitored by this instance
+	// one PID for regular modules, all targets of ProMoRIS for batched modules
+	std::vector<pid_t> targets;
 	int interval;
 	int interval_micro;
+	// capacity of the sample buffer of the module
+	int buffer_size;
 	std::vector<std::string> options;
+	// indices (into getLabels()) of the columns printed by ProMoRIS in ascending order,
+	// modules supporting projection() only need to acquire these
+	std::vector<int> columns;
+	// event loop of ProMoRIS for registering file descriptors, timers and processes
+	eventReactor* reactor;
+	// replay the trace (TRACEFILE option) instead of running the tool if >= 0:
+	// 1 original timing, 2 twice as fast (ProMoRIS only passes speeds greater than 0)
+	// modules without traces ignore it
+	double replay_speed;
 } param_t;
 
+// type of a column provided by a module
+typedef enum field_type_t {
+	// time stamp of the sample, taken from sample_t::time (the field itself is unused)
+	FIELD_TIME,
+	FIELD_INT64,
+	FIELD_DOUBLE,
+	// pointer to a null-terminated string owned by the module
+	// the string must stay valid as long as the module is loaded
+	FIELD_STRING
+} field_type_t;
+
+typedef union field_t {
+	int64_t i;
+	double d;
+	const char* s;
+} field_t;
+
+// one fixed-width record of values published by a module
+// fields[i] holds the value of column i, interpreted according to getColTypes()[i]
+typedef struct sample_t {
+	int64_t time;
+	field_t fields[SAMPLE_MAX_FIELDS];
+} sample_t;
+
+// transports the samples from the module thread to the main loop
+typedef ringBuffer<sample_t> sampleBuffer;
+
+// units of sample_t::time per second
+#define SAMPLE_TIME_PER_SECOND 1000000000LL
+
+// time stamp to be saved in sample_t::time: CLOCK_MONOTONIC in nanoseconds
+// should be taken right before or after reading the values of the sample
+// ProMoRIS maps it to wall-clock time once at startup for the output
+inline int64_t sampleTime() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<int64_t> (ts.tv_sec) * SAMPLE_TIME_PER_SECOND + ts.tv_nsec;
+}
+
 class module {
 public:
 	module() {}
@@ -42,15 +107,42 @@ public:
 	virtual int startMon() = 0;
 	virtual int stopMon() = 0;
 	virtual bool running() = 0;
-	virtual std::vector<std::vector<std::string>> * getValuesPtr() = 0;
-	virtual std::mutex * getValuesMPtr() = 0;
+	virtual sampleBuffer * getBuffer() = 0;
 	virtual std::vector<std::string> getLabels() = 0;
+	virtual std::vector<field_type_t> getColTypes() = 0;
 	virtual std::vector<int> getColMaxSize() = 0;
+	// batched modules sample all param_t::targets in one pass and publish
+	// the samples of every target to its own buffer,
+	// for other modules one instance is created per target
+	virtual bool batched() {
+		return false;
+	}
+	// buffer of target target_i (index into param_t::targets) of a batched module
+	virtual sampleBuffer * getTargetBuffer(int target_i) {
+		return getBuffer();
+	}
+	// true if the module only fills the fields of param_t::columns in its samples,
+	// the other fields are undefined and never read by ProMoRIS
+	virtual bool projection() {
+		return false;
+	}
+	// offline conversion (promoris --convert): parse the complete trace of the module (TRACEFILE option)
+	// into its buffers instead of starting the tool, with the time stamps of the trace in UNIX time (ns)
+	// the buffers are resized to hold all samples, every instance is converted in a thread of its own
+	// returns false if the module has no traces or the trace cannot be read
+	virtual bool convertTrace() {
+		return false;
+	}
 	
 };
 
+// every call of createMod must return a new, independent instance,
+// so a module can be loaded several times (e.g. for several targets)
+// destroyMod is called with every instance when ProMoRIS terminates
+// modules must therefore not keep any state in static or global variables
 typedef module* createMod_t();
-typedef void destroyMod_t();
+typedef void destroyMod_t(module*);
 typedef const char* getHelp_t();
+typedef int getApiVersion_t();
 
 #endif /* MODULE_H */
@@ -35,7 +35,18 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/main.o
+	${OBJECTDIR}/aggregator.o \
+	${OBJECTDIR}/alignment.o \
+	${OBJECTDIR}/binlog.o \
+	${OBJECTDIR}/changefilter.o \
+	${OBJECTDIR}/encoder.o \
+	${OBJECTDIR}/epollreactor.o \
+	${OBJECTDIR}/main.o \
+	${OBJECTDIR}/overhead.o \
+	${OBJECTDIR}/responder.o \
+	${OBJECTDIR}/scheduler.o \
+	${OBJECTDIR}/targets.o \
+	${OBJECTDIR}/writer.o
 
 
 # C Compiler Flags
@@ -62,10 +73,65 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/promoris: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/promoris ${OBJECTFILES} ${LDLIBSOPTIONS} -ldl -rdynamic
 
+${OBJECTDIR}/aggregator.o: aggregator.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/aggregator.o aggregator.cpp
+
+${OBJECTDIR}/alignment.o: alignment.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/alignment.o alignment.cpp
+
+${OBJECTDIR}/binlog.o: binlog.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/binlog.o binlog.cpp
+
+${OBJECTDIR}/changefilter.o: changefilter.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/changefilter.o changefilter.cpp
+
+${OBJECTDIR}/encoder.o: encoder.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/encoder.o encoder.cpp
+
+${OBJECTDIR}/epollreactor.o: epollreactor.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/epollreactor.o epollreactor.cpp
+
 ${OBJECTDIR}/main.o: main.cpp
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
-	$(COMPILE.cc) -g -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+
+${OBJECTDIR}/overhead.o: overhead.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/overhead.o overhead.cpp
+
+${OBJECTDIR}/responder.o: responder.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/responder.o responder.cpp
+
+${OBJECTDIR}/scheduler.o: scheduler.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/scheduler.o scheduler.cpp
+
+${OBJECTDIR}/targets.o: targets.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/targets.o targets.cpp
+
+${OBJECTDIR}/writer.o: writer.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/writer.o writer.cpp
 
 # Subprojects
 .build-subprojects:
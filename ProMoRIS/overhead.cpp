@@ -0,0 +1,276 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "overhead.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <ctime>
+#include <dirent.h>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sys/syscall.h>
+#include "scheduler.h"
+
+// clock of another thread of this process (the encoding used by pthread_getcpuclockid)
+#define THREAD_CPUCLOCK(tid) ((~static_cast<clockid_t> (tid) << 3) | 6)
+// part of tasks appearing after the start of all parts
+#define PART_OTHER -2
+
+int64_t threadCpuNs() {
+	timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return static_cast<int64_t> (ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// PIDs listed in a children file of /proc
+static std::vector<pid_t> readChildren(const std::string& path) {
+	std::vector<pid_t> children;
+	std::ifstream file(path);
+	pid_t pid;
+	while (file >> pid) children.push_back(pid);
+	return children;
+}
+
+overheadMonitor::overheadMonitor() : other_part(-1), last_scan_ns(0) {
+	start_ns = window_start_ns = monotonicNs();
+	window_ns = 0;
+	addPart("promoris");
+	addTask(syscall(SYS_gettid), false, 0);
+}
+
+int overheadMonitor::addPart(const std::string& name) {
+	parts.push_back({name, 0, 0, 0, 0});
+	return parts.size() - 1;
+}
+
+void overheadMonitor::addTask(pid_t id, bool process, int part) {
+	if (part == PART_OTHER) {
+		if (other_part < 0) other_part = addPart("other");
+		part = other_part;
+	}
+	task_t task;
+	task.part = part;
+	task.process = process;
+	task.last_ns = 0;
+	if (process) {
+		if (clock_getcpuclockid(id, &task.clock) != 0) task.part = -1;
+	} else {
+		task.clock = THREAD_CPUCLOCK(id);
+	}
+	tasks[id] = task;
+}
+
+void overheadMonitor::claimTasks(int part) {
+	scanTasks(part);
+}
+
+void overheadMonitor::scanTasks(int part) {
+	last_scan_ns = monotonicNs();
+
+	// threads of ProMoRIS and their children
+	DIR* dir = opendir("/proc/self/task");
+	if (dir == nullptr) return;
+	std::vector<pid_t> tids;
+	while (dirent* entry = readdir(dir)) {
+		if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+		tids.push_back(atoi(entry->d_name));
+	}
+	closedir(dir);
+	for (pid_t tid : tids) {
+		if (tasks.find(tid) == tasks.end()) addTask(tid, false, part);
+		for (pid_t child : readChildren("/proc/self/task/" + std::to_string(tid) + "/children")) {
+			if (tasks.find(child) == tasks.end()) addTask(child, true, part);
+		}
+	}
+
+	// descendants belong to the part of their ancestor, ignored processes are not followed
+	std::vector<pid_t> processes;
+	for (auto &entry : tasks) {
+		if (entry.second.process && entry.second.part >= 0) processes.push_back(entry.first);
+	}
+	while (!processes.empty()) {
+		pid_t pid = processes.back();
+		processes.pop_back();
+		int parent_part = tasks[pid].part;
+		for (pid_t child : readChildren("/proc/" + std::to_string(pid) + "/task/" + std::to_string(pid) + "/children")) {
+			if (tasks.find(child) != tasks.end()) continue;
+			addTask(child, true, parent_part);
+			processes.push_back(child);
+		}
+	}
+}
+
+void overheadMonitor::addCallbackCpu(int part, int64_t ns) {
+	parts[part].callback_ns += ns;
+	parts[0].callback_ns -= ns;
+}
+
+int overheadMonitor::addSource(int mod_i, int part, sampleBuffer* buffer) {
+	source_stats_t source;
+	source.mod_i = mod_i;
+	source.part = part;
+	source.buffer = buffer;
+	source.window_start = buffer->end();
+	source.window_samples = 0;
+	source.emitted = 0;
+	source.overwritten = 0;
+	source.last_sample_time = INT64_MIN;
+	source.last_latency = -1;
+	sources.push_back(source);
+	latency_sketches[mod_i];
+	latency_max[mod_i] = 0;
+	return sources.size() - 1;
+}
+
+void overheadMonitor::sampleEmitted(int source_i, int64_t sample_time, int64_t row_time, uint64_t samples) {
+	source_stats_t& source = sources[source_i];
+	if (sample_time != source.last_sample_time) source.emitted += samples;
+	source.last_sample_time = sample_time;
+	source.last_latency = row_time - sample_time;
+	latency_sketches[source.mod_i].add(static_cast<double> (source.last_latency));
+	latency_max[source.mod_i] = std::max(latency_max[source.mod_i], source.last_latency);
+}
+
+int64_t overheadMonitor::readCpu(task_t& task) {
+	timespec ts;
+	if (clock_gettime(task.clock, &ts) != 0) return -1;
+	task.last_ns = static_cast<int64_t> (ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+	return task.last_ns;
+}
+
+void overheadMonitor::tick(int64_t now) {
+	if (now - last_scan_ns >= OVERHEAD_SCAN_NS) scanTasks(PART_OTHER);
+
+	std::vector<int64_t> cpu(parts.size());
+	for (size_t part_i = 0; part_i < parts.size(); ++part_i) {
+		cpu[part_i] = parts[part_i].exited_ns + parts[part_i].callback_ns;
+	}
+	for (auto entry = tasks.begin(); entry != tasks.end();) {
+		task_t& task = entry->second;
+		if (task.part < 0) {
+			++entry;
+			continue;
+		}
+		if (readCpu(task) < 0) {
+			// terminated, its last known time stays with the part
+			parts[task.part].exited_ns += task.last_ns;
+			cpu[task.part] += task.last_ns;
+			entry = tasks.erase(entry);
+			continue;
+		}
+		cpu[task.part] += task.last_ns;
+		++entry;
+	}
+	for (size_t part_i = 0; part_i < parts.size(); ++part_i) {
+		parts[part_i].window_cpu_ns = cpu[part_i] - parts[part_i].cpu_ns;
+		parts[part_i].cpu_ns = cpu[part_i];
+	}
+
+	for (auto &source : sources) {
+		uint64_t end = source.buffer->end();
+		source.window_samples = end - source.window_start;
+		source.window_start = end;
+	}
+	window_ns = now - window_start_ns;
+	window_start_ns = now;
+}
+
+double overheadMonitor::windowCpu(int part) const {
+	if (window_ns <= 0) return 0.0;
+	return 100.0 * parts[part].window_cpu_ns / window_ns;
+}
+
+int64_t overheadMonitor::windowSamples(int source_i) const {
+	return sources[source_i].window_samples;
+}
+
+void overheadMonitor::summary(std::ostream& out, const std::vector<std::string>& module_names,
+		uint64_t output_bytes, int64_t flush_ns, uint64_t flushes, uint64_t dropped_rows) {
+	int64_t now = monotonicNs();
+	tick(now);
+	double run_s = static_cast<double> (now - start_ns) / 1000000000.0;
+
+	out << std::fixed << std::setprecision(3);
+	out << "Overhead of ProMoRIS during " << run_s << " s\n";
+	out << std::left << std::setw(24) << "PART" << std::right << std::setw(12) << "CPU_S" << std::setw(10) << "CPU_%" << "\n";
+	for (auto &part : parts) {
+		double cpu_s = static_cast<double> (part.cpu_ns) / 1000000000.0;
+		out << std::left << std::setw(24) << part.name << std::right << std::setw(12) << cpu_s
+				<< std::setw(10) << (run_s > 0 ? 100.0 * cpu_s / run_s : 0.0) << "\n";
+	}
+
+	out << std::left << std::setw(24) << "MODULE" << std::right << std::setw(12) << "PUBLISHED" << std::setw(12) << "PRINTED"
+			<< std::setw(12) << "OVERWRITTEN" << std::setw(14) << "LAT_P50_US" << std::setw(14) << "LAT_P99_US"
+			<< std::setw(14) << "LAT_MAX_US" << "\n";
+	for (auto &sketch : latency_sketches) {
+		uint64_t published = 0, printed = 0, overwritten = 0;
+		for (auto &source : sources) {
+			if (source.mod_i != sketch.first) continue;
+			published += source.buffer->end();
+			printed += source.emitted;
+			overwritten += source.overwritten;
+		}
+		out << std::left << std::setw(24) << module_names[sketch.first] << std::right << std::setw(12) << published
+				<< std::setw(12) << printed << std::setw(12) << overwritten;
+		if (sketch.second.count() > 0) {
+			out << std::setw(14) << sketch.second.quantile(0.5) / 1000.0 << std::setw(14) << sketch.second.quantile(0.99) / 1000.0
+					<< std::setw(14) << latency_max[sketch.first] / 1000.0;
+		}
+		out << "\n";
+	}
+
+	if (row_sketch.count() > 0) {
+		out << "Rows: " << row_sketch.count() << " ticks, created in p50 " << row_sketch.quantile(0.5) / 1000.0
+				<< " us, p99 " << row_sketch.quantile(0.99) / 1000.0 << " us\n";
+	}
+	out << "Output: " << output_bytes << " bytes in " << flushes << " writes, "
+			<< flush_ns / 1000000.0 << " ms writing, " << dropped_rows << " rows dropped" << std::endl;
+}
+
+// wrap a callback, so its CPU time is charged to part
+template<typename F>
+static F account(overheadMonitor* monitor, int part, F callback) {
+	return [monitor, part, callback](auto... args) {
+		int64_t start = threadCpuNs();
+		callback(args...);
+		monitor->addCallbackCpu(part, threadCpuNs() - start);
+	};
+}
+
+int accountingReactor::addLines(int fd, lineCallback_t on_line, closeCallback_t on_close) {
+	return reactor->addLines(fd, account(monitor, part, on_line), on_close ? account(monitor, part, on_close) : on_close);
+}
+
+int accountingReactor::addTimer(int64_t first_ns, int64_t interval_ns, timerCallback_t on_timer) {
+	return reactor->addTimer(first_ns, interval_ns, account(monitor, part, on_timer));
+}
+
+int accountingReactor::addProcess(pid_t pid, processCallback_t on_exit) {
+	return reactor->addProcess(pid, account(monitor, part, on_exit));
+}
+
+int accountingReactor::addSignal(int signum, signalCallback_t on_signal) {
+	return reactor->addSignal(signum, account(monitor, part, on_signal));
+}
+
+int accountingReactor::addReadable(int fd, readableCallback_t on_readable) {
+	return reactor->addReadable(fd, account(monitor, part, on_readable));
+}
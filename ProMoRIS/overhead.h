@@ -0,0 +1,156 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OVERHEAD_H
+#define OVERHEAD_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "module.h"
+#include "reactor.h"
+#include "aggregator.h"
+
+// the threads and child processes are listed again at most every OVERHEAD_SCAN_NS
+#define OVERHEAD_SCAN_NS 1000000000LL
+
+// CPU time of the calling thread in nanoseconds
+int64_t threadCpuNs();
+
+/*
+ * Self-overhead instrumentation: accounts the CPU time of the parts of ProMoRIS
+ * (main loop, writer thread, every module instance) and the way of the samples
+ * of every source (module and target) to the output.
+ *
+ * The CPU time of a part is the time of its threads and child processes (including their
+ * descendants) plus the time of its callbacks on the main loop (see accountingReactor).
+ * Threads and processes belong to the part which was started when they appeared
+ * (claimTasks), later ones are accounted as "other". The main loop is charged with the
+ * time of the main thread not spent in module callbacks.
+ */
+class overheadMonitor {
+public:
+	// part 0 is the main loop with the calling thread
+	overheadMonitor();
+	// new part, returns its index
+	int addPart(const std::string& name);
+	// attribute all threads and child processes which are not known yet to part (-1: ignore them)
+	void claimTasks(int part);
+	// CPU time of a main loop callback of part, moved from the main loop to part
+	void addCallbackCpu(int part, int64_t ns);
+	// source of samples of module mod_i (index of the loaded module) served by part
+	int addSource(int mod_i, int part, sampleBuffer* buffer);
+
+	// samples of source up to the one taken at sample_time were printed in a row at row_time
+	// (a sample printed again in the next row is only counted once)
+	void sampleEmitted(int source_i, int64_t sample_time, int64_t row_time, uint64_t samples = 1);
+	// a sample was overwritten while it was read for a row
+	void sampleOverwritten(int source_i) {
+		++sources[source_i].overwritten;
+	}
+	// time needed to create the rows of a tick
+	void rowsCreated(int64_t ns) {
+		row_sketch.add(static_cast<double> (ns));
+	}
+
+	// update the CPU times and start a new window, called once per tick
+	void tick(int64_t now);
+	// CPU of part in the last window in % of one core
+	double windowCpu(int part) const;
+	// samples published by source in the last window
+	int64_t windowSamples(int source_i) const;
+	// latency of the latest sample of source printed (ns), -1 if none
+	int64_t lastLatency(int source_i) const {
+		return sources[source_i].last_latency;
+	}
+	int sourcePart(int source_i) const {
+		return sources[source_i].part;
+	}
+
+	// print the totals of the run
+	void summary(std::ostream& out, const std::vector<std::string>& module_names,
+			uint64_t output_bytes, int64_t flush_ns, uint64_t flushes, uint64_t dropped_rows);
+private:
+	typedef struct part_t {
+		std::string name;
+		// threads and processes which terminated
+		int64_t exited_ns;
+		int64_t callback_ns;
+		int64_t cpu_ns;
+		int64_t window_cpu_ns;
+	} part_t;
+	typedef struct task_t {
+		int part;
+		bool process;
+		clockid_t clock;
+		int64_t last_ns;
+	} task_t;
+	typedef struct source_stats_t {
+		int mod_i;
+		int part;
+		sampleBuffer* buffer;
+		uint64_t window_start;
+		uint64_t window_samples;
+		uint64_t emitted;
+		uint64_t overwritten;
+		int64_t last_sample_time;
+		int64_t last_latency;
+	} source_stats_t;
+	std::vector<part_t> parts;
+	std::map<pid_t, task_t> tasks;
+	std::vector<source_stats_t> sources;
+	// latencies per loaded module
+	std::map<int, quantileSketch> latency_sketches;
+	std::map<int, int64_t> latency_max;
+	quantileSketch row_sketch;
+	int other_part;
+	int64_t start_ns;
+	int64_t window_start_ns;
+	int64_t window_ns;
+	int64_t last_scan_ns;
+	void scanTasks(int part);
+	void addTask(pid_t id, bool process, int part);
+	int64_t readCpu(task_t& task);
+};
+
+/*
+ * eventReactor passed to a module instead of the main loop when the overhead is accounted:
+ * forwards everything to the main loop and charges the CPU time of the callbacks to the part of the module.
+ */
+class accountingReactor : public eventReactor {
+public:
+	accountingReactor(eventReactor* reactor, overheadMonitor* monitor, int part) :
+	reactor(reactor), monitor(monitor), part(part) {}
+	int addLines(int fd, lineCallback_t on_line, closeCallback_t on_close);
+	int addTimer(int64_t first_ns, int64_t interval_ns, timerCallback_t on_timer);
+	int addProcess(pid_t pid, processCallback_t on_exit);
+	int addSignal(int signum, signalCallback_t on_signal);
+	void remove(int id) {
+		reactor->remove(id);
+	}
+	int addReadable(int fd, readableCallback_t on_readable);
+private:
+	eventReactor* reactor;
+	overheadMonitor* monitor;
+	int part;
+};
+
+#endif /* OVERHEAD_H */
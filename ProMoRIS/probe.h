@@ -0,0 +1,58 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PROBE_H
+#define PROBE_H
+
+#include <cstdint>
+
+/*
+ * Protocol between the throughput probe module (modProbe) and the responder mode of
+ * ProMoRIS (promoris -R). Both sides must be built from the same version.
+ *
+ * TCP: the probe sends a stream of bytes which the responder discards, the rate, RTT
+ * and retransmissions are read from TCP_INFO on the sending side.
+ * UDP: every datagram starts with a probe_header_t. The responder sends the header of
+ * every received datagram back to its sender, which derives the delivered rate,
+ * the loss, the RTT and the jitter from these echoes.
+ */
+
+// default port of the responder (TCP and UDP)
+#define PROBE_DEFAULT_PORT 5301
+
+// identifies datagrams of the probe
+#define PROBE_MAGIC 0x50524f42
+
+// number of datagrams sent or received with one sendmmsg / recvmmsg call
+#define PROBE_BATCH 32
+
+typedef struct probe_header_t {
+	uint32_t magic;
+	// number of the parallel stream
+	uint32_t stream;
+	// sequence number of the datagram within its stream
+	uint64_t seq;
+	// CLOCK_MONOTONIC of the sender when the datagram was sent
+	int64_t send_ns;
+	// size of the complete datagram in bytes
+	uint32_t length;
+	uint32_t reserved;
+} probe_header_t;
+
+#endif /* PROBE_H */
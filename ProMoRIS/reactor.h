@@ -0,0 +1,112 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+
+// called with every complete line read from a file descriptor (without the line break)
+typedef std::function<void(const char* line)> lineCallback_t;
+// called when a file descriptor reached the end of file or failed
+typedef std::function<void()> closeCallback_t;
+// called when a timer expired, with the number of expirations since the last call
+typedef std::function<void(uint64_t expirations)> timerCallback_t;
+// called once when a process terminated (the process is not reaped)
+typedef std::function<void(pid_t pid)> processCallback_t;
+// called when a signal was received
+typedef std::function<void(int signum)> signalCallback_t;
+// called when a file descriptor can be read without blocking
+typedef std::function<void()> readableCallback_t;
+
+/*
+ * Event loop of ProMoRIS (epoll), passed to the modules in param_t::reactor.
+ * Modules register their data sources in startMon and remove them in stopMon,
+ * instead of starting a thread per data source. All callbacks run on the thread of the
+ * main loop, so they must not block; every method must only be called from this
+ * thread (module methods are called from it).
+ * The add methods return an id for remove(), or -1 on errors.
+ */
+class eventReactor {
+public:
+	virtual ~eventReactor() {}
+	// read lines from fd (set to non-blocking), the source is removed after on_close
+	// fd stays owned by the caller
+	virtual int addLines(int fd, lineCallback_t on_line, closeCallback_t on_close) = 0;
+	// timer on CLOCK_MONOTONIC expiring at first_ns and then every interval_ns
+	virtual int addTimer(int64_t first_ns, int64_t interval_ns, timerCallback_t on_timer) = 0;
+	// notify once when process pid terminated, the source is removed afterwards
+	virtual int addProcess(pid_t pid, processCallback_t on_exit) = 0;
+	// receive signum synchronously, it is blocked for the normal signal delivery
+	virtual int addSignal(int signum, signalCallback_t on_signal) = 0;
+	// remove a source, may be called from its own callback
+	virtual void remove(int id) = 0;
+	// notify while fd can be read (level-triggered), for sockets which are not line based
+	// fd stays owned by the caller, remove the source before closing it
+	virtual int addReadable(int fd, readableCallback_t on_readable) = 0;
+};
+
+// start a program (searched in PATH) in its own process group, its stdout can be read
+// from the returned file descriptor (-1 on errors)
+// argv must be terminated by nullptr
+// stop it with kill(-pid, SIGTERM) and waitpid(pid)
+inline int spawnProcess(const char* const argv[], pid_t& pid) {
+	int pipe_fd[2];
+	if (pipe2(pipe_fd, O_CLOEXEC) != 0) return -1;
+
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_adddup2(&actions, pipe_fd[1], STDOUT_FILENO);
+
+	// signals blocked for the reactor must not stay blocked in the program
+	posix_spawnattr_t attr;
+	posix_spawnattr_init(&attr);
+	sigset_t mask;
+	sigemptyset(&mask);
+	posix_spawnattr_setsigmask(&attr, &mask);
+	posix_spawnattr_setpgroup(&attr, 0);
+	posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
+
+	int error = posix_spawnp(&pid, argv[0], &actions, &attr, const_cast<char**> (argv), environ);
+
+	posix_spawnattr_destroy(&attr);
+	posix_spawn_file_actions_destroy(&actions);
+	close(pipe_fd[1]);
+	if (error != 0) {
+		close(pipe_fd[0]);
+		errno = error;
+		return -1;
+	}
+	return pipe_fd[0];
+}
+
+// start a shell command like spawnProcess
+inline int spawnCommand(const std::string& command, pid_t& pid) {
+	const char* argv[] = {"/bin/sh", "-c", command.c_str(), nullptr};
+	return spawnProcess(argv, pid);
+}
+
+#endif /* REACTOR_H */
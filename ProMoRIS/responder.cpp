@@ -0,0 +1,143 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "responder.h"
+#include "probe.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// bytes discarded with one recv call of a TCP connection
+#define RESPONDER_DRAIN_BYTES (1 << 20)
+
+probeResponder::probeResponder(epollReactor* reactor) : reactor(reactor), tcp_fd(-1), udp_fd(-1) {
+}
+
+probeResponder::~probeResponder() {
+	for (auto &connection : connections) {
+		reactor->remove(connection.second);
+		close(connection.first);
+	}
+	if (tcp_fd >= 0) close(tcp_fd);
+	if (udp_fd >= 0) close(udp_fd);
+}
+
+int probeResponder::start(int port) {
+	// IPv6 socket accepting IPv4 as well
+	sockaddr_in6 address;
+	memset(&address, 0, sizeof (address));
+	address.sin6_family = AF_INET6;
+	address.sin6_addr = in6addr_any;
+	address.sin6_port = htons(port);
+	int off = 0, on = 1;
+
+	tcp_fd = socket(AF_INET6, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	udp_fd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (tcp_fd < 0 || udp_fd < 0) {
+		std::cerr << "Could not create sockets: " << strerror(errno) << std::endl;
+		return 1;
+	}
+	setsockopt(tcp_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof (on));
+	setsockopt(tcp_fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof (off));
+	setsockopt(udp_fd, IPPROTO_IPV6, IPV6_V6ONLY, &off, sizeof (off));
+	if (bind(tcp_fd, (sockaddr*) & address, sizeof (address)) != 0 || listen(tcp_fd, 16) != 0
+			|| bind(udp_fd, (sockaddr*) & address, sizeof (address)) != 0) {
+		std::cerr << "Could not listen on port " << port << ": " << strerror(errno) << std::endl;
+		return 1;
+	}
+
+	if (reactor->addReadable(tcp_fd, [this]() {
+			acceptConnections();
+		}) < 0 || reactor->addReadable(udp_fd, [this]() {
+			echoDatagrams();
+		}) < 0) {
+		std::cerr << "Could not register sockets" << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+void probeResponder::acceptConnections() {
+	int fd;
+	while ((fd = accept4(tcp_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+		int id = reactor->addReadable(fd, [this, fd]() {
+			drainConnection(fd);
+		});
+		if (id < 0) {
+			close(fd);
+			continue;
+		}
+		connections[fd] = id;
+	}
+}
+
+// discard everything the probe sent, MSG_TRUNC avoids copying the data
+void probeResponder::drainConnection(int fd) {
+	static char buffer[RESPONDER_DRAIN_BYTES];
+	while (true) {
+		ssize_t n = recv(fd, buffer, sizeof (buffer), MSG_TRUNC | MSG_DONTWAIT);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+		if (n <= 0) break;
+	}
+	// connection closed by the probe
+	reactor->remove(connections[fd]);
+	connections.erase(fd);
+	close(fd);
+}
+
+// receive datagrams in batches and send their headers back, the payload is truncated
+void probeResponder::echoDatagrams() {
+	probe_header_t headers[PROBE_BATCH];
+	sockaddr_in6 addresses[PROBE_BATCH];
+	iovec iov[PROBE_BATCH];
+	mmsghdr messages[PROBE_BATCH];
+
+	while (true) {
+		memset(messages, 0, sizeof (messages));
+		for (int i = 0; i < PROBE_BATCH; ++i) {
+			iov[i].iov_base = &headers[i];
+			iov[i].iov_len = sizeof (probe_header_t);
+			messages[i].msg_hdr.msg_iov = &iov[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+			messages[i].msg_hdr.msg_name = &addresses[i];
+			messages[i].msg_hdr.msg_namelen = sizeof (sockaddr_in6);
+		}
+		int n = recvmmsg(udp_fd, messages, PROBE_BATCH, MSG_DONTWAIT, nullptr);
+		if (n <= 0) return;
+
+		// only echo datagrams of the probe, the received messages are reused for sending
+		int echo_n = 0;
+		for (int i = 0; i < n; ++i) {
+			if (messages[i].msg_len < sizeof (probe_header_t) || headers[i].magic != PROBE_MAGIC) continue;
+			if (echo_n != i) {
+				headers[echo_n] = headers[i];
+				addresses[echo_n] = addresses[i];
+				messages[echo_n].msg_hdr.msg_namelen = messages[i].msg_hdr.msg_namelen;
+			}
+			messages[echo_n].msg_hdr.msg_flags = 0;
+			++echo_n;
+		}
+		// a full socket buffer drops echoes, the probe counts them as lost
+		if (echo_n > 0) sendmmsg(udp_fd, messages, echo_n, MSG_DONTWAIT);
+		if (n < PROBE_BATCH) return;
+	}
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RESPONDER_H
+#define RESPONDER_H
+
+#include "epollreactor.h"
+
+/*
+ * Counterpart of the throughput probe module: accepts TCP connections and discards
+ * their data, and echoes the header of every UDP datagram to its sender.
+ * All sockets are served by one epollReactor.
+ */
+class probeResponder {
+public:
+	probeResponder(epollReactor* reactor);
+	~probeResponder();
+	// listen on port for TCP and UDP, returns 0 on success
+	int start(int port);
+private:
+	epollReactor* reactor;
+	int tcp_fd;
+	int udp_fd;
+	// connected probes and their sources in the reactor
+	std::unordered_map<int, int> connections;
+	void acceptConnections();
+	void drainConnection(int fd);
+	void echoDatagrams();
+};
+
+#endif /* RESPONDER_H */
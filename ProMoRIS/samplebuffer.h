@@ -0,0 +1,134 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SAMPLEBUFFER_H
+#define SAMPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// default number of samples kept per module
+#define SAMPLE_BUFFER_DEFAULT 1024
+
+/*
+ * Bounded single-producer/single-consumer ring buffer transporting the samples
+ * of a module (producer) to the main loop (consumer).
+ *
+ * Every published sample gets a sequence number (0, 1, 2, ...). Publishing never
+ * waits: when the buffer is full, the oldest sample is overwritten. The consumer
+ * reads samples in place and checks with valid() afterwards whether the sample
+ * was overwritten while it was reading it (seqlock style).
+ *
+ * T must be trivially copyable.
+ */
+template<typename T>
+class ringBuffer {
+public:
+
+	ringBuffer(size_t capacity = SAMPLE_BUFFER_DEFAULT) : head(0) {
+		resize(capacity);
+	}
+
+	// set the capacity (rounded up to a power of 2, at least 2) and drop all samples
+	// must not be called while producer or consumer are active
+	void resize(size_t capacity) {
+		size_t c = 2;
+		while (c < capacity) c <<= 1;
+		slots = std::vector<T>(c);
+		mask = c - 1;
+		head.store(0, std::memory_order_relaxed);
+	}
+
+	size_t capacity() const {
+		return mask + 1;
+	}
+
+	// PRODUCER
+
+	// slot for the next sample, becomes visible to the consumer with publish()
+	T* claim() {
+		return &slots[head.load(std::memory_order_relaxed) & mask];
+	}
+
+	// make the sample written to claim() visible
+	void publish() {
+		head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		// writes to the next slot must not become visible before the new head
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void push(const T& value) {
+		*claim() = value;
+		publish();
+	}
+
+	// CONSUMER
+
+	// sequence number following the latest published sample (= number of samples published)
+	uint64_t end() const {
+		return head.load(std::memory_order_acquire);
+	}
+
+	// oldest sequence number which can still be read
+	// the slot of end() might be written by the producer at any time, so it is excluded
+	uint64_t begin() const {
+		uint64_t h = end();
+		return h > mask ? h - mask : 0;
+	}
+
+	bool empty() const {
+		return end() == 0;
+	}
+
+	// sample with sequence number seq, must be in [begin(), end())
+	const T* at(uint64_t seq) const {
+		return &slots[seq & mask];
+	}
+
+	// latest published sample and its sequence number, nullptr if nothing was published yet
+	const T* peekLatest(uint64_t& seq) const {
+		uint64_t h = end();
+		if (h == 0) return nullptr;
+		seq = h - 1;
+		return at(seq);
+	}
+
+	// check after reading sample seq whether the producer started overwriting it meanwhile
+	bool valid(uint64_t seq) const {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return head.load(std::memory_order_relaxed) < seq + mask + 1;
+	}
+
+	// number of samples published after cursor which have already been overwritten
+	uint64_t lost(uint64_t cursor) const {
+		uint64_t b = begin();
+		return b > cursor ? b - cursor : 0;
+	}
+
+private:
+	std::vector<T> slots;
+	size_t mask;
+	// sequence number of the next sample to be published
+	alignas(64) std::atomic<uint64_t> head;
+	char padding[64 - sizeof (std::atomic<uint64_t>)];
+};
+
+#endif /* SAMPLEBUFFER_H */
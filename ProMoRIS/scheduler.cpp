@@ -0,0 +1,67 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scheduler.h"
+#include <ctime>
+#include <cstdint>
+
+int64_t monotonicNs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<int64_t> (ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// attempts for measuring the offset, the one with the shortest gap between the
+// two monotonic readings around the realtime reading is used
+#define WALL_CLOCK_ATTEMPTS 5
+
+int64_t wallClockOffsetNs() {
+	static int64_t offset_ns = 0;
+	static bool measured = false;
+	if (measured) return offset_ns;
+
+	int64_t best_gap = INT64_MAX;
+	for (int attempt = 0; attempt < WALL_CLOCK_ATTEMPTS; ++attempt) {
+		timespec ts;
+		int64_t before = monotonicNs();
+		clock_gettime(CLOCK_REALTIME, &ts);
+		int64_t after = monotonicNs();
+		if (after - before >= best_gap) continue;
+		best_gap = after - before;
+		offset_ns = static_cast<int64_t> (ts.tv_sec) * 1000000000LL + ts.tv_nsec - (before + (after - before) / 2);
+	}
+	measured = true;
+	return offset_ns;
+}
+
+tickScheduler::tickScheduler(int64_t interval_ns) : interval_ns(interval_ns),
+start_ns(monotonicNs()), current_tick(0), current_drift(0), current_jitter(0), missed_total(0) {
+}
+
+int64_t tickScheduler::advance(uint64_t expirations) {
+	int64_t skipped = expirations > 0 ? expirations - 1 : 0;
+	current_tick += expirations;
+
+	int64_t drift = monotonicNs() - (start_ns + current_tick * interval_ns);
+	current_jitter = drift - current_drift;
+	current_drift = drift;
+	missed_total += skipped;
+
+	return skipped;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <cstdint>
+
+// current time of CLOCK_MONOTONIC in nanoseconds
+int64_t monotonicNs();
+
+// CLOCK_REALTIME - CLOCK_MONOTONIC in nanoseconds, measured on the first call only,
+// so all time stamps of a run are mapped to wall-clock time consistently
+int64_t wallClockOffsetNs();
+
+/*
+ * Fixed grid of absolute deadlines (start + n * interval on CLOCK_MONOTONIC) the main loop
+ * is woken up on by a timer of the reactor, so the time needed for creating and printing
+ * a row does not add up over time.
+ * Deadlines which have already passed when the main loop wakes up are skipped and counted as missed.
+ */
+class tickScheduler {
+public:
+	tickScheduler(int64_t interval_ns);
+	// first deadline of the grid
+	int64_t first() const {
+		return start_ns + interval_ns;
+	}
+	int64_t interval() const {
+		return interval_ns;
+	}
+	// advance to the latest deadline after the timer expired expirations times
+	// returns the number of deadlines skipped
+	int64_t advance(uint64_t expirations);
+	// number of the current tick (deadline n of the grid)
+	int64_t tick() const {
+		return current_tick;
+	}
+	// time the main loop woke up later than the deadline of the current tick (ns)
+	int64_t drift() const {
+		return current_drift;
+	}
+	// difference of the drift to the drift of the previous tick (ns)
+	int64_t jitter() const {
+		return current_jitter;
+	}
+	// total number of missed deadlines
+	int64_t missed() const {
+		return missed_total;
+	}
+private:
+	int64_t interval_ns;
+	int64_t start_ns;
+	int64_t current_tick;
+	int64_t current_drift;
+	int64_t current_jitter;
+	int64_t missed_total;
+};
+
+#endif /* SCHEDULER_H */
@@ -0,0 +1,186 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "targets.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <regex>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+typedef enum target_kind_t {
+	TARGET_PID,
+	TARGET_PGID,
+	TARGET_COMM,
+	TARGET_CMDLINE
+} target_kind_t;
+
+static bool isNumber(const std::string& s) {
+	if (s.empty()) return false;
+	for (char c : s) {
+		if (!isdigit(static_cast<unsigned char> (c))) return false;
+	}
+	return true;
+}
+
+// read a small procfs file, returns an empty string if it cannot be read
+static std::string readProcFile(const std::string& path) {
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return "";
+	char buffer[4096];
+	ssize_t n = read(fd, buffer, sizeof (buffer));
+	close(fd);
+	if (n <= 0) return "";
+	return std::string(buffer, n);
+}
+
+// process group of a process from /proc/PID/stat (field 5), -1 if not readable
+static pid_t readPgid(const std::string& pid) {
+	std::string stat = readProcFile("/proc/" + pid + "/stat");
+	// the command name may contain spaces and parentheses
+	size_t p = stat.rfind(')');
+	if (p == std::string::npos) return -1;
+	// skip ") " and the state, then the parent PID
+	char* s = &stat[p + 3];
+	strtol(s, &s, 10);
+	return strtol(s, nullptr, 10);
+}
+
+bool multipleTargets(const std::vector<std::string>& specs) {
+	return specs.size() > 1 || (specs.size() == 1 && !isNumber(specs[0]));
+}
+
+bool resolveTargets(const std::vector<std::string>& specs, std::vector<pid_t>& pids, std::string& error) {
+
+	// parse the specifications
+	std::vector<target_kind_t> kinds;
+	std::vector<pid_t> numbers;
+	std::vector<std::regex> patterns;
+	for (auto &spec : specs) {
+		target_kind_t kind;
+		std::string value;
+		if (spec.compare(0, 5, "pgid:") == 0) {
+			kind = TARGET_PGID;
+			value = spec.substr(5);
+		} else if (spec.compare(0, 5, "comm:") == 0) {
+			kind = TARGET_COMM;
+			value = spec.substr(5);
+		} else if (spec.compare(0, 8, "cmdline:") == 0) {
+			kind = TARGET_CMDLINE;
+			value = spec.substr(8);
+		} else {
+			kind = TARGET_PID;
+			value = spec;
+		}
+		kinds.push_back(kind);
+		numbers.push_back(0);
+		patterns.push_back(std::regex());
+		if (kind == TARGET_PID || kind == TARGET_PGID) {
+			if (!isNumber(value)) {
+				error = "invalid target " + spec;
+				return false;
+			}
+			numbers.back() = atoi(value.c_str());
+		} else {
+			try {
+				patterns.back() = std::regex(value, std::regex::extended | std::regex::nosubs);
+			} catch (std::regex_error& e) {
+				error = "invalid regular expression in target " + spec;
+				return false;
+			}
+		}
+	}
+
+	// PIDs are taken as they are, everything else needs a scan of /proc
+	pids.clear();
+	bool scan = false;
+	for (size_t i = 0; i < kinds.size(); ++i) {
+		if (kinds[i] == TARGET_PID) pids.push_back(numbers[i]);
+		else scan = true;
+	}
+
+	if (scan) {
+		DIR* proc = opendir("/proc");
+		if (proc == nullptr) {
+			error = std::string("cannot read /proc: ") + strerror(errno);
+			return false;
+		}
+		pid_t self = getpid();
+		struct dirent* entry;
+		while ((entry = readdir(proc)) != nullptr) {
+			std::string pid = entry->d_name;
+			if (!isNumber(pid) || atoi(pid.c_str()) == self) continue;
+
+			// only read the files needed by the specifications
+			std::string comm, cmdline;
+			pid_t pgid = -2;
+			bool comm_read = false, cmdline_read = false;
+			for (size_t i = 0; i < kinds.size(); ++i) {
+				bool match = false;
+				switch (kinds[i]) {
+					case TARGET_PID:
+						break;
+					case TARGET_PGID:
+						if (pgid == -2) pgid = readPgid(pid);
+						match = (pgid == numbers[i]);
+						break;
+					case TARGET_COMM:
+						if (!comm_read) {
+							comm = readProcFile("/proc/" + pid + "/comm");
+							if (!comm.empty() && comm.back() == '\n') comm.pop_back();
+							comm_read = true;
+						}
+						match = std::regex_search(comm, patterns[i]);
+						break;
+					case TARGET_CMDLINE:
+						if (!cmdline_read) {
+							cmdline = readProcFile("/proc/" + pid + "/cmdline");
+							// arguments are separated by null characters
+							while (!cmdline.empty() && cmdline.back() == '\0') cmdline.pop_back();
+							std::replace(cmdline.begin(), cmdline.end(), '\0', ' ');
+							cmdline_read = true;
+						}
+						// kernel threads have an empty command line
+						match = !cmdline.empty() && std::regex_search(cmdline, patterns[i]);
+						break;
+				}
+				if (match) {
+					pids.push_back(atoi(pid.c_str()));
+					break;
+				}
+			}
+		}
+		closedir(proc);
+	}
+
+	std::sort(pids.begin(), pids.end());
+	pids.erase(std::unique(pids.begin(), pids.end()), pids.end());
+
+	return true;
+
+}
+
+bool targetAlive(pid_t pid) {
+	return kill(pid, 0) == 0 || errno != ESRCH;
+}
@@ -0,0 +1,46 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TARGETS_H
+#define TARGETS_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/*
+ * Resolves the target specifications passed after -P to the PIDs of the processes
+ * to be monitored. A specification is one of:
+ * PID -- the process PID
+ * pgid:PGID -- all processes of the process group PGID
+ * comm:REGEX -- all processes whose name (/proc/PID/comm) matches REGEX
+ * cmdline:REGEX -- all processes whose command line matches REGEX
+ * Patterns are resolved once by scanning /proc, ProMoRIS itself is never matched.
+ * The PIDs are returned sorted and without duplicates.
+ * Returns false and sets error if a specification is invalid.
+ */
+bool resolveTargets(const std::vector<std::string>& specs, std::vector<pid_t>& pids, std::string& error);
+
+// true if more than a single PID was requested, i.e. the output has to tell the targets apart
+bool multipleTargets(const std::vector<std::string>& specs);
+
+// check whether the process pid still exists
+bool targetAlive(pid_t pid);
+
+#endif /* TARGETS_H */
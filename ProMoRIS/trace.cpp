@@ -0,0 +1,233 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "trace.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "module.h"
+
+// RECORDER
+
+bool traceRecorder::open(const std::string& file, bool timed) {
+	out.open(file);
+	if (!out.is_open()) return false;
+	this->timed = timed;
+	if (!timed) return true;
+	start_ns = sampleTime();
+	timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	out << TRACE_HEADER << ' ' << static_cast<int64_t> (ts.tv_sec) * SAMPLE_TIME_PER_SECOND + ts.tv_nsec << '\n';
+	return true;
+}
+
+void traceRecorder::record(const char* line) {
+	if (timed) out << sampleTime() - start_ns << '\t';
+	out << line << '\n';
+}
+
+bool traceRecorder::parseFormat(const std::string& format, bool& timed) {
+	if (format == "raw") timed = false;
+	else if (format == "timed") timed = true;
+	else return false;
+	return true;
+}
+
+void traceRecorder::close() {
+	if (out.is_open()) out.close();
+}
+
+// REPLAY
+
+bool traceReplay::start(const std::string& file, double speed, eventReactor* reactor, lineCallback_t on_line, closeCallback_t on_end,
+		const char* snapshot, int64_t snapshot_ns) {
+	stop();
+	in.open(file);
+	if (!in.is_open()) return false;
+	this->speed = speed;
+	this->reactor = reactor;
+	this->on_line = on_line;
+	this->on_end = on_end;
+	this->snapshot = snapshot != nullptr ? snapshot : "";
+	this->snapshot_ns = snapshot_ns;
+	snapshots = 0;
+
+	// traces of raw tool output start with their first line
+	has_next = static_cast<bool> (std::getline(in, next_line));
+	timed = has_next && next_line.compare(0, strlen(TRACE_HEADER), TRACE_HEADER) == 0;
+	if (timed) readNext();
+	else untimedOffset();
+
+	start_ns = sampleTime();
+	schedule();
+	return true;
+}
+
+void traceReplay::stop() {
+	if (timer >= 0) reactor->remove(timer);
+	timer = -1;
+	has_next = false;
+	if (in.is_open()) in.close();
+}
+
+void traceReplay::readNext() {
+	has_next = static_cast<bool> (std::getline(in, next_line));
+	if (!has_next) return;
+	if (!timed) {
+		untimedOffset();
+		return;
+	}
+	// OFFSET<TAB>LINE, lines without an offset keep the previous one
+	char* end;
+	int64_t offset = strtoll(next_line.c_str(), &end, 10);
+	if (end != next_line.c_str() && *end == '\t') {
+		next_offset = offset;
+		next_line.erase(0, end - next_line.c_str() + 1);
+	}
+}
+
+// offset of the next line of a trace without time stamps, the first snapshot starts at 0
+void traceReplay::untimedOffset() {
+	if (!snapshot.empty() && next_line.compare(0, snapshot.size(), snapshot) == 0) ++snapshots;
+	next_offset = std::max(snapshots - 1, (int64_t) 0) * snapshot_ns;
+}
+
+// wake up for the next line, or finish
+void traceReplay::schedule() {
+	if (!has_next) {
+		in.close();
+		if (on_end) on_end();
+		return;
+	}
+	int64_t due = start_ns;
+	if (!fast()) due += static_cast<int64_t> (next_offset / speed);
+	timer = reactor->addTimer(due, 0, [this](uint64_t expirations) {
+		reactor->remove(timer);
+		timer = -1;
+		deliver();
+	});
+}
+
+// pass the lines which are due, or a slice of lines when replaying as fast as possible
+void traceReplay::deliver() {
+	int64_t now = sampleTime();
+	while (has_next) {
+		if (fast()) {
+			if (sampleTime() - now >= TRACE_SLICE_NS) break;
+		} else if (start_ns + static_cast<int64_t> (next_offset / speed) > now) {
+			break;
+		}
+		on_line(next_line.c_str());
+		readNext();
+	}
+	schedule();
+}
+
+// CONVERSION
+
+bool traceFile::open(const std::string& file) {
+	close();
+	int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		::close(fd);
+		return false;
+	}
+	size = st.st_size;
+	if (size > 0) {
+		void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED) {
+			::close(fd);
+			size = 0;
+			return false;
+		}
+		data = static_cast<char*> (p);
+		madvise(data, size, MADV_SEQUENTIAL);
+	}
+	::close(fd);
+
+	// the header line contains the UNIX time of offset 0
+	size_t header = strlen(TRACE_HEADER);
+	timed = size >= header && memcmp(data, TRACE_HEADER, header) == 0;
+	if (timed) {
+		const char* eol = static_cast<const char*> (memchr(data, '\n', size));
+		std::string line(data + header, (eol != nullptr ? eol : data + size) - (data + header));
+		start_ns = strtoll(line.c_str(), nullptr, 10);
+		pos = eol != nullptr ? eol - data + 1 : size;
+	}
+	return true;
+}
+
+void traceFile::close() {
+	if (data != nullptr) munmap(data, size);
+	data = nullptr;
+	size = pos = 0;
+	timed = false;
+	start_ns = offset = 0;
+}
+
+bool traceFile::next(const char*& line, int64_t& time) {
+	if (pos >= size) return false;
+	char* begin = data + pos;
+	char* eol = static_cast<char*> (memchr(begin, '\n', size - pos));
+	if (eol != nullptr) {
+		*eol = '\0';
+		pos = eol - data + 1;
+	} else {
+		tail.assign(begin, size - pos);
+		begin = &tail[0];
+		pos = size;
+	}
+
+	if (!timed) {
+		line = begin;
+		time = -1;
+		return true;
+	}
+	// OFFSET<TAB>LINE, lines without an offset keep the previous one
+	char* end;
+	int64_t line_offset = strtoll(begin, &end, 10);
+	if (end != begin && *end == '\t') {
+		offset = line_offset;
+		begin = end + 1;
+	}
+	line = begin;
+	time = start_ns + offset;
+	return true;
+}
+
+size_t traceFile::count(const char* text) const {
+	size_t n = 0;
+	size_t length = strlen(text);
+	const char* p = data;
+	const char* end = data + size;
+	while (p != nullptr && p < end) {
+		p = static_cast<const char*> (memmem(p, end - p, text, length));
+		if (p == nullptr) break;
+		++n;
+		p += length;
+	}
+	return n;
+}
@@ -0,0 +1,141 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include "reactor.h"
+
+// first line of a trace with time stamps, followed by the UNIX time (ns) of offset 0
+#define TRACE_HEADER "#promoris-trace 1"
+// when replaying traces without time stamps or snapshots as fast as possible, the main loop gets its turn after this time
+#define TRACE_SLICE_NS 1000000LL
+
+/*
+ * Records the output of a monitoring tool (the TRACEFILE option of modTop, modNethogs
+ * and modIperf3), so it can be replayed by traceReplay. Raw traces contain the output unchanged,
+ * timed traces also the time each line was received: after the header line, every line is
+ * OFFSET<TAB>LINE with OFFSET in ns since the trace was opened.
+ * Shared by ProMoRIS and the modules, which compile trace.cpp themselves.
+ */
+class traceRecorder {
+public:
+	traceRecorder() : timed(false), start_ns(0) {}
+	// create file and write the header of a timed trace, returns false on errors
+	bool open(const std::string& file, bool timed);
+	// TRACEFORMAT option of the modules: raw (default) or timed, returns false for other values
+	static bool parseFormat(const std::string& format, bool& timed);
+	bool isOpen() const {
+		return out.is_open();
+	}
+	// record a line (without line break) received now
+	void record(const char* line);
+	void close();
+private:
+	std::ofstream out;
+	bool timed;
+	int64_t start_ns;
+};
+
+/*
+ * Replays a trace through the event loop instead of running the tool: the lines are passed
+ * to on_line with the original timing scaled by 1 / speed (speed 1: original timing, 2: twice as fast).
+ * In traces without time stamps (raw tool output), every line starting with snapshot begins a new
+ * snapshot snapshot_ns after the previous one (like the conversion); without snapshot they are
+ * replayed as fast as possible in slices of TRACE_SLICE_NS.
+ * The samples get the time stamps of the replay, so a replay behaves like a run of the tool.
+ */
+class traceReplay {
+public:
+	traceReplay() : reactor(nullptr), speed(1.0), timed(false), snapshot_ns(0), snapshots(0), timer(-1), start_ns(0),
+	next_offset(0), has_next(false) {}
+	~traceReplay() {
+		stop();
+	}
+	// start replaying file with speed > 0, on_end is called after the last line
+	// returns false if the file cannot be read
+	bool start(const std::string& file, double speed, eventReactor* reactor, lineCallback_t on_line, closeCallback_t on_end,
+			const char* snapshot = nullptr, int64_t snapshot_ns = 0);
+	void stop();
+	bool running() const {
+		return timer >= 0;
+	}
+private:
+	std::ifstream in;
+	eventReactor* reactor;
+	lineCallback_t on_line;
+	closeCallback_t on_end;
+	double speed;
+	// the trace has time stamps
+	bool timed;
+	// first line of a snapshot in traces without time stamps and the time between two snapshots
+	std::string snapshot;
+	int64_t snapshot_ns;
+	int64_t snapshots;
+	// timer of the next line in the event loop
+	int timer;
+	// start of the replay (CLOCK_MONOTONIC in ns)
+	int64_t start_ns;
+	// next line of the trace and its offset
+	std::string next_line;
+	int64_t next_offset;
+	bool has_next;
+	void readNext();
+	void untimedOffset();
+	bool fast() const {
+		return !timed && snapshot.empty();
+	}
+	void schedule();
+	void deliver();
+};
+
+/*
+ * Reads a trace for the offline conversion (promoris --convert): the file is mapped into memory
+ * and the lines are terminated in place (private mapping), so they are passed to the parsers without copies.
+ */
+class traceFile {
+public:
+	traceFile() : data(nullptr), size(0), pos(0), timed(false), start_ns(0), offset(0) {}
+	~traceFile() {
+		close();
+	}
+	// returns false if the file cannot be read
+	bool open(const std::string& file);
+	void close();
+	// next line of the trace and its time (UNIX time in ns), -1 for traces without time stamps
+	// returns false at the end of the trace
+	bool next(const char*& line, int64_t& time);
+	// number of occurrences of text in the trace for sizing the sample buffers, must be called before next()
+	size_t count(const char* text) const;
+private:
+	char* data;
+	size_t size;
+	// start of the next line
+	size_t pos;
+	bool timed;
+	int64_t start_ns;
+	int64_t offset;
+	// last line without line break, it cannot be terminated in place
+	std::string tail;
+};
+
+#endif /* TRACE_H */
@@ -0,0 +1,171 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "writer.h"
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+outputWriter::outputWriter(int fd, size_t queue_rows, flush_policy_t policy, bool blocking) :
+fd(fd), queue_rows(queue_rows), policy(policy), blocking(blocking), queue_bytes(0), stopping(false), dropped_rows(0),
+written_bytes(0), flush_ns(0), flush_count(0) {
+	t1 = std::thread(&outputWriter::run, this);
+}
+
+outputWriter::~outputWriter() {
+	stop();
+}
+
+bool outputWriter::push(std::string&& row, bool wait) {
+	{
+		std::unique_lock<std::mutex> queue_guard(queue_m);
+		if (queue.size() >= queue_rows && (blocking || wait)) {
+			queue_cv.notify_one();
+			space_cv.wait(queue_guard, [this] {
+				return queue.size() < queue_rows; });
+		}
+		if (queue.size() >= queue_rows) {
+			++dropped_rows;
+			return false;
+		}
+		queue_bytes += row.size();
+		queue.push_back(std::move(row));
+		// the writer thread only needs to be woken up for the first row of a batch and when the batch is full
+		if (!policy.every_row && queue.size() > 1 && queue_bytes < policy.flush_bytes) return true;
+	}
+	queue_cv.notify_one();
+	return true;
+}
+
+void outputWriter::stop() {
+	{
+		std::lock_guard<std::mutex> queue_guard(queue_m);
+		if (stopping) return;
+		stopping = true;
+	}
+	queue_cv.notify_one();
+	if (t1.joinable()) t1.join();
+}
+
+void outputWriter::run() {
+	std::vector<std::string> batch;
+	std::unique_lock<std::mutex> queue_lock(queue_m);
+	while (true) {
+		// wait until enough bytes or rows are queued or the oldest row waited long enough
+		if (!policy.every_row && !stopping && queue_bytes < policy.flush_bytes && queue.size() < queue_rows) {
+			if (queue.empty()) {
+				queue_cv.wait(queue_lock, [this] {
+					return stopping || !queue.empty(); });
+			}
+			if (policy.flush_ms > 0) {
+				queue_cv.wait_for(queue_lock, std::chrono::milliseconds(policy.flush_ms), [this] {
+					return stopping || queue_bytes >= policy.flush_bytes || queue.size() >= queue_rows; });
+			} else {
+				queue_cv.wait(queue_lock, [this] {
+					return stopping || queue_bytes >= policy.flush_bytes || queue.size() >= queue_rows; });
+			}
+		} else if (queue.empty() && !stopping) {
+			queue_cv.wait(queue_lock, [this] {
+				return stopping || !queue.empty(); });
+		}
+
+		// take the queued rows and write them without holding the lock
+		batch.swap(queue);
+		queue_bytes = 0;
+		bool last = stopping;
+		queue_lock.unlock();
+		space_cv.notify_one();
+		writeBatch(batch);
+		batch.clear();
+		queue_lock.lock();
+
+		if (last && queue.empty()) break;
+	}
+}
+
+void outputWriter::writeBatch(std::vector<std::string>& batch) {
+	if (batch.empty()) return;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::vector<iovec> iov;
+	size_t row_i = 0;
+	while (row_i < batch.size()) {
+		// at most IOV_MAX rows per writev
+		iov.clear();
+		for (size_t i = row_i; i < batch.size() && iov.size() < IOV_MAX; ++i) {
+			iovec entry;
+			entry.iov_base = &batch[i][0];
+			entry.iov_len = batch[i].size();
+			iov.push_back(entry);
+		}
+		row_i += iov.size();
+
+		// continue after partial writes
+		size_t iov_i = 0;
+		while (iov_i < iov.size()) {
+			ssize_t written = writev(fd, &iov[iov_i], std::min(iov.size() - iov_i, static_cast<size_t> (IOV_MAX)));
+			if (written < 0) {
+				if (errno == EINTR) continue;
+				std::cerr << "Writing output failed: " << strerror(errno) << std::endl;
+				return;
+			}
+			written_bytes += written;
+			while (iov_i < iov.size() && static_cast<size_t> (written) >= iov[iov_i].iov_len) {
+				written -= iov[iov_i].iov_len;
+				++iov_i;
+			}
+			if (iov_i < iov.size()) {
+				iov[iov_i].iov_base = static_cast<char*> (iov[iov_i].iov_base) + written;
+				iov[iov_i].iov_len -= written;
+			}
+		}
+	}
+	flush_ns += std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - start).count();
+	++flush_count;
+}
+
+bool outputWriter::parsePolicy(const char* text, flush_policy_t& policy) {
+	policy.every_row = false;
+	policy.flush_bytes = SIZE_MAX;
+	policy.flush_ms = 0;
+	std::string rest = text;
+	while (!rest.empty()) {
+		size_t comma = rest.find(',');
+		std::string part = rest.substr(0, comma);
+		rest = (comma == std::string::npos) ? "" : rest.substr(comma + 1);
+		if (part == "row") {
+			policy.every_row = true;
+		} else if (part.compare(0, 5, "size=") == 0) {
+			policy.flush_bytes = strtoull(part.c_str() + 5, nullptr, 10);
+			if (policy.flush_bytes == 0) return false;
+		} else if (part.compare(0, 5, "time=") == 0) {
+			policy.flush_ms = atoi(part.c_str() + 5);
+			if (policy.flush_ms <= 0) return false;
+		} else {
+			return false;
+		}
+	}
+	// without any threshold, rows would never be written
+	if (!policy.every_row && policy.flush_bytes == SIZE_MAX && policy.flush_ms == 0) return false;
+	return true;
+}
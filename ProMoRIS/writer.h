@@ -0,0 +1,94 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// when the writer thread writes the queued rows to the output
+typedef struct flush_policy_t {
+	// write as soon as a row is queued
+	bool every_row;
+	// write when at least flush_bytes are queued
+	size_t flush_bytes;
+	// write when the oldest queued row waits for flush_ms milliseconds
+	int flush_ms;
+} flush_policy_t;
+
+/*
+ * Writes finished rows to a file descriptor in a separate thread,
+ * so the main loop never blocks on the output.
+ * Rows are collected and written in batches with writev.
+ * If more than queue_rows rows are waiting, new rows are dropped and counted,
+ * unless the writer is blocking (offline conversion), then push waits for the writer thread.
+ */
+class outputWriter {
+public:
+	outputWriter(int fd, size_t queue_rows, flush_policy_t policy, bool blocking = false);
+	~outputWriter();
+	// queue a row (or any other text), only blocks on the output if the writer is blocking or wait is set
+	// (data which must not be lost, e.g. the blocks of a binary log), returns false if the row was dropped
+	bool push(std::string&& row, bool wait = false);
+	// write all queued rows and stop the thread
+	void stop();
+	uint64_t dropped() const {
+		return dropped_rows.load();
+	}
+	// bytes written to the output so far
+	uint64_t writtenBytes() const {
+		return written_bytes.load();
+	}
+	// time spent in writev (ns) and number of batches written
+	int64_t flushNs() const {
+		return flush_ns.load();
+	}
+	uint64_t flushes() const {
+		return flush_count.load();
+	}
+	// parse a policy like "row", "size=65536", "time=1000" or "size=65536,time=1000"
+	static bool parsePolicy(const char* text, flush_policy_t& policy);
+private:
+	int fd;
+	size_t queue_rows;
+	flush_policy_t policy;
+	bool blocking;
+	std::mutex queue_m;
+	std::condition_variable queue_cv;
+	// a blocking push or one with wait set waits for room in the queue
+	std::condition_variable space_cv;
+	std::vector<std::string> queue;
+	size_t queue_bytes;
+	bool stopping;
+	std::atomic<uint64_t> dropped_rows;
+	std::atomic<uint64_t> written_bytes;
+	std::atomic<int64_t> flush_ns;
+	std::atomic<uint64_t> flush_count;
+	std::thread t1;
+	void run();
+	void writeBatch(std::vector<std::string>& batch);
+};
+
+#endif /* WRITER_H */
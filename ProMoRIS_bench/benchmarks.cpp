@@ -0,0 +1,422 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmarks.h"
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../ProMoRIS/main.h"
+#include "../ProMoRIS/alignment.h"
+#include "../ProMoRIS/aggregator.h"
+#include "../ProMoRIS/changefilter.h"
+#include "../ProMoRIS/encoder.h"
+#include "../ProMoRIS/scheduler.h"
+#include "../ProMoRIS/writer.h"
+#include "../ProMoRIS_modTop/topparser.h"
+#include "../ProMoRIS_modNethogs/nethogsparser.h"
+
+// PIDs of the synthetic processes of the parsers start here
+#define BENCH_FIRST_PID 1000
+
+// xorshift, the values of the synthetic modules only need to change
+static uint64_t nextRandom(uint64_t& state) {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+// types of a synthetic module: time and columns value columns, alternately int64 and double
+static std::vector<field_type_t> syntheticTypes(int columns) {
+	std::vector<field_type_t> types = {FIELD_TIME};
+	for (int col_i = 1; col_i <= columns; ++col_i) types.push_back(col_i % 2 == 1 ? FIELD_INT64 : FIELD_DOUBLE);
+	return types;
+}
+
+// move the values of a row (or sample) by a random walk of about +-1 %
+static void walkValue(field_type_t type, field_t& value, uint64_t& state) {
+	int64_t step = static_cast<int64_t> (nextRandom(state) % 21) - 10;
+	if (type == FIELD_INT64) value.i += step * (value.i / 1000 + 1);
+	else if (type == FIELD_DOUBLE) value.d *= 1.0 + step / 1000.0;
+}
+
+// ROW PATHS
+
+/*
+ * Synthetic modules: every module publishes ratio samples per row to its buffer,
+ * with time stamps spread evenly over the interval of the row.
+ */
+class syntheticModules {
+public:
+	syntheticModules(const bench_config_t& config) : types(syntheticTypes(config.columns)), buffers(config.modules),
+	ratio(config.ratio), time(BENCH_TICK_NS), state(88172645463325252ULL) {
+		for (int col_i = 0; col_i < types.size(); ++col_i) indices.push_back(col_i);
+		for (auto &buffer : buffers) buffer.resize(config.history);
+		sample_t first;
+		first.time = 0;
+		for (int col_i = 1; col_i < types.size(); ++col_i) {
+			if (types[col_i] == FIELD_INT64) first.fields[col_i].i = 100000;
+			else first.fields[col_i].d = 50.0;
+		}
+		latest = std::vector<sample_t>(config.modules, first);
+	}
+	// publish the samples of the next row, returns the time of the row
+	int64_t publishRow() {
+		for (size_t mod_i = 0; mod_i < buffers.size(); ++mod_i) {
+			sample_t& sample = latest[mod_i];
+			for (int sample_i = 1; sample_i <= ratio; ++sample_i) {
+				sample.time = time - BENCH_TICK_NS + BENCH_TICK_NS * sample_i / ratio;
+				for (int col_i = 1; col_i < types.size(); ++col_i) walkValue(types[col_i], sample.fields[col_i], state);
+				buffers[mod_i].push(sample);
+			}
+		}
+		time += BENCH_TICK_NS;
+		return time - BENCH_TICK_NS;
+	}
+	// add the cells of a sample to a row, like pushCells() of ProMoRIS
+	void pushCells(std::vector<cell_t>& row, const sample_t* sample) const {
+		for (int col_i : indices) {
+			cell_t cell;
+			cell.type = types[col_i];
+			cell.empty = (sample == nullptr);
+			if (sample != nullptr) {
+				if (cell.type == FIELD_TIME) cell.value.i = sample->time;
+				else cell.value = sample->fields[col_i];
+			}
+			row.push_back(cell);
+		}
+	}
+	std::vector<field_type_t> types;
+	std::vector<int> indices;
+	std::vector<sampleBuffer> buffers;
+private:
+	int ratio;
+	int64_t time;
+	uint64_t state;
+	std::vector<sample_t> latest;
+};
+
+// samples are published without creating rows
+class publishBenchmark : public benchmark {
+public:
+	publishBenchmark(const bench_config_t& config) : modules(config) {}
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) modules.publishRow();
+	}
+	const char* unit() {
+		return "row";
+	}
+private:
+	syntheticModules modules;
+};
+
+// latest sample of every module (createRow)
+class latestBenchmark : public benchmark {
+public:
+	latestBenchmark(const bench_config_t& config) : modules(config) {}
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) {
+			modules.publishRow();
+			row.clear();
+			for (auto &buffer : modules.buffers) {
+				uint64_t seq;
+				const sample_t* sample = buffer.peekLatest(seq);
+				modules.pushCells(row, sample);
+				if (sample != nullptr && !buffer.valid(seq)) {
+					row.resize(row.size() - modules.indices.size());
+					modules.pushCells(row, nullptr);
+				}
+			}
+		}
+	}
+	const char* unit() {
+		return "row";
+	}
+private:
+	syntheticModules modules;
+	std::vector<cell_t> row;
+};
+
+// samples aligned to the time of the row by the alignment engine (createRowAlt)
+// rows are aligned half a tick back, so there are samples on both sides
+class alignBenchmark : public benchmark {
+public:
+	alignBenchmark(const bench_config_t& config, align_policy_t policy) : modules(config), engine(policy) {
+		for (auto &buffer : modules.buffers) engine.addModule(&buffer, modules.types);
+	}
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) {
+			int64_t row_time = modules.publishRow() - BENCH_TICK_NS / 2;
+			row.clear();
+			for (int mod_i = 0; mod_i < modules.buffers.size(); ++mod_i) {
+				modules.pushCells(row, engine.align(mod_i, row_time));
+			}
+		}
+	}
+	const char* unit() {
+		return "row";
+	}
+private:
+	syntheticModules modules;
+	alignmentEngine engine;
+	std::vector<cell_t> row;
+};
+
+// statistics of all samples of the window (createRowAgg)
+class aggregateBenchmark : public benchmark {
+public:
+	aggregateBenchmark(const bench_config_t& config) : modules(config), aggregator({50.0, 90.0, 99.0}) {
+		for (auto &buffer : modules.buffers) aggregator.addSource(&buffer, modules.types, modules.indices);
+	}
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) {
+			modules.publishRow();
+			row.clear();
+			for (int mod_i = 0; mod_i < modules.buffers.size(); ++mod_i) aggregator.aggregate(mod_i, row);
+		}
+	}
+	const char* unit() {
+		return "row";
+	}
+private:
+	syntheticModules modules;
+	windowAggregator aggregator;
+	std::vector<cell_t> row;
+};
+
+// ROWS
+
+/*
+ * Complete rows of the synthetic modules for the stages after the row creation:
+ * the values of every row follow a random walk from the previous one.
+ */
+class syntheticRows {
+public:
+	syntheticRows(const bench_config_t& config) : time(0), state(88172645463325252ULL) {
+		std::vector<field_type_t> types = syntheticTypes(config.columns);
+		for (int mod_i = 0; mod_i < config.modules; ++mod_i) {
+			for (int col_i = 0; col_i < types.size(); ++col_i) {
+				column_t column;
+				column.prefix = "m" + std::to_string(mod_i);
+				column.label = col_i == 0 ? "time" : "c" + std::to_string(col_i);
+				column.type = types[col_i];
+				column.width = 16;
+				columns.push_back(column);
+				cell_t cell;
+				cell.type = types[col_i];
+				cell.empty = false;
+				if (cell.type == FIELD_DOUBLE) cell.value.d = 50.0;
+				else cell.value.i = 100000;
+				row.push_back(cell);
+			}
+		}
+	}
+	// move to the next row, returns its time
+	int64_t next() {
+		time += BENCH_TICK_NS;
+		for (auto &cell : row) {
+			if (cell.type == FIELD_TIME) cell.value.i = time;
+			else walkValue(cell.type, cell.value, state);
+		}
+		return time;
+	}
+	std::vector<column_t> columns;
+	std::vector<cell_t> row;
+private:
+	int64_t time;
+	uint64_t state;
+};
+
+// change-based suppression with a relative epsilon of 0.5 %
+class filterBenchmark : public benchmark {
+public:
+	filterBenchmark(const bench_config_t& config) : rows(config),
+	filter(std::vector<epsilon_t>(rows.columns.size(), epsilon_t{0.0, 0.005}), compared(rows.columns), 0) {}
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) {
+			int64_t time = rows.next();
+			filter.pass(0, time, rows.row);
+		}
+	}
+	const char* unit() {
+		return "row";
+	}
+private:
+	syntheticRows rows;
+	changeFilter filter;
+	static std::vector<bool> compared(const std::vector<column_t>& columns) {
+		std::vector<bool> result;
+		for (auto &column : columns) result.push_back(column.type != FIELD_TIME);
+		return result;
+	}
+};
+
+// rows encoded in an output format and written to /dev/null by the writer thread
+class encoderBenchmark : public benchmark {
+public:
+	encoderBenchmark(const bench_config_t& config, const char* format) : rows(config) {
+		fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+		flush_policy_t policy;
+		outputWriter::parsePolicy("size=65536,time=1000", policy);
+		writer = new outputWriter(fd, 65536, policy);
+		encoder = rowEncoder::create(format, writer, rows.columns);
+		time_format_t time_format;
+		time_format.wall_offset_ns = wallClockOffsetNs();
+		time_format.precision = 6;
+		encoder->setTimeFormat(time_format);
+		encoder->header();
+	}
+	~encoderBenchmark() {
+		finish();
+		delete encoder;
+		delete writer;
+		close(fd);
+	}
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) {
+			int64_t time = rows.next();
+			encoder->row(time, rows.row);
+		}
+	}
+	uint64_t bytes() {
+		return writer->writtenBytes();
+	}
+	void finish() {
+		if (finished) return;
+		finished = true;
+		encoder->finish();
+		writer->stop();
+	}
+	const char* unit() {
+		return "row";
+	}
+private:
+	syntheticRows rows;
+	int fd;
+	outputWriter* writer;
+	rowEncoder* encoder;
+	bool finished = false;
+};
+
+// PARSERS
+
+// lines of tool output parsed one after the other, cyclically
+class parserBenchmark : public benchmark {
+public:
+	void run(uint64_t ops) {
+		for (uint64_t op = 0; op < ops; ++op) {
+			const std::string& line = lines[line_i];
+			parse(line.c_str());
+			parsed_bytes += line.size() + 1;
+			if (++line_i == lines.size()) line_i = 0;
+		}
+	}
+	uint64_t bytes() {
+		return parsed_bytes;
+	}
+	const char* unit() {
+		return "line";
+	}
+protected:
+	std::vector<std::string> lines;
+	virtual void parse(const char* line) = 0;
+private:
+	size_t line_i = 0;
+	uint64_t parsed_bytes = 0;
+};
+
+// snapshots of top -b with one process line per target (modTop)
+class topBenchmark : public parserBenchmark {
+public:
+	topBenchmark(const bench_config_t& config) : buffers(config.modules) {
+		for (auto &buffer : buffers) buffer.resize(config.history);
+		lines = {
+			"top - 12:00:00 up 1 day,  2:03,  1 user,  load average: 0.52, 0.58, 0.59",
+			"Tasks:   3 total,   0 running,   3 sleeping,   0 stopped,   0 zombie",
+			"%Cpu(s):  2.0 us,  1.0 sy,  0.0 ni, 96.9 id,  0.0 wa,  0.0 hi,  0.1 si,  0.0 st",
+			"MiB Mem :  15896.0 total,   1024.3 free,   8123.4 used,   6748.3 buff/cache",
+			"MiB Swap:   2048.0 total,   2048.0 free,      0.0 used.   7012.9 avail Mem",
+			"",
+			"    PID USER      PR  NI    VIRT    RES    SHR S  %CPU  %MEM     TIME+ COMMAND"
+		};
+		for (int target_i = 0; target_i < config.modules; ++target_i) {
+			pid_t pid = BENCH_FIRST_PID + target_i;
+			targets.push_back(pid);
+			char line[128];
+			snprintf(line, sizeof (line), "%7d promoris  20   0  162.3m  %5d   8192 S  %4.1f   0.1   0:01.23 bench",
+					pid, 10240 + target_i, 12.5 + target_i % 10);
+			lines.push_back(line);
+		}
+		lines.push_back("");
+		parser = topParser(&targets, &buffers);
+	}
+protected:
+	void parse(const char* line) {
+		parser.parseLine(line);
+	}
+private:
+	std::vector<pid_t> targets;
+	std::vector<sampleBuffer> buffers;
+	topParser parser;
+};
+
+// nethogs -t output with one line per process, the first process is monitored (modNethogs)
+class nethogsBenchmark : public parserBenchmark {
+public:
+	nethogsBenchmark(const bench_config_t& config) : buffer(config.history),
+	parser(std::to_string(BENCH_FIRST_PID), &buffer) {
+		lines.push_back("Refreshing:");
+		for (int process_i = 0; process_i < config.modules; ++process_i) {
+			char line[128];
+			snprintf(line, sizeof (line), "/usr/bin/bench/%d/1000\t%.3f\t%.3f",
+					BENCH_FIRST_PID + process_i, 12.345 + process_i, 6.789 + process_i);
+			lines.push_back(line);
+		}
+		lines.push_back("unknown TCP/0/0\t0\t0");
+	}
+protected:
+	void parse(const char* line) {
+		parser.parseLine(line);
+	}
+private:
+	sampleBuffer buffer;
+	nethogsParser parser;
+};
+
+const std::vector<std::string>& benchmark::names() {
+	static const std::vector<std::string> all = {"publish", "latest", "nearest", "last", "linear", "aggregate",
+		"filter", "table", "csv", "tsv", "ndjson", "binary", "top", "nethogs"};
+	return all;
+}
+
+benchmark* benchmark::create(const std::string& name, const bench_config_t& config) {
+	align_policy_t policy;
+	if (name == "publish") return new publishBenchmark(config);
+	if (name == "latest") return new latestBenchmark(config);
+	if (alignmentEngine::parsePolicy(name.c_str(), policy)) return new alignBenchmark(config, policy);
+	if (name == "aggregate") return new aggregateBenchmark(config);
+	if (name == "filter") return new filterBenchmark(config);
+	if (name == "table" || name == "csv" || name == "tsv" || name == "ndjson" || name == "binary") {
+		return new encoderBenchmark(config, name.c_str());
+	}
+	if (name == "top") return new topBenchmark(config);
+	if (name == "nethogs") return new nethogsBenchmark(config);
+	return nullptr;
+}
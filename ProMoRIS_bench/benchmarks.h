@@ -0,0 +1,68 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// at most this many value columns per synthetic module (plus the time column)
+#define BENCH_MAX_COLUMNS 15
+// interval of the rows in the sample time of the synthetic modules
+#define BENCH_TICK_NS 1000000000LL
+
+// size of a benchmark
+typedef struct bench_config_t {
+	// synthetic modules (row paths) or processes (parsers)
+	int modules;
+	// value columns per module, alternately int64 and double
+	int columns;
+	// capacity of the sample buffers
+	int history;
+	// samples published per module between two rows (sample rate / tick rate)
+	int ratio;
+} bench_config_t;
+
+/*
+ * One hot path of ProMoRIS driven by synthetic modules. An operation is one row
+ * (row paths, encoders) or one line of tool output (parsers). Publishing the samples
+ * of a row is part of the operation of the row paths, see the publish benchmark for its cost.
+ */
+class benchmark {
+public:
+	virtual ~benchmark() {}
+	// execute ops operations
+	virtual void run(uint64_t ops) = 0;
+	// bytes written or parsed so far, 0 if the benchmark does not handle text
+	virtual uint64_t bytes() {
+		return 0;
+	}
+	// call after the last run(), bytes() is final afterwards
+	virtual void finish() {}
+	// unit of an operation (row, line)
+	virtual const char* unit() = 0;
+	// benchmark for a name, nullptr if the name is unknown
+	static benchmark* create(const std::string& name, const bench_config_t& config);
+	// names of all benchmarks
+	static const std::vector<std::string>& names();
+};
+
+#endif /* BENCHMARKS_H */
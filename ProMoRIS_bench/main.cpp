@@ -0,0 +1,330 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "benchmarks.h"
+#include "../ProMoRIS/scheduler.h"
+
+// allocations of all threads, counted by the replaced operator new
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = malloc(size == 0 ? 1 : size);
+	if (p == nullptr) throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void* p = nullptr;
+	if (posix_memalign(&p, std::max(static_cast<size_t> (alignment), sizeof (void*)), size == 0 ? 1 : size) != 0) {
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+	free(p);
+}
+
+// result of a benchmark with one configuration
+typedef struct result_t {
+	// unit of an operation
+	const char* unit;
+	uint64_t ops;
+	double ns_per_op;
+	double allocs_per_op;
+	double bytes_per_op;
+} result_t;
+
+// parse a comma-separated list of positive numbers
+static bool parseList(const char* text, std::vector<int>& values) {
+	values.clear();
+	std::stringstream list(text);
+	std::string item;
+	while (std::getline(list, item, ',')) {
+		char* end;
+		long value = strtol(item.c_str(), &end, 10);
+		if (item.empty() || *end != '\0' || value <= 0) return false;
+		values.push_back(static_cast<int> (value));
+	}
+	return !values.empty();
+}
+
+// run a benchmark rounds times for about round_ns each, the round with the median time per operation counts
+static result_t measure(const std::string& name, const bench_config_t& config, int rounds, int64_t round_ns) {
+	std::vector<result_t> results;
+	for (int round_i = 0; round_i < rounds; ++round_i) {
+		benchmark* bench = benchmark::create(name, config);
+
+		// warm up, then double the batches until one takes an eighth of the round
+		bench->run(1);
+		uint64_t batch = 1, ops = 0;
+		int64_t elapsed_ns = 0;
+		uint64_t allocations_start = allocations.load();
+		while (elapsed_ns < round_ns) {
+			int64_t start = monotonicNs();
+			bench->run(batch);
+			int64_t batch_ns = monotonicNs() - start;
+			elapsed_ns += batch_ns;
+			ops += batch;
+			if (batch_ns < round_ns / 8) batch *= 2;
+		}
+		uint64_t round_allocations = allocations.load() - allocations_start;
+		bench->finish();
+
+		result_t result;
+		result.unit = bench->unit();
+		result.ops = ops;
+		result.ns_per_op = static_cast<double> (elapsed_ns) / ops;
+		result.allocs_per_op = static_cast<double> (round_allocations) / ops;
+		// the warm-up operation is part of the bytes
+		result.bytes_per_op = static_cast<double> (bench->bytes()) / (ops + 1);
+		results.push_back(result);
+		delete bench;
+	}
+	std::sort(results.begin(), results.end(), [](const result_t& a, const result_t & b) {
+		return a.ns_per_op < b.ns_per_op;
+	});
+	return results[results.size() / 2];
+}
+
+// benchmark and configuration of a result line, used to find it in the baseline
+static std::string resultKey(const std::string& name, const bench_config_t& config) {
+	return name + "," + std::to_string(config.modules) + "," + std::to_string(config.columns) + "," +
+			std::to_string(config.history) + "," + std::to_string(config.ratio);
+}
+
+// read the results of an earlier run (the output of promoris-bench) by their keys
+static bool readBaseline(const char* file, std::map<std::string, result_t>& baseline) {
+	std::ifstream in(file);
+	if (!in) return false;
+	std::string line;
+	std::getline(in, line);
+	while (std::getline(in, line)) {
+		std::vector<std::string> fields;
+		std::stringstream row(line);
+		std::string field;
+		while (std::getline(row, field, ',')) fields.push_back(field);
+		if (fields.size() < 11) continue;
+		result_t result;
+		result.unit = "";
+		result.ops = strtoull(fields[6].c_str(), nullptr, 10);
+		result.ns_per_op = strtod(fields[7].c_str(), nullptr);
+		result.allocs_per_op = strtod(fields[8].c_str(), nullptr);
+		result.bytes_per_op = strtod(fields[10].c_str(), nullptr);
+		baseline[fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3] + "," + fields[4]] = result;
+	}
+	return true;
+}
+
+/*
+ *
+ */
+int main(int argc, char** argv) {
+
+	// print help
+	if (argc > 1 && strcmp(argv[1], "-h") == 0) {
+		std::cout << "Usage:\n"
+				"promoris-bench [-b BENCHMARKS] [-m MODULES] [-c COLUMNS] [-l HISTORY] [-r RATIO] "
+				"[-n ROUNDS] [-d MS] [-B BASELINE [-t PERCENT]]\n\n"
+				"Microbenchmarks of the hot paths of ProMoRIS with synthetic modules. One CSV line per benchmark\n"
+				"and configuration is printed: ns, allocations (of all threads) and bytes per operation and\n"
+				"operations per second. MODULES, COLUMNS, HISTORY and RATIO may be comma-separated lists,\n"
+				"all combinations are run.\n\n"
+				"Options explained:\n"
+				"-b BENCHMARKS -- comma-separated list of benchmarks to run (default: all)\n"
+				"-m MODULES -- number of synthetic modules, or of processes for the parsers (default 4)\n"
+				"-c COLUMNS -- value columns per module, at most 15 (default 8)\n"
+				"-l HISTORY -- capacity of the sample buffers (default 1024)\n"
+				"-r RATIO -- samples per module and row, i.e. sample rate / tick rate (default 1)\n"
+				"-n ROUNDS -- run every benchmark ROUNDS times and report the median (default 5)\n"
+				"-d MS -- duration of a round in milliseconds (default 200)\n"
+				"-B BASELINE -- compare with the output of an earlier run saved in BASELINE, exit with 2 if a\n"
+				"	benchmark needs more time or allocations per operation than allowed by PERCENT\n"
+				"-t PERCENT -- tolerated increase over the baseline in % (default 10)\n\n"
+				"Benchmarks (operation):\n"
+				"publish -- samples of a row are published to the sample buffers (row)\n"
+				"latest -- row of the latest samples, the default of ProMoRIS (row)\n"
+				"nearest, last, linear -- row aligned by the alignment engine, -a / -A (row)\n"
+				"aggregate -- row of window statistics, -g (row)\n"
+				"filter -- change-based suppression of a row, -e (row)\n"
+				"table, csv, tsv, ndjson, binary -- row encoded and written to /dev/null, -O (row)\n"
+				"top -- line of top output parsed by modTop (line)\n"
+				"nethogs -- line of nethogs output parsed by modNethogs (line)\n"
+				"The row benchmarks include publishing the samples of the row, see publish for its cost."
+				<< std::endl;
+		return 0;
+	}
+
+	int arg_mode = 0;
+	std::vector<std::string> names = benchmark::names();
+	std::vector<int> modules = {4}, columns = {8}, histories = {1024}, ratios = {1};
+	int rounds = 5;
+	int64_t round_ns = 200000000LL;
+	const char* baseline_file = nullptr;
+	double tolerance = 10.0;
+	for (int i = 1; i < argc; ++i) {
+		bool valid = true;
+		if (arg_mode == 1) {
+			names.clear();
+			std::stringstream list(argv[i]);
+			std::string name;
+			while (std::getline(list, name, ',')) {
+				names.push_back(name);
+				if (std::find(benchmark::names().begin(), benchmark::names().end(), name) == benchmark::names().end()) {
+					std::cerr << "Unknown benchmark " << name << std::endl;
+					return 1;
+				}
+			}
+			arg_mode = 0;
+		} else if (arg_mode == 2) {
+			valid = parseList(argv[i], modules);
+			arg_mode = 0;
+		} else if (arg_mode == 3) {
+			valid = parseList(argv[i], columns) && *std::max_element(columns.begin(), columns.end()) <= BENCH_MAX_COLUMNS;
+			arg_mode = 0;
+		} else if (arg_mode == 4) {
+			valid = parseList(argv[i], histories);
+			arg_mode = 0;
+		} else if (arg_mode == 5) {
+			valid = parseList(argv[i], ratios);
+			arg_mode = 0;
+		} else if (arg_mode == 6) {
+			rounds = atoi(argv[i]);
+			valid = rounds > 0;
+			arg_mode = 0;
+		} else if (arg_mode == 7) {
+			round_ns = atoi(argv[i]) * 1000000LL;
+			valid = round_ns > 0;
+			arg_mode = 0;
+		} else if (arg_mode == 8) {
+			baseline_file = argv[i];
+			arg_mode = 0;
+		} else if (arg_mode == 9) {
+			tolerance = atof(argv[i]);
+			valid = tolerance >= 0;
+			arg_mode = 0;
+		} else if (strcmp(argv[i], "-b") == 0) {
+			arg_mode = 1;
+		} else if (strcmp(argv[i], "-m") == 0) {
+			arg_mode = 2;
+		} else if (strcmp(argv[i], "-c") == 0) {
+			arg_mode = 3;
+		} else if (strcmp(argv[i], "-l") == 0) {
+			arg_mode = 4;
+		} else if (strcmp(argv[i], "-r") == 0) {
+			arg_mode = 5;
+		} else if (strcmp(argv[i], "-n") == 0) {
+			arg_mode = 6;
+		} else if (strcmp(argv[i], "-d") == 0) {
+			arg_mode = 7;
+		} else if (strcmp(argv[i], "-B") == 0) {
+			arg_mode = 8;
+		} else if (strcmp(argv[i], "-t") == 0) {
+			arg_mode = 9;
+		} else {
+			std::cerr << "Unknown option " << argv[i] << std::endl;
+			return 1;
+		}
+		if (!valid) {
+			std::cerr << "Invalid value " << argv[i] << " for " << argv[i - 1] << std::endl;
+			return 1;
+		}
+	}
+
+	std::map<std::string, result_t> baseline;
+	if (baseline_file != nullptr && !readBaseline(baseline_file, baseline)) {
+		std::cerr << "Cannot read baseline " << baseline_file << std::endl;
+		return 1;
+	}
+
+	std::cout << "benchmark,modules,columns,history,ratio,unit,ops,ns_per_op,allocs_per_op,ops_per_s,bytes_per_op" << std::endl;
+	int regressions = 0;
+	bench_config_t config;
+	for (auto &name : names) {
+		for (int module_count : modules) {
+			for (int column_count : columns) {
+				for (int history : histories) {
+					for (int ratio : ratios) {
+						config.modules = module_count;
+						config.columns = column_count;
+						config.history = history;
+						config.ratio = ratio;
+						result_t result = measure(name, config, rounds, round_ns);
+						std::string key = resultKey(name, config);
+						char values[160];
+						snprintf(values, sizeof (values), "%s,%llu,%.1f,%.2f,%.0f,%.1f", result.unit,
+								static_cast<unsigned long long> (result.ops), result.ns_per_op, result.allocs_per_op,
+								1000000000.0 / result.ns_per_op, result.bytes_per_op);
+						std::cout << key << "," << values << std::endl;
+
+						// time and allocations may grow by the tolerance, allocations also by a rounding error
+						if (baseline_file == nullptr) continue;
+						auto base = baseline.find(key);
+						if (base == baseline.end()) {
+							std::cerr << key << ": not in the baseline" << std::endl;
+							continue;
+						}
+						double time_change = 100.0 * (result.ns_per_op / base->second.ns_per_op - 1.0);
+						bool slower = result.ns_per_op > base->second.ns_per_op * (1.0 + tolerance / 100.0);
+						bool allocating = result.allocs_per_op > base->second.allocs_per_op * (1.0 + tolerance / 100.0) + 0.01;
+						char report[200];
+						snprintf(report, sizeof (report), "%s: %+.1f %% ns/op (%.1f -> %.1f), allocs/op %.2f -> %.2f%s",
+								key.c_str(), time_change, base->second.ns_per_op, result.ns_per_op,
+								base->second.allocs_per_op, result.allocs_per_op, slower || allocating ? ", REGRESSION" : "");
+						std::cerr << report << std::endl;
+						if (slower || allocating) ++regressions;
+					}
+				}
+			}
+		}
+	}
+
+	if (regressions > 0) {
+		std::cerr << regressions << " regressions against " << baseline_file << std::endl;
+		return 2;
+	}
+	return 0;
+
+}
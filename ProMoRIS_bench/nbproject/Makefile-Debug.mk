@@ -0,0 +1,143 @@
+#
+# Generated Makefile - do not edit!
+#
+# Edit the Makefile in the project folder instead (../Makefile). Each target
+# has a -pre and a -post target defined where you can add customized code.
+#
+# This makefile implements configuration specific macros and targets.
+
+
+# Environment
+MKDIR=mkdir
+CP=cp
+GREP=grep
+NM=nm
+CCADMIN=CCadmin
+RANLIB=ranlib
+CC=gcc
+CCC=g++
+CXX=g++
+FC=gfortran
+AS=as
+
+# Macros
+CND_PLATFORM=GNU-Linux
+CND_DLIB_EXT=so
+CND_CONF=Debug
+CND_DISTDIR=dist
+CND_BUILDDIR=build
+
+# Include project Makefile
+include Makefile
+
+# Object Directory
+OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
+
+# Object Files
+OBJECTFILES= \
+	${OBJECTDIR}/_ext/ProMoRIS/aggregator.o \
+	${OBJECTDIR}/_ext/ProMoRIS/alignment.o \
+	${OBJECTDIR}/_ext/ProMoRIS/binlog.o \
+	${OBJECTDIR}/_ext/ProMoRIS/changefilter.o \
+	${OBJECTDIR}/_ext/ProMoRIS/encoder.o \
+	${OBJECTDIR}/_ext/ProMoRIS/scheduler.o \
+	${OBJECTDIR}/_ext/ProMoRIS/writer.o \
+	${OBJECTDIR}/_ext/ProMoRIS_modNethogs/nethogsparser.o \
+	${OBJECTDIR}/_ext/ProMoRIS_modTop/topparser.o \
+	${OBJECTDIR}/benchmarks.o \
+	${OBJECTDIR}/main.o
+
+
+# C Compiler Flags
+CFLAGS=
+
+# CC Compiler Flags
+CCFLAGS=-pthread
+CXXFLAGS=-pthread
+
+# Fortran Compiler Flags
+FFLAGS=
+
+# Assembler Flags
+ASFLAGS=
+
+# Link Libraries and Options
+LDLIBSOPTIONS=
+
+# Build Targets
+.build-conf: ${BUILD_SUBPROJECTS}
+	"${MAKE}"  -f nbproject/Makefile-${CND_CONF}.mk ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/promoris-bench
+
+${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/promoris-bench: ${OBJECTFILES}
+	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
+	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/promoris-bench ${OBJECTFILES} ${LDLIBSOPTIONS}
+
+${OBJECTDIR}/_ext/ProMoRIS/aggregator.o: ../ProMoRIS/aggregator.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/aggregator.o ../ProMoRIS/aggregator.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/alignment.o: ../ProMoRIS/alignment.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/alignment.o ../ProMoRIS/alignment.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/binlog.o: ../ProMoRIS/binlog.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/binlog.o ../ProMoRIS/binlog.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/changefilter.o: ../ProMoRIS/changefilter.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/changefilter.o ../ProMoRIS/changefilter.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/encoder.o: ../ProMoRIS/encoder.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/encoder.o ../ProMoRIS/encoder.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/scheduler.o: ../ProMoRIS/scheduler.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/scheduler.o ../ProMoRIS/scheduler.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/writer.o: ../ProMoRIS/writer.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/writer.o ../ProMoRIS/writer.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS_modNethogs/nethogsparser.o: ../ProMoRIS_modNethogs/nethogsparser.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS_modNethogs
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS_modNethogs/nethogsparser.o ../ProMoRIS_modNethogs/nethogsparser.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS_modTop/topparser.o: ../ProMoRIS_modTop/topparser.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS_modTop
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS_modTop/topparser.o ../ProMoRIS_modTop/topparser.cpp
+
+${OBJECTDIR}/benchmarks.o: benchmarks.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/benchmarks.o benchmarks.cpp
+
+${OBJECTDIR}/main.o: main.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++17 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/main.o main.cpp
+
+# Subprojects
+.build-subprojects:
+
+# Clean Targets
+.clean-conf: ${CLEAN_SUBPROJECTS}
+	${RM} -r ${CND_BUILDDIR}/${CND_CONF}
+
+# Subprojects
+.clean-subprojects:
+
+# Enable dependency checking
+.dep.inc: .depcheck-impl
+
+include .dep.inc
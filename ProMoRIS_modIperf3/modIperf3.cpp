@@ -23,203 +23,574 @@
 #include <stdio.h>
 #include <regex>
 #include <cstring>
-#include <spawn.h>
+#include <cerrno>
+#include <algorithm>
+#include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
 #include "rapidjson/document.h"
+#include "rapidjson/reader.h"
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/error/en.h"
 #include <fstream>
 #include <fcntl.h>
 
-// definitions
-param_t modIperf3::param;
-bool modIperf3::stopmon;
-std::thread modIperf3::t1;
-std::vector<std::vector<std::string>> modIperf3::values;
-std::mutex modIperf3::values_m;
+// shortest reporting interval of iperf3 in seconds
+#define IPERF3_MIN_INTERVAL 0.1
+// start of every record of --json-stream
+#define IPERF3_STREAM_RECORD "{\"event\""
+// fields of the sample filled from the records (bps_sent .. cpu_system)
+#define IPERF3_FIRST_FIELD 1
+#define IPERF3_LAST_FIELD 5
 
-int modIperf3::runMon() {
+/*
+ * SAX handler of the output of a test with -J: the document is parsed token by token while it arrives,
+ * the handler collects the values of the current interval and of the summary and tells the module
+ * when one of them is complete (done flags), only the keys of the enclosing objects are kept.
+ */
+struct iperf3_document_t : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, iperf3_document_t> {
+	rapidjson::Reader reader;
+	// a document was started and is not complete yet
+	bool open;
+	// a parsing error occurred, the rest of the document is skipped
+	bool failed;
+	// text received but not parsed yet
+	std::string pending;
+	// names of the enclosing objects and arrays ("$" for the document, "[]" for array elements)
+	std::vector<std::string> path;
+	std::vector<bool> arrays;
+	// key of the next value
+	std::string key;
+
+	// "sum" of the current element of "intervals"
+	bool in_interval;
+	bool has_sum;
+	bool has_bps;
+	double bps;
+	bool sender;
+	double end;
+	bool interval_done;
+	// "end" summary of the test
+	sample_t summary;
+	unsigned summary_set;
+	bool summary_done;
+	// "start" record
+	bool has_start;
+	int64_t timesecs;
+	// "error" of iperf3
+	std::string error;
+
+	iperf3_document_t() : open(false), failed(false) {
+		reset();
+	}
 
-	// server could be passed as first -o parameter
-	char* i_server;
-	if (param.options.size() >= 1) i_server = const_cast<char*> (param.options[0].c_str());
-	else i_server = "localhost";
+	void reset() {
+		path.clear();
+		arrays.clear();
+		key.clear();
+		in_interval = interval_done = summary_done = has_start = false;
+		summary_set = 0;
+		error.clear();
+	}
 
-	// port could be passed as second -o parameter
-	char* i_port;
-	if (param.options.size() > 1) i_port = const_cast<char*> (param.options[1].c_str());
-	else i_port = "5201";
+	// path is $.name1.name2...
+	bool at(std::initializer_list<const char*> names) const {
+		if (path.size() != names.size() + 1) return false;
+		size_t depth = 1;
+		for (const char* name : names) {
+			if (path[depth++] != name) return false;
+		}
+		return true;
+	}
 
-	// time could be passed as third
-	char* i_time;
-	if (param.options.size() > 2) i_time = const_cast<char*> (param.options[2].c_str());
-	else i_time = "5";
+	bool Key(const char* text, rapidjson::SizeType length, bool copy) {
+		key.assign(text, length);
+		return true;
+	}
 
-	// sleep could be passed as fourth
-	int i_sleep;
-	if (param.options.size() > 3) i_sleep = std::stoi(param.options[3]);
-	else i_sleep = 10;
+	bool StartObject() {
+		return start(false);
+	}
 
-	// omit could be passed as fifth
-	char* i_omit;
-	if (param.options.size() > 4) i_omit = const_cast<char*> (param.options[4].c_str());
-	else i_omit = "0";
+	bool StartArray() {
+		return start(true);
+	}
 
-	// arguments
-	char* ps_args[] = {"iperf3", "-c", i_server, "-p", i_port, "-J",
-		"-t", i_time, "-O", i_omit, "-i", "0", nullptr};
-	
-	// open JSON file if option is set
-	std::ofstream tracefile;
-	bool trace = false;
-	if (param.options.size() > 5) {
-		trace = true;
-		tracefile.open(param.options[5]);
-		if (!tracefile.is_open()) {
-			std::cerr << "modIperf3: trace file could not be opened" << std::endl;
-			return 1;
+	bool start(bool array) {
+		path.push_back(path.empty() ? "$" : key);
+		arrays.push_back(array);
+		if (at({"intervals", "[]"})) {
+			in_interval = true;
+			has_sum = has_bps = false;
+			sender = true;
+			end = 0.0;
+		}
+		key = array ? "[]" : "";
+		return true;
+	}
+
+	bool EndObject(rapidjson::SizeType members) {
+		if (at({"intervals", "[]"})) {
+			in_interval = false;
+			interval_done = has_sum;
+		} else if (at({"intervals", "[]", "sum"})) {
+			has_sum = true;
+		} else if (at({"end"})) {
+			summary_done = true;
 		}
+		return finish();
 	}
 
-	while (!stopmon) {
+	bool EndArray(rapidjson::SizeType elements) {
+		return finish();
+	}
 
-		// to spawn iperf3 process
-		int ps_exit;
-		int ps_cout[2];
-		posix_spawn_file_actions_t ps_action;
+	bool finish() {
+		path.pop_back();
+		arrays.pop_back();
+		key = !arrays.empty() && arrays.back() ? "[]" : "";
+		return true;
+	}
 
-		if (pipe(ps_cout)) {
-			std::cerr << "modIperf3: could not create pipe" << std::endl;
-			stopmon = true;
-			return 1;
+	bool number(double value) {
+		if (in_interval && at({"intervals", "[]", "sum"})) {
+			if (key == "bits_per_second") {
+				has_bps = true;
+				bps = value;
+			} else if (key == "end") {
+				end = value;
+			}
+		} else if (key == "bits_per_second" && (at({"end", "sum_sent"}) || at({"end", "sum_received"}))) {
+			int field_i = path.back() == "sum_sent" ? 1 : 2;
+			summary.fields[field_i].i = static_cast<int64_t> (value);
+			summary_set |= 1u << field_i;
+		} else if (at({"end", "cpu_utilization_percent"})) {
+			int field_i = key == "host_total" ? 3 : key == "host_user" ? 4 : key == "host_system" ? 5 : 0;
+			if (field_i > 0) {
+				summary.fields[field_i].d = value;
+				summary_set |= 1u << field_i;
+			}
+		} else if (key == "timesecs" && at({"start", "timestamp"})) {
+			has_start = true;
+			timesecs = static_cast<int64_t> (value);
 		}
+		return true;
+	}
 
-		// redirect stdout
-		posix_spawn_file_actions_init(&ps_action);
-		posix_spawn_file_actions_addclose(&ps_action, ps_cout[0]);
-		posix_spawn_file_actions_adddup2(&ps_action, ps_cout[1], 1);
-		posix_spawn_file_actions_addclose(&ps_action, ps_cout[1]);
+	bool Int(int value) {
+		return number(value);
+	}
 
-		pid_t ps_pid;
-		if (posix_spawnp(&ps_pid, "/usr/bin/iperf3", &ps_action, nullptr, ps_args, nullptr) != 0) {
-			std::cerr << "modIperf3: posix_spawnp failed with error: " << strerror(errno) << std::endl;
-			stopmon = true;
-			return 1;
-		}
-		close(ps_cout[1]);
-		waitpid(ps_pid, &ps_exit, 0);
+	bool Uint(unsigned value) {
+		return number(value);
+	}
 
-		const size_t ps_buffer_size = 1024;
-		std::string ps_buffer;
-		ps_buffer.resize(ps_buffer_size);
-		ssize_t ps_read;
-		std::string ps_out;
-		int readflags = fcntl(ps_cout[0], F_GETFL, 0);
-		fcntl(ps_cout[0], F_SETFL, readflags | O_NONBLOCK);
-		while ((ps_read = read(ps_cout[0], &ps_buffer[0], ps_buffer_size)) > 0) {
-			ps_out.append(ps_buffer.substr(0, ps_read + 1));
-		}
+	bool Int64(int64_t value) {
+		return number(static_cast<double> (value));
+	}
 
-		posix_spawn_file_actions_destroy(&ps_action);
+	bool Uint64(uint64_t value) {
+		return number(static_cast<double> (value));
+	}
 
-		// write JSON file if option is set
-		if (trace) tracefile << ps_out;
+	bool Double(double value) {
+		return number(value);
+	}
 
-		// process JSON
-		rapidjson::Document json_d;
-		json_d.Parse<rapidjson::kParseStopWhenDoneFlag>(ps_out.c_str());
+	bool Bool(bool value) {
+		if (key == "sender" && at({"intervals", "[]", "sum"})) sender = value;
+		return true;
+	}
 
-		if (json_d.HasParseError()) {
-			fprintf(stderr, "modIperf3: JSON parsing error (offset %u): %s\n",
-					(unsigned) json_d.GetErrorOffset(),
-					rapidjson::GetParseError_En(json_d.GetParseError()));
-			stopmon = true;
-			return 1;
-		}
+	bool String(const char* text, rapidjson::SizeType length, bool copy) {
+		if (key == "error" && path.size() == 1) error.assign(text, length);
+		return true;
+	}
+
+	// the next token is complete in pending after pos (JSON tokens never span lines),
+	// the reader fails at the end of the text after a separator, so the token after it must be there too
+	bool tokenAvailable(size_t pos) const {
+		pos = pending.find_first_not_of(" \t\r\n", pos);
+		if (pos == std::string::npos) return false;
+		if (pending[pos] != ',' && pending[pos] != ':') return true;
+		return pending.find_first_not_of(" \t\r\n", pos + 1) != std::string::npos;
+	}
+};
+
+modIperf3::modIperf3() : stopmon(true), sleep_ns(0), json_stream(false), iperf_pid(0),
+iperf_fd(-1), pipe_source(-1), process_source(-1), restart_timer(-1), json_document(new iperf3_document_t),
+test_start(0), test_end(0), converting(false) {
+	memset(&held, 0, sizeof (held));
+}
+
+modIperf3::~modIperf3() {
+	stopMon();
+}
+
+// --json-stream was added in iperf3 3.17
+bool modIperf3::supportsJsonStream() {
+	FILE* fp = popen("iperf3 --version 2>/dev/null", "r");
+	if (fp == nullptr) return false;
+	int major = 0, minor = 0;
+	char line[256];
+	if (fgets(line, sizeof (line), fp) != nullptr) sscanf(line, "iperf %d.%d", &major, &minor);
+	pclose(fp);
+	return major > 3 || (major == 3 && minor >= 17);
+}
+
+// publish a sample with the values of update whose fields are set in the bit mask set,
+// fields missing in the records keep their last value
+void modIperf3::publish(int64_t timestamp, const sample_t& update, unsigned set) {
+	sample_t* sample = values.claim();
+	*sample = held;
+	sample->time = timestamp;
+	for (int field_i = IPERF3_FIRST_FIELD; field_i <= IPERF3_LAST_FIELD; ++field_i) {
+		if (set & (1u << field_i)) sample->fields[field_i] = update.fields[field_i];
+	}
+	held = *sample;
+	values.publish();
+}
+
+// publish the "sum" of an interval which ended end seconds after the start of the test
+// intervals are reported by the sending side, unless the test runs in reverse mode
+void modIperf3::publishInterval(double end, bool has_bps, double bps, bool sender) {
+	sample_t update;
+	unsigned set = 0;
+	if (has_bps) {
+		int field_i = sender ? 1 : 2;
+		update.fields[field_i].i = static_cast<int64_t> (bps);
+		set |= 1u << field_i;
+	}
+	publish(intervalTime(end), update, set);
+}
+
+// time stamp of the start of a test from its "start" record, converted traces use the times of iperf3
+void modIperf3::startRecord(int64_t timesecs) {
+	if (!converting) return;
+	test_start = timesecs * SAMPLE_TIME_PER_SECOND;
+	test_end = test_start;
+}
+
+// time stamp of an interval which ended end seconds after the start of the test:
+// for converted traces the start of the test reported by iperf3 plus end, for -J output (written by iperf3
+// at the end of the test) the start of iperf3 plus end, otherwise now
+int64_t modIperf3::intervalTime(double end) {
+	int64_t now = sampleTime();
+	if (!converting && (json_stream || param.replay_speed >= 0)) return now;
+	test_end = test_start + static_cast<int64_t> (end * SAMPLE_TIME_PER_SECOND);
+	return converting ? test_end : std::min(test_end, now);
+}
+
+// one line of --json-stream output: {"event": "start" | "interval" | "end" | "error", "data": ...}
+void modIperf3::parseStreamLine(const char* line) {
+	rapidjson::Document json_d;
+	json_d.Parse(line);
+	if (json_d.HasParseError() || !json_d.IsObject() || !json_d.HasMember("event") || !json_d["event"].IsString()) {
+		fprintf(stderr, "modIperf3: JSON parsing error (offset %u): %s\n",
+				(unsigned) json_d.GetErrorOffset(),
+				rapidjson::GetParseError_En(json_d.GetParseError()));
+		return;
+	}
+
+	const char* event = json_d["event"].GetString();
+	if (!json_d.HasMember("data")) return;
+	const rapidjson::Value& data = json_d["data"];
 
-		// pass output
-		std::stringstream timeGen;
-		timeGen << time(nullptr);
-
-		assert(json_d.IsObject());
-
-		if (json_d.HasMember("error") && json_d["error"].IsString()) {
-			std::cerr << "modIperf3: iperf3 error: " << json_d["error"].GetString() << std::endl;
-		} else {
-
-			assert(json_d.HasMember("end"));
-			assert(json_d["end"].HasMember("sum_sent"));
-			assert(json_d["end"]["sum_sent"].HasMember("bits_per_second"));
-			assert(json_d["end"].HasMember("sum_received"));
-			assert(json_d["end"]["sum_received"].HasMember("bits_per_second"));
-			assert(json_d["end"].HasMember("cpu_utilization_percent"));
-			assert(json_d["end"]["cpu_utilization_percent"].HasMember("host_total"));
-			assert(json_d["end"]["cpu_utilization_percent"].HasMember("host_user"));
-			assert(json_d["end"]["cpu_utilization_percent"].HasMember("host_system"));
-
-			// write current timestamp and relevant values to values array
-			{
-				std::lock_guard<std::mutex> values_guard(values_m);
-				values.push_back(std::vector<std::string>{timeGen.str(),
-					std::to_string(static_cast<long> (json_d["end"]["sum_sent"]["bits_per_second"].GetDouble())),
-					std::to_string(static_cast<long> (json_d["end"]["sum_received"]["bits_per_second"].GetDouble())),
-					std::to_string(json_d["end"]["cpu_utilization_percent"]["host_total"].GetDouble()),
-					std::to_string(json_d["end"]["cpu_utilization_percent"]["host_user"].GetDouble()),
-					std::to_string(json_d["end"]["cpu_utilization_percent"]["host_system"].GetDouble())});
+	if (strcmp(event, "start") == 0) {
+		if (data.HasMember("timestamp") && data["timestamp"].HasMember("timesecs")) {
+			startRecord(data["timestamp"]["timesecs"].GetInt64());
+		}
+	} else if (strcmp(event, "interval") == 0) {
+		if (!data.HasMember("sum")) return;
+		const rapidjson::Value& sum = data["sum"];
+		bool has_bps = sum.HasMember("bits_per_second") && sum["bits_per_second"].IsNumber();
+		publishInterval(sum.HasMember("end") ? sum["end"].GetDouble() : 0.0,
+				has_bps, has_bps ? sum["bits_per_second"].GetDouble() : 0.0,
+				!(sum.HasMember("sender") && sum["sender"].IsBool() && !sum["sender"].GetBool()));
+	} else if (strcmp(event, "end") == 0) {
+		sample_t update;
+		unsigned set = 0;
+		if (data.HasMember("sum_sent") && data["sum_sent"].HasMember("bits_per_second")) {
+			update.fields[1].i = static_cast<int64_t> (data["sum_sent"]["bits_per_second"].GetDouble());
+			set |= 1u << 1;
+		}
+		if (data.HasMember("sum_received") && data["sum_received"].HasMember("bits_per_second")) {
+			update.fields[2].i = static_cast<int64_t> (data["sum_received"]["bits_per_second"].GetDouble());
+			set |= 1u << 2;
+		}
+		if (data.HasMember("cpu_utilization_percent")) {
+			const rapidjson::Value& cpu = data["cpu_utilization_percent"];
+			int field_i = 3;
+			for (const char* name : {"host_total", "host_user", "host_system"}) {
+				if (cpu.HasMember(name)) {
+					update.fields[field_i].d = cpu[name].GetDouble();
+					set |= 1u << field_i;
+				}
+				++field_i;
 			}
+		}
+		publish(converting ? test_end : sampleTime(), update, set);
+	} else if (strcmp(event, "error") == 0 && data.IsString()) {
+		std::cerr << "modIperf3: iperf3 error: " << data.GetString() << std::endl;
+	}
+}
+
+// one line of the output of a test with -J, the values are published as soon as an interval
+// or the summary is complete
+void modIperf3::parseDocumentLine(const char* line) {
+	iperf3_document_t& doc = *json_document;
+	// after errors, the rest of the document up to its closing brace is skipped
+	if (doc.failed) {
+		if (strcmp(line, "}") == 0) doc.failed = false;
+		return;
+	}
+	if (!doc.open) {
+		doc.reader.IterativeParseInit();
+		doc.reset();
+		doc.pending.clear();
+		doc.open = true;
+	}
 
+	doc.pending.append(line).append("\n");
+	size_t pos = 0;
+	while (doc.open && doc.tokenAvailable(pos)) {
+		rapidjson::StringStream in(doc.pending.c_str() + pos);
+		if (!doc.reader.IterativeParseNext<rapidjson::kParseStopWhenDoneFlag>(in, doc)) {
+			fprintf(stderr, "modIperf3: JSON parsing error (offset %u): %s\n",
+					(unsigned) (pos + doc.reader.GetErrorOffset()),
+					rapidjson::GetParseError_En(doc.reader.GetParseErrorCode()));
+			doc.open = false;
+			doc.failed = strcmp(line, "}") != 0;
+			doc.pending.clear();
+			return;
 		}
+		pos += in.Tell();
 
-		if (!stopmon) sleep(i_sleep);
+		if (doc.has_start) {
+			startRecord(doc.timesecs);
+			doc.has_start = false;
+		}
+		if (doc.interval_done) {
+			publishInterval(doc.end, doc.has_bps, doc.bps, doc.sender);
+			doc.interval_done = false;
+		}
+		if (doc.summary_done) {
+			// the summary of a failed test is empty
+			if (doc.summary_set != 0) publish(converting ? test_end : sampleTime(), doc.summary, doc.summary_set);
+			doc.summary_done = false;
+		}
+		if (doc.reader.IterativeParseComplete()) {
+			if (!doc.error.empty()) std::cerr << "modIperf3: iperf3 error: " << doc.error << std::endl;
+			doc.open = false;
+		}
+	}
+	doc.pending.erase(0, pos);
+}
 
+// one line of a replayed JSON file, records of --json-stream or a line of a -J document
+void modIperf3::replayLine(const char* line) {
+	if (strncmp(line, IPERF3_STREAM_RECORD, sizeof (IPERF3_STREAM_RECORD) - 1) == 0) {
+		parseStreamLine(line);
+		return;
 	}
-	
-	if (trace) tracefile.close();
+	parseDocumentLine(line);
+}
 
-	stopmon = true;
+// start iperf3, its output is read by the event loop while the test is running
+int modIperf3::startTest() {
+	std::vector<const char*> argv;
+	for (auto &arg : args) argv.push_back(arg.c_str());
+	argv.push_back(nullptr);
+
+	iperf_fd = spawnProcess(argv.data(), iperf_pid);
+	if (iperf_fd < 0) {
+		std::cerr << "modIperf3: could not start iperf3: " << strerror(errno) << std::endl;
+		stopmon = true;
+		return 1;
+	}
+	test_start = sampleTime();
+	// the output of an aborted test is not continued
+	json_document->open = json_document->failed = false;
+
+	pipe_source = param.reactor->addLines(iperf_fd, [this](const char* line) {
+		if (tracefile.isOpen()) tracefile.record(line);
+		if (json_stream) parseStreamLine(line);
+		else parseDocumentLine(line);
+	}, [this]() {
+		pipe_source = -1;
+		testFinished();
+	});
+	process_source = param.reactor->addProcess(iperf_pid, [this](pid_t pid) {
+		process_source = -1;
+		testFinished();
+	});
 
 	return 0;
+}
 
+// called when the pipe was closed and when iperf3 terminated,
+// the next test is started after SLEEP when both happened
+void modIperf3::testFinished() {
+	if (pipe_source >= 0 || process_source >= 0) return;
+
+	close(iperf_fd);
+	iperf_fd = -1;
+	int status;
+	waitpid(iperf_pid, &status, 0);
+	iperf_pid = 0;
+
+	restart_timer = param.reactor->addTimer(sampleTime() + sleep_ns, sleep_ns, [this](uint64_t expirations) {
+		param.reactor->remove(restart_timer);
+		restart_timer = -1;
+		startTest();
+	});
 }
 
 void modIperf3::setParameters(param_t sparam) {
 	
 	param = sparam;
+	values.resize(param.buffer_size);
 }
 
 int modIperf3::startMon() {
-	stopmon = false;
-	// start monitoring thread (runMon)
 
-	t1 = std::thread(runMon);
+	// server could be passed as first -o parameter
+	std::string i_server = param.options.size() > 0 ? param.options[0] : "localhost";
+	// port could be passed as second -o parameter
+	std::string i_port = param.options.size() > 1 ? param.options[1] : "5201";
+	// time could be passed as third
+	std::string i_time = param.options.size() > 2 ? param.options[2] : "5";
+	// sleep could be passed as fourth
+	long long sleep_s = 10;
+	if (param.options.size() > 3) {
+		const char* option = param.options[3].c_str();
+		char* end;
+		errno = 0;
+		sleep_s = strtoll(option, &end, 10);
+		if (end == option || *end != '\0' || errno == ERANGE || sleep_s < 0 || sleep_s > INT32_MAX) {
+			std::cerr << "modIperf3: invalid sleep time " << option << std::endl;
+			return 1;
+		}
+	}
+	sleep_ns = sleep_s * SAMPLE_TIME_PER_SECOND;
+	if (sleep_ns < 1) sleep_ns = 1;
+	// omit could be passed as fifth
+	std::string i_omit = param.options.size() > 4 ? param.options[4] : "0";
 
-	return 0;
+	// replay the JSON file instead of running iperf3, the output mode is taken from the records
+	if (param.replay_speed >= 0) {
+		if (param.options.size() < 6 || param.options[5].empty()) {
+			std::cerr << "modIperf3: replay requires JSONFILE" << std::endl;
+			return 1;
+		}
+		stopmon = false;
+		if (!replay.start(param.options[5], param.replay_speed, param.reactor, [this](const char* line) {
+				replayLine(line);
+			}, [this]() {
+				stopmon = true;
+			})) {
+			std::cerr << "modIperf3: trace file could not be read" << std::endl;
+			stopmon = true;
+			return 1;
+		}
+		return 0;
+	}
+
+	// open JSON file if option is set, the format could be passed as eighth -o parameter
+	if (param.options.size() > 5 && !param.options[5].empty()) {
+		bool timed = false;
+		if (param.options.size() > 7 && !traceRecorder::parseFormat(param.options[7], timed)) {
+			std::cerr << "modIperf3: unknown trace format " << param.options[7] << std::endl;
+			return 1;
+		}
+		if (!tracefile.open(param.options[5], timed)) {
+			std::cerr << "modIperf3: trace file could not be opened" << std::endl;
+			return 1;
+		}
+	}
+
+	// output mode could be passed as seventh
+	std::string i_mode = param.options.size() > 6 ? param.options[6] : "auto";
+	if (i_mode == "stream") json_stream = true;
+	else if (i_mode == "json") json_stream = false;
+	else json_stream = supportsJsonStream();
+
+	// report intervals of the ProMoRIS interval
+	double interval = param.interval_micro > 0 ? param.interval_micro / 1e6 : param.interval;
+	if (interval < IPERF3_MIN_INTERVAL) interval = IPERF3_MIN_INTERVAL;
+	char i_interval[32];
+	snprintf(i_interval, sizeof (i_interval), "%g", interval);
+
+	args = {"iperf3", "-c", i_server, "-p", i_port, "-t", i_time, "-O", i_omit,
+		"-i", i_interval, json_stream ? "--json-stream" : "-J"};
+
+	stopmon = false;
+	return startTest();
 }
 
 int modIperf3::stopMon() {
 	stopmon = true;
-	t1.join();
+	if (pipe_source >= 0) param.reactor->remove(pipe_source);
+	if (process_source >= 0) param.reactor->remove(process_source);
+	if (restart_timer >= 0) param.reactor->remove(restart_timer);
+	pipe_source = process_source = restart_timer = -1;
+	if (iperf_fd >= 0) {
+		close(iperf_fd);
+		iperf_fd = -1;
+	}
+	if (iperf_pid > 0) {
+		kill(-iperf_pid, SIGTERM);
+		waitpid(iperf_pid, nullptr, 0);
+		iperf_pid = 0;
+	}
+	replay.stop();
+	json_document->open = json_document->failed = false;
+	tracefile.close();
 	return 0;
 }
 
+bool modIperf3::convertTrace() {
+	if (param.options.size() < 6 || param.options[5].empty()) {
+		std::cerr << "modIperf3: conversion requires JSONFILE" << std::endl;
+		return false;
+	}
+	traceFile trace;
+	if (!trace.open(param.options[5])) {
+		std::cerr << "modIperf3: trace file could not be read" << std::endl;
+		return false;
+	}
+
+	// at most one sample per interval and test summary
+	values.resize(trace.count("\"sum\"") + trace.count("\"end\"") + 1);
+
+	// the records are published with the time stamps of iperf3 instead of the times of the trace,
+	// so traces without time stamps are converted as well
+	converting = true;
+	const char* line;
+	int64_t time;
+	while (trace.next(line, time)) replayLine(line);
+	converting = false;
+	json_document->open = json_document->failed = false;
+	return true;
+}
+
 bool modIperf3::running() {
 	return !stopmon;
 }
 
-std::vector<std::vector<std::string>> *modIperf3::getValuesPtr() {
+sampleBuffer * modIperf3::getBuffer() {
 	return &values;
 }
 
-std::mutex * modIperf3::getValuesMPtr() {
-	return &values_m;
-}
-
 std::vector<std::string> modIperf3::getLabels() {
 	return {"time", "bps_sent", "bps_received", "cpu_total", "cpu_user", "cpu_system"};
 }
 
+std::vector<field_type_t> modIperf3::getColTypes() {
+	return {FIELD_TIME, FIELD_INT64, FIELD_INT64, FIELD_DOUBLE, FIELD_DOUBLE, FIELD_DOUBLE};
+}
+
 std::vector<int> modIperf3::getColMaxSize() {
 	return {10, 12, 12, 10, 10, 10};
 }
@@ -232,11 +603,15 @@ extern "C" void destroyMod(module* p) {
 	delete p;
 }
 
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
 extern "C" const char* getHelp() {
 	return "Module usage:\n"
 	"-m MODIPERF3 [-p PREFIX] [-c time] [-c bps_sent] [-c bps_received] "
 	"[-c cpu_total] [-c cpu_user] [-c cpu_system] "
-	"[-o SERVER [-o PORT [-o TIME [-o SLEEP [-o OMIT [-o JSONFILE]]]]]]\n\n"
+	"[-o SERVER [-o PORT [-o TIME [-o SLEEP [-o OMIT [-o JSONFILE [-o MODE [-o TRACEFORMAT]]]]]]]]\n\n"
 	"Columns:\n"
 	"time: UNIX timestamp when snapshot was taken\n"
 	"bps_sent: Sending bit rate (bit/s)\n"
@@ -250,5 +625,17 @@ extern "C" const char* getHelp() {
 	"TIME = 5 -- the time the iperf3 test should be running for (in seconds)\n"
 	"SLEEP = 10 -- the sleep time between to iperf3 tests (in seconds)\n"
 	"OMIT = 0 -- omit the first OMIT seconds of the tests for statistics\n"
-	"JSONFILE -- if set, writes the raw iperf3 JSON output to JSONFILE";
+	"JSONFILE -- if set, writes the raw iperf3 JSON output to JSONFILE (pass an empty string\n"
+	"to skip), with promoris -r the JSON output is replayed instead of running iperf3, promoris --convert\n"
+	"converts it with the time stamps reported by iperf3\n"
+	"MODE = auto -- stream: read one JSON record per interval while the test is running (--json-stream,\n"
+	"iperf3 3.17 or newer), json: read the complete JSON output at the end of the test (-J),\n"
+	"auto: stream if supported by the installed iperf3\n"
+	"TRACEFORMAT = raw -- raw: the JSON output unchanged, timed: a #promoris-trace header and\n"
+	"OFFSET<TAB>LINE lines with the time each line was received (ns), so -r keeps the original timing\n\n"
+	"iperf3 reports a sample every INTERVAL of ProMoRIS (at least 0.1 s). With MODE json, iperf3 writes\n"
+	"its output at the end of the test, it is parsed while it arrives and every interval is published\n"
+	"as soon as it is complete, with the time stamp of the end of the interval.\n"
+	"Interval samples only contain the bit rate of the sending side, the other columns\n"
+	"keep the values of the last test summary until the test ends.";
 }
@@ -24,10 +24,16 @@
 #include <string>
 #include <vector>
 #include <tuple>
-#include <thread>
+#include <atomic>
 #include <mutex>
 #include <array>
+#include <fstream>
+#include <memory>
 #include "../ProMoRIS/module.h"
+#include "../ProMoRIS/trace.h"
+
+// parser state of the output of a test with -J, defined in modIperf3.cpp
+struct iperf3_document_t;
 
 class modIperf3 : public module {
 public:
@@ -35,19 +41,55 @@ public:
 	int startMon();
 	int stopMon();
 	bool running();
-	std::vector<std::vector<std::string>> * getValuesPtr();
-	std::mutex * getValuesMPtr();
+	sampleBuffer * getBuffer();
 	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
 	std::vector<int> getColMaxSize();
-	modIperf3() {}
-	virtual ~modIperf3() {}
+	bool convertTrace();
+	modIperf3();
+	virtual ~modIperf3();
 private:
-	static std::vector<std::vector<std::string>> values;
-	static std::mutex values_m;
-	static param_t param;
-	static bool stopmon;
-	static std::thread t1;
-	static int runMon();
+	sampleBuffer values;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// arguments of iperf3
+	std::vector<std::string> args;
+	// pause between two tests in nanoseconds
+	int64_t sleep_ns;
+	// iperf3 prints one JSON object per line (--json-stream, iperf3 >= 3.17)
+	// instead of a single document at the end of the test (-J)
+	bool json_stream;
+	// write the raw iperf3 JSON output to tracefile
+	traceRecorder tracefile;
+	// replay of the tracefile (promoris -r)
+	traceReplay replay;
+	// running iperf3 process, its stdout and their ids in the event loop
+	pid_t iperf_pid;
+	int iperf_fd;
+	int pipe_source;
+	int process_source;
+	// id of the timer starting the next test
+	int restart_timer;
+	// output of a test without --json-stream, parsed while it arrives
+	std::unique_ptr<iperf3_document_t> json_document;
+	// time stamp of the start of the current test
+	int64_t test_start;
+	// time stamp of the latest interval of a converted test
+	int64_t test_end;
+	// the trace is converted (promoris --convert)
+	bool converting;
+	// values are held until they are updated, interval records only contain the throughput
+	sample_t held;
+	static bool supportsJsonStream();
+	int startTest();
+	void testFinished();
+	void parseStreamLine(const char* line);
+	void parseDocumentLine(const char* line);
+	void replayLine(const char* line);
+	void startRecord(int64_t timesecs);
+	int64_t intervalTime(double end);
+	void publish(int64_t timestamp, const sample_t& update, unsigned set);
+	void publishInterval(double end, bool has_bps, double bps, bool sender);
 };
 
 #endif /* MODIPERF3_H */
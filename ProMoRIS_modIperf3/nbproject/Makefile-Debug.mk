@@ -35,6 +35,7 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/_ext/ProMoRIS/trace.o \
 	${OBJECTDIR}/modIperf3.o
 
 
@@ -67,6 +68,11 @@ ${OBJECTDIR}/modIperf3.o: modIperf3.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/modIperf3.o modIperf3.cpp
 
+${OBJECTDIR}/_ext/ProMoRIS/trace.o: ../ProMoRIS/trace.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/trace.o ../ProMoRIS/trace.cpp
+
 # Subprojects
 .build-subprojects:
 
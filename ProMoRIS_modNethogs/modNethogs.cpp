@@ -21,132 +21,155 @@
 #include <iostream>
 #include <sstream>
 #include <stdio.h>
-#include <regex>
 #include <cstring>
+#include <algorithm>
 #include <fstream>
+#include <signal.h>
+#include <sys/wait.h>
 
-// definitions
-param_t modNethogs::param;
-bool modNethogs::stopmon;
-std::thread modNethogs::t1;
-std::vector<std::vector<std::string>> modNethogs::values;
-std::mutex modNethogs::values_m;
-
-int modNethogs::runMon() {
-
-	// file handle to read command with popen
-	FILE *fp;
-	// one line of the top output
-	char line[1000];
-	// string array of the relevant values from the current line
-	std::string current_values[3];
-	// popen/pclose status
-	int status;
-	// space to save the values from the current line
-	std::vector<std::string> nhvalues;
+modNethogs::modNethogs() : stopmon(true), nethogs_fd(-1), nethogs_pid(0), source(-1) {
+}
 
-	// start nethogs and open pipe
-	std::string n_iface;
-	if (param.options.size() > 0) n_iface = param.options[0] + " ";
-	else n_iface = "";
-	std::string cmd = "COLUMNS=998 LINES=50 LC_NUMERIC=en_US nethogs " + n_iface + "-d " + std::to_string(param.interval) + " -t 2>/dev/null";
-	const char * cmdc = cmd.c_str();
-	fp = popen(cmdc, "r");
+modNethogs::~modNethogs() {
+	stopMon();
+}
 
-	if (fp == NULL) {
-		std::cerr << "modNethogs: Opening command failed" << std::endl;
-		return 1;
-	}
+// parse one line of the nethogs output
+void modNethogs::parseLine(const char* line) {
 
-	int lineCount = 0;
+	// write to tracefile
+	if (tracefile.isOpen()) tracefile.record(line);
 
-	// open tracefile if option is set
-	std::ofstream tracefile;
-	bool trace = false;
-	if (param.options.size() > 1) {
-		trace = true;
-		tracefile.open(param.options[1]);
-		if (!tracefile.is_open()) {
-			std::cerr << "modNethogs: trace file could not be opened" << std::endl;
-			return 1;
-		}
-	}
+	parser.parseLine(line);
 
-	while (fgets(line, 1000, fp) != NULL) {
+}
 
-		// write to tracefile
-		if (trace) tracefile << line;
+void modNethogs::setParameters(param_t sparam) {
+	param = sparam;
+	values.resize(param.buffer_size);
+	parser = nethogsParser(param.pid, &values);
 
-		// extract the values we need via regex
-		std::regex explode("/" + (param.pid) + "/[0-9]+\\t+([0-9]+\\.?[0-9]*)\\t+([0-9]+\\.?[0-9]*)");
-		std::smatch nethogs_values;
-		std::string line_s = line;
-		// if the line contains information about the process being monitored
-		if (std::regex_search(line_s, nethogs_values, explode)) {
+}
 
-			std::stringstream timeGen;
-			timeGen << time(nullptr);
+int modNethogs::startMon() {
 
-			// write current timestamp and relevant values to values array
-			std::lock_guard<std::mutex> values_guard(values_m);
-			values.push_back(std::vector<std::string>{timeGen.str(),
-				nethogs_values[1], nethogs_values[2]});
+	// replay the tracefile instead of running nethogs
+	if (param.replay_speed >= 0) {
+		if (param.options.size() < 2) {
+			std::cerr << "modNethogs: replay requires TRACEFILE" << std::endl;
+			return 1;
 		}
-
-		if (stopmon == true) break;
+		// refreshes of traces without time stamps are INTERVAL apart like in the conversion
+		int64_t interval_ns = param.interval_micro > 0 ? param.interval_micro * 1000LL : param.interval * SAMPLE_TIME_PER_SECOND;
+		stopmon = false;
+		if (!replay.start(param.options[1], param.replay_speed, param.reactor, [this](const char* line) {
+				parser.parseLine(line);
+			}, [this]() {
+				stopmon = true;
+			}, "Refreshing:", interval_ns)) {
+			std::cerr << "modNethogs: trace file could not be read" << std::endl;
+			stopmon = true;
+			return 1;
+		}
+		return 0;
 	}
 
-	stopmon = true;
-
-	if (trace) tracefile.close();
-
-	status = pclose(fp);
+	// open tracefile if option is set, the format could be passed as third -o parameter
+	if (param.options.size() > 1) {
+		bool timed = false;
+		if (param.options.size() > 2 && !traceRecorder::parseFormat(param.options[2], timed)) {
+			std::cerr << "modNethogs: unknown trace format " << param.options[2] << std::endl;
+			return 1;
+		}
+		if (!tracefile.open(param.options[1], timed)) {
+			std::cerr << "modNethogs: trace file could not be opened" << std::endl;
+			return 1;
+		}
+	}
 
-	if (status == -1) {
-		std::cerr << "modNethogs: Error closing pipe" << std::endl;
+	// start nethogs and open pipe
+	std::string n_iface;
+	if (param.options.size() > 0) n_iface = param.options[0] + " ";
+	else n_iface = "";
+	std::string cmd = "COLUMNS=998 LINES=50 LC_NUMERIC=en_US nethogs " + n_iface + "-d " + std::to_string(param.interval) + " -t 2>/dev/null";
+	nethogs_fd = spawnCommand(cmd, nethogs_pid);
+	if (nethogs_fd < 0) {
+		std::cerr << "modNethogs: Opening command failed" << std::endl;
 		return 1;
 	}
 
-	return 0;
-
-}
-
-void modNethogs::setParameters(param_t sparam) {
-	param = sparam;
-
-}
-
-int modNethogs::startMon() {
+	// the lines are parsed by the event loop of ProMoRIS
 	stopmon = false;
-	
-	// start monitoring thread (runMon)
-	t1 = std::thread(runMon);
+	source = param.reactor->addLines(nethogs_fd, [this](const char* line) {
+		parseLine(line);
+	}, [this]() {
+		source = -1;
+		stopmon = true;
+	});
 
 	return 0;
 }
 
 int modNethogs::stopMon() {
 	stopmon = true;
-	t1.join();
+	if (source >= 0) param.reactor->remove(source);
+	source = -1;
+	if (nethogs_fd >= 0) {
+		close(nethogs_fd);
+		kill(-nethogs_pid, SIGTERM);
+		waitpid(nethogs_pid, nullptr, 0);
+		nethogs_fd = -1;
+	}
+	replay.stop();
+	tracefile.close();
 	return 0;
 }
 
+bool modNethogs::convertTrace() {
+	if (param.options.size() < 2) {
+		std::cerr << "modNethogs: conversion requires TRACEFILE" << std::endl;
+		return false;
+	}
+	traceFile trace;
+	if (!trace.open(param.options[1])) {
+		std::cerr << "modNethogs: trace file could not be read" << std::endl;
+		return false;
+	}
+
+	// at most one sample per line of the process
+	values.resize(trace.count(("/" + param.pid + "/").c_str()) + 1);
+
+	// refreshes of traces without time stamps are INTERVAL apart, starting at the UNIX epoch
+	int64_t interval_ns = param.interval_micro > 0 ? param.interval_micro * 1000LL : param.interval * SAMPLE_TIME_PER_SECOND;
+	int64_t refresh = 0;
+	const char* line;
+	int64_t time;
+	while (trace.next(line, time)) {
+		if (time < 0) {
+			if (strncmp(line, "Refreshing:", 11) == 0) ++refresh;
+			time = std::max(refresh - 1, (int64_t) 0) * interval_ns;
+		}
+		parser.parseLine(line, time);
+	}
+	return true;
+}
+
 bool modNethogs::running() {
 	return !stopmon;
 }
 
-std::vector<std::vector<std::string>> *modNethogs::getValuesPtr() {
+sampleBuffer * modNethogs::getBuffer() {
 	return &values;
 }
 
-std::mutex * modNethogs::getValuesMPtr() {
-	return &values_m;
-}
-
 std::vector<std::string> modNethogs::getLabels() {
 	return {"time", "sent", "received"};
 }
 
+std::vector<field_type_t> modNethogs::getColTypes() {
+	return {FIELD_TIME, FIELD_DOUBLE, FIELD_DOUBLE};
+}
+
 std::vector<int> modNethogs::getColMaxSize() {
 	return {10, 10, 10};
 }
@@ -159,17 +182,26 @@ extern "C" void destroyMod(module* p) {
 	delete p;
 }
 
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
 extern "C" const char* getHelp() {
 	return "Module usage:\n"
 	"-m MODNETHOGS [-p PREFIX] [-c time] [-c sent] [-c received] "
-	"[-o IFACE [-o TRACEFILE]]\n\n"
+	"[-o IFACE [-o TRACEFILE [-o TRACEFORMAT]]]\n\n"
 	"Columns:\n"
 	"time: UNIX timestamp when snapshot was taken\n"
 	"sent: Sending bit rate (KiB/s)\n"
 	"received: Receiving bit rate (KiB/s)\n\n"
 	"Please note that nethogs must run as root.\n"
-	"The monitoring system with MODNETHOGS therefore also needs to run as root.\n\n"
+	"The monitoring system with MODNETHOGS therefore also needs to run as root.\n"
+	"MODSOCKDIAG provides the TCP rates without packet capture and is preferred.\n\n"
 	"Options and defaults:\n"
 	"IFACE -- the network interface nethogs should listen to (default eth0 or equivalent)\n"
-	"TRACEFILE -- if set, writes the raw nethogs trace to TRACEFILE";
+	"TRACEFILE -- if set, writes the raw nethogs trace to TRACEFILE,\n"
+	"	with promoris -r the trace is replayed instead of running nethogs (IFACE is ignored, no root needed),\n"
+	"	promoris --convert converts it\n"
+	"TRACEFORMAT = raw -- raw: the output of nethogs unchanged, timed: a #promoris-trace header and\n"
+	"	OFFSET<TAB>LINE lines with the time each line was received (ns), so -r keeps the original timing";
 }
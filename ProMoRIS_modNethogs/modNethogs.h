@@ -24,10 +24,13 @@
 #include <string>
 #include <vector>
 #include <tuple>
-#include <thread>
+#include <atomic>
 #include <mutex>
 #include <array>
+#include <fstream>
 #include "../ProMoRIS/module.h"
+#include "../ProMoRIS/trace.h"
+#include "nethogsparser.h"
 
 class modNethogs : public module {
 public:
@@ -35,19 +38,28 @@ public:
 	int startMon();
 	int stopMon();
 	bool running();
-	std::vector<std::vector<std::string>> * getValuesPtr();
-	std::mutex * getValuesMPtr();
+	sampleBuffer * getBuffer();
 	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
 	std::vector<int> getColMaxSize();
-	modNethogs() {}
-	virtual ~modNethogs() {}
+	bool convertTrace();
+	modNethogs();
+	virtual ~modNethogs();
 private:
-	static std::vector<std::vector<std::string>> values;
-	static std::mutex values_m;
-	static param_t param;
-	static bool stopmon;
-	static std::thread t1;
-	static int runMon();
+	sampleBuffer values;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// nethogs process and its stdout
+	int nethogs_fd;
+	pid_t nethogs_pid;
+	// id of the pipe in the event loop
+	int source;
+	// write the raw output of nethogs to tracefile
+	traceRecorder tracefile;
+	// replay of the tracefile (promoris -r)
+	traceReplay replay;
+	nethogsParser parser;
+	void parseLine(const char* line);
 };
 
 #endif /* MODNETHOGS_H */
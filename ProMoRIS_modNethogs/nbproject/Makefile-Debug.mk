@@ -35,7 +35,9 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/modNethogs.o
+	${OBJECTDIR}/_ext/ProMoRIS/trace.o \
+	${OBJECTDIR}/modNethogs.o \
+	${OBJECTDIR}/nethogsparser.o
 
 
 # C Compiler Flags
@@ -67,6 +69,16 @@ ${OBJECTDIR}/modNethogs.o: modNethogs.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/modNethogs.o modNethogs.cpp
 
+${OBJECTDIR}/nethogsparser.o: nethogsparser.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/nethogsparser.o nethogsparser.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/trace.o: ../ProMoRIS/trace.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/trace.o ../ProMoRIS/trace.cpp
+
 # Subprojects
 .build-subprojects:
 
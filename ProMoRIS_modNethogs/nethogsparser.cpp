@@ -0,0 +1,55 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "nethogsparser.h"
+#include <cstdlib>
+#include <cstring>
+
+nethogsParser::nethogsParser(const std::string& pid, sampleBuffer* buffer) : buffer(buffer), marker("/" + pid + "/") {
+}
+
+void nethogsParser::parseLine(const char* line, int64_t time) {
+
+	// the line of the process being monitored: PROGRAM/PID/UID<TAB>SENT<TAB>RECEIVED
+	// scanned without copies, PROGRAM may contain /PID/ as well
+	for (const char* p = strstr(line, marker.c_str()); p != nullptr; p = strstr(p + 1, marker.c_str())) {
+		const char* q = p + marker.size();
+		if (*q < '0' || *q > '9') continue;
+		while (*q >= '0' && *q <= '9') ++q;
+		if (*q != '\t') continue;
+		while (*q == '\t') ++q;
+		char* end;
+		double sent = strtod(q, &end);
+		if (end == q || *end != '\t') continue;
+		q = end;
+		while (*q == '\t') ++q;
+		double received = strtod(q, &end);
+		if (end == q) continue;
+
+		sample_t* sample = buffer->claim();
+		sample->time = time >= 0 ? time : sampleTime();
+		sample->fields[1].d = sent;
+		sample->fields[2].d = received;
+
+		// publish current timestamp and relevant values
+		buffer->publish();
+		return;
+	}
+
+}
@@ -0,0 +1,44 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef NETHOGSPARSER_H
+#define NETHOGSPARSER_H
+
+#include <string>
+#include "../ProMoRIS/module.h"
+
+/*
+ * Parser of the trace output of nethogs (-t): publishes a sample for every line
+ * of the monitored process (PROGRAM/PID/UID, sent and received KiB/s).
+ * Kept apart from modNethogs, so promoris-bench can drive it without nethogs.
+ */
+class nethogsParser {
+public:
+	nethogsParser() : buffer(nullptr) {}
+	// the samples of the lines of process pid are published to buffer
+	nethogsParser(const std::string& pid, sampleBuffer* buffer);
+	// parse one line of the nethogs output received at time (sample_t::time), -1 for now
+	void parseLine(const char* line, int64_t time = -1);
+private:
+	sampleBuffer* buffer;
+	// /PID/ of the monitored process, followed by the UID, sent and received separated by tabs
+	std::string marker;
+};
+
+#endif /* NETHOGSPARSER_H */
@@ -0,0 +1,448 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "modProbe.h"
+#include "../ProMoRIS/probe.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <linux/tcp.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+
+static int64_t monotonicNs() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return static_cast<int64_t> (ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// longest single sleep of a sender thread, bounds the time stopMon waits for it
+#define SLEEP_SLICE_NS 100000000LL
+
+// sleep until the absolute CLOCK_MONOTONIC time deadline_ns or until stop is set
+static void sleepUntil(int64_t deadline_ns, const std::atomic<bool>& stop) {
+	while (!stop) {
+		int64_t wake_ns = std::min<int64_t> (deadline_ns, monotonicNs() + SLEEP_SLICE_NS);
+		timespec ts;
+		ts.tv_sec = wake_ns / 1000000000LL;
+		ts.tv_nsec = wake_ns % 1000000000LL;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR);
+		if (wake_ns == deadline_ns) return;
+	}
+}
+
+// numeric option not below minimum, false on invalid text
+static bool parseOption(const std::string& text, long long minimum, long long& value) {
+	const char* option = text.c_str();
+	char* end;
+	errno = 0;
+	value = strtoll(option, &end, 10);
+	return end != option && *end == '\0' && errno != ERANGE && value >= minimum;
+}
+
+// a closed connection must fail the send call instead of terminating ProMoRIS
+static void blockSigpipe() {
+	sigset_t mask;
+	sigemptyset(&mask);
+	sigaddset(&mask, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+}
+
+modProbe::modProbe() : stopmon(true), udp(false), message_size(0), rate(0), zerocopy(true), memfd(-1),
+timer(-1), last_ns(0), last_rtt_ms(0.0) {
+}
+
+modProbe::~modProbe() {
+	stopMon();
+}
+
+int modProbe::connectStream(const std::string& server, const std::string& port) {
+	addrinfo hints;
+	memset(&hints, 0, sizeof (hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = udp ? SOCK_DGRAM : SOCK_STREAM;
+	addrinfo* result;
+	int error = getaddrinfo(server.c_str(), port.c_str(), &hints, &result);
+	if (error != 0) {
+		std::cerr << "modProbe: could not resolve " << server << ": " << gai_strerror(error) << std::endl;
+		return -1;
+	}
+	int fd = -1;
+	for (addrinfo* address = result; address != nullptr; address = address->ai_next) {
+		fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+		if (fd < 0) continue;
+		if (connect(fd, address->ai_addr, address->ai_addrlen) == 0) break;
+		close(fd);
+		fd = -1;
+	}
+	freeaddrinfo(result);
+	if (fd < 0) {
+		std::cerr << "modProbe: could not connect to " << server << ":" << port << ": " << strerror(errno) << std::endl;
+	}
+	return fd;
+}
+
+// sender thread of a TCP stream
+void modProbe::sendTcp(probe_stream_t* stream) {
+	blockSigpipe();
+	int64_t start_ns = monotonicNs();
+	uint64_t sent = 0;
+	while (!stopmon) {
+		ssize_t n;
+		if (zerocopy) {
+			// the pages of the memfd are passed to the socket without copying
+			off_t offset = 0;
+			n = sendfile(stream->fd, memfd, &offset, message_size);
+		} else {
+			n = send(stream->fd, payload.data(), message_size, MSG_NOSIGNAL);
+		}
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		sent += n;
+		stream->sent_bytes.store(sent, std::memory_order_relaxed);
+		if (rate > 0) sleepUntil(start_ns + static_cast<int64_t> (sent * 8e9 / rate), stopmon);
+	}
+}
+
+// sender thread of a UDP stream, datagrams are sent in batches of up to PROBE_BATCH
+void modProbe::sendUdp(probe_stream_t* stream, uint32_t stream_i) {
+	probe_header_t headers[PROBE_BATCH];
+	iovec iov[PROBE_BATCH][2];
+	mmsghdr messages[PROBE_BATCH];
+	memset(messages, 0, sizeof (messages));
+	for (int i = 0; i < PROBE_BATCH; ++i) {
+		memset(&headers[i], 0, sizeof (probe_header_t));
+		headers[i].magic = PROBE_MAGIC;
+		headers[i].stream = stream_i;
+		headers[i].length = message_size;
+		iov[i][0].iov_base = &headers[i];
+		iov[i][0].iov_len = sizeof (probe_header_t);
+		iov[i][1].iov_base = payload.data();
+		iov[i][1].iov_len = message_size - sizeof (probe_header_t);
+		messages[i].msg_hdr.msg_iov = iov[i];
+		messages[i].msg_hdr.msg_iovlen = 2;
+	}
+
+	// time between two datagrams
+	double gap_ns = rate > 0 ? message_size * 8e9 / rate : 0.0;
+	int64_t start_ns = monotonicNs();
+	uint64_t seq = 0;
+	while (!stopmon) {
+		int64_t now_ns = monotonicNs();
+		int count = PROBE_BATCH;
+		if (rate > 0) {
+			uint64_t due = static_cast<uint64_t> ((now_ns - start_ns) / gap_ns) + 1;
+			if (due <= seq) {
+				sleepUntil(start_ns + static_cast<int64_t> (seq * gap_ns), stopmon);
+				continue;
+			}
+			count = static_cast<int> (std::min<uint64_t> (due - seq, PROBE_BATCH));
+		}
+		for (int i = 0; i < count; ++i) {
+			headers[i].seq = seq + i;
+			headers[i].send_ns = now_ns;
+		}
+		int n = sendmmsg(stream->fd, messages, count, 0);
+		if (n < 0) {
+			// full queues and ICMP errors of a missing responder are counted as loss
+			if (errno == EINTR || errno == ENOBUFS || errno == EAGAIN || errno == ECONNREFUSED) {
+				if (errno == ECONNREFUSED) seq += count;
+				continue;
+			}
+			break;
+		}
+		seq += n;
+		stream->sent_bytes.store(seq * message_size, std::memory_order_relaxed);
+	}
+}
+
+// called by the event loop when echoes of the responder arrived
+void modProbe::receiveEchoes(probe_stream_t* stream) {
+	probe_header_t headers[PROBE_BATCH];
+	iovec iov[PROBE_BATCH];
+	mmsghdr messages[PROBE_BATCH];
+	memset(messages, 0, sizeof (messages));
+	for (int i = 0; i < PROBE_BATCH; ++i) {
+		iov[i].iov_base = &headers[i];
+		iov[i].iov_len = sizeof (probe_header_t);
+		messages[i].msg_hdr.msg_iov = &iov[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int n;
+	while ((n = recvmmsg(stream->fd, messages, PROBE_BATCH, MSG_DONTWAIT, nullptr)) > 0) {
+		int64_t now_ns = monotonicNs();
+		for (int i = 0; i < n; ++i) {
+			const probe_header_t& header = headers[i];
+			if (messages[i].msg_len < sizeof (probe_header_t) || header.magic != PROBE_MAGIC) continue;
+			double rtt_ms = (now_ns - header.send_ns) / 1e6;
+			if (stream->echoed > 0 || stream->expected_seq > 0) {
+				stream->jitter_ms += (std::fabs(rtt_ms - stream->last_rtt_ms) - stream->jitter_ms) / 16.0;
+			}
+			stream->last_rtt_ms = rtt_ms;
+			stream->rtt_sum_ms += rtt_ms;
+			++stream->echoed;
+			stream->echoed_bytes += header.length;
+			// gaps in the sequence are lost, late datagrams fill them again
+			if (header.seq >= stream->expected_seq) {
+				stream->lost += header.seq - stream->expected_seq;
+				stream->expected_seq = header.seq + 1;
+			} else if (stream->lost > 0) {
+				--stream->lost;
+			}
+		}
+		if (n < PROBE_BATCH) break;
+	}
+}
+
+// publish one sample of all streams, called by the timer of the event loop
+void modProbe::sample() {
+	int64_t now_ns = monotonicNs();
+	double seconds = (now_ns - last_ns) / 1e9;
+	last_ns = now_ns;
+	if (seconds <= 0) return;
+
+	uint64_t sent = 0, delivered = 0, lost = 0, total = 0, echoed = 0;
+	double rtt_sum = 0.0, jitter_sum = 0.0;
+	for (auto &stream : streams) {
+		uint64_t sent_bytes = stream->sent_bytes.load(std::memory_order_relaxed);
+		sent += sent_bytes - stream->last_sent_bytes;
+		stream->last_sent_bytes = sent_bytes;
+
+		if (udp) {
+			delivered += stream->echoed_bytes;
+			lost += stream->lost;
+			total += stream->lost + stream->echoed;
+			rtt_sum += stream->rtt_sum_ms;
+			echoed += stream->echoed;
+			jitter_sum += stream->jitter_ms;
+			stream->echoed_bytes = stream->lost = stream->echoed = 0;
+			stream->rtt_sum_ms = 0.0;
+		} else {
+			tcp_info info;
+			socklen_t length = sizeof (info);
+			memset(&info, 0, sizeof (info));
+			if (getsockopt(stream->fd, IPPROTO_TCP, TCP_INFO, &info, &length) != 0) continue;
+			delivered += info.tcpi_bytes_acked - stream->last_acked;
+			lost += info.tcpi_total_retrans - stream->last_retrans;
+			total += info.tcpi_segs_out - stream->last_segs_out;
+			rtt_sum += info.tcpi_rtt / 1000.0;
+			jitter_sum += info.tcpi_rttvar / 1000.0;
+			++echoed;
+			stream->last_acked = info.tcpi_bytes_acked;
+			stream->last_retrans = info.tcpi_total_retrans;
+			stream->last_segs_out = info.tcpi_segs_out;
+		}
+	}
+	if (echoed > 0) last_rtt_ms = rtt_sum / echoed;
+
+	sample_t* sample = values.claim();
+	sample->time = sampleTime();
+	sample->fields[1].i = static_cast<int64_t> (sent * 8 / seconds);
+	sample->fields[2].i = static_cast<int64_t> (delivered * 8 / seconds);
+	sample->fields[3].d = total > 0 ? 100.0 * lost / total : 0.0;
+	sample->fields[4].d = streams.empty() ? 0.0 : jitter_sum / streams.size();
+	sample->fields[5].d = last_rtt_ms;
+	values.publish();
+}
+
+void modProbe::setParameters(param_t sparam) {
+	param = sparam;
+	values.resize(param.buffer_size);
+}
+
+int modProbe::startMon() {
+
+	// server could be passed as first -o parameter
+	std::string server = param.options.size() > 0 ? param.options[0] : "localhost";
+	// port could be passed as second
+	std::string port = param.options.size() > 1 ? param.options[1] : std::to_string(PROBE_DEFAULT_PORT);
+	// protocol could be passed as third
+	std::string protocol = param.options.size() > 2 ? param.options[2] : "tcp";
+	if (protocol == "udp") udp = true;
+	else if (protocol == "tcp") udp = false;
+	else {
+		std::cerr << "modProbe: unknown protocol " << protocol << std::endl;
+		return 1;
+	}
+	// message size could be passed as fourth
+	long long option = udp ? 1400 : 131072;
+	if (param.options.size() > 3 && !parseOption(param.options[3], 1, option)) {
+		std::cerr << "modProbe: invalid message size " << param.options[3] << std::endl;
+		return 1;
+	}
+	message_size = option;
+	if (message_size < sizeof (probe_header_t)) message_size = sizeof (probe_header_t);
+	if (udp && message_size > 65507) message_size = 65507;
+	// parallel streams could be passed as fifth
+	option = 1;
+	if (param.options.size() > 4 && (!parseOption(param.options[4], 1, option) || option > INT_MAX)) {
+		std::cerr << "modProbe: invalid stream count " << param.options[4] << std::endl;
+		return 1;
+	}
+	int stream_count = option;
+	// rate could be passed as sixth, UDP would flood the network without a limit
+	option = udp ? 10000000 : 0;
+	if (param.options.size() > 5 && !parseOption(param.options[5], 0, option)) {
+		std::cerr << "modProbe: invalid rate " << param.options[5] << std::endl;
+		return 1;
+	}
+	rate = option;
+	// sending mode could be passed as seventh
+	zerocopy = !(param.options.size() > 6 && param.options[6] == "copy");
+
+	payload.assign(message_size, 'p');
+	if (!udp && zerocopy) {
+		memfd = memfd_create("promoris-probe", MFD_CLOEXEC);
+		if (memfd < 0 || write(memfd, payload.data(), message_size) != static_cast<ssize_t> (message_size)) {
+			std::cerr << "modProbe: could not create memfd: " << strerror(errno) << std::endl;
+			return 1;
+		}
+	}
+
+	for (int stream_i = 0; stream_i < stream_count; ++stream_i) {
+		std::unique_ptr<probe_stream_t> stream(new probe_stream_t());
+		stream->fd = connectStream(server, port);
+		stream->source = -1;
+		if (stream->fd < 0) {
+			stopMon();
+			return 1;
+		}
+		if (udp) {
+			probe_stream_t* stream_p = stream.get();
+			stream->source = param.reactor->addReadable(stream->fd, [this, stream_p]() {
+				receiveEchoes(stream_p);
+			});
+		}
+		streams.push_back(std::move(stream));
+	}
+
+	// sampling interval is the ProMoRIS interval
+	int64_t interval_ns = param.interval_micro > 0 ? param.interval_micro * 1000LL : param.interval * 1000000000LL;
+	last_ns = monotonicNs();
+	timer = param.reactor->addTimer(last_ns + interval_ns, interval_ns, [this](uint64_t expirations) {
+		sample();
+	});
+	if (timer < 0) {
+		std::cerr << "modProbe: could not create timer" << std::endl;
+		stopMon();
+		return 1;
+	}
+
+	stopmon = false;
+	for (size_t stream_i = 0; stream_i < streams.size(); ++stream_i) {
+		probe_stream_t* stream = streams[stream_i].get();
+		if (udp) stream->sender = std::thread(&modProbe::sendUdp, this, stream, stream_i);
+		else stream->sender = std::thread(&modProbe::sendTcp, this, stream);
+	}
+
+	return 0;
+}
+
+int modProbe::stopMon() {
+	stopmon = true;
+	if (timer >= 0) param.reactor->remove(timer);
+	timer = -1;
+	for (auto &stream : streams) {
+		// wake up blocked send calls
+		shutdown(stream->fd, SHUT_RDWR);
+		if (stream->sender.joinable()) stream->sender.join();
+		if (stream->source >= 0) param.reactor->remove(stream->source);
+		close(stream->fd);
+	}
+	streams.clear();
+	if (memfd >= 0) close(memfd);
+	memfd = -1;
+	return 0;
+}
+
+bool modProbe::running() {
+	return !stopmon;
+}
+
+sampleBuffer * modProbe::getBuffer() {
+	return &values;
+}
+
+// the probe does not depend on the targets, all targets share its samples
+bool modProbe::batched() {
+	return true;
+}
+
+sampleBuffer * modProbe::getTargetBuffer(int target_i) {
+	return &values;
+}
+
+std::vector<std::string> modProbe::getLabels() {
+	return {"time", "sent", "bps", "loss", "jitter", "rtt"};
+}
+
+std::vector<field_type_t> modProbe::getColTypes() {
+	return {FIELD_TIME, FIELD_INT64, FIELD_INT64, FIELD_DOUBLE, FIELD_DOUBLE, FIELD_DOUBLE};
+}
+
+std::vector<int> modProbe::getColMaxSize() {
+	return {10, 12, 12, 7, 8, 8};
+}
+
+extern "C" module* createMod() {
+	return new modProbe;
+}
+
+extern "C" void destroyMod(module* p) {
+	delete p;
+}
+
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
+extern "C" const char* getHelp() {
+	return "Module usage:\n"
+			"-m MODPROBE [-p PREFIX] [-c time] [-c sent] [-c bps] [-c loss] [-c jitter] [-c rtt] "
+			"[-o SERVER [-o PORT [-o PROTOCOL [-o SIZE [-o STREAMS [-o RATE [-o SENDMODE]]]]]]]\n\n"
+			"Columns:\n"
+			"time: UNIX timestamp when snapshot was taken\n"
+			"sent: Sending bit rate of all streams (bit/s)\n"
+			"bps: Delivered bit rate of all streams (bit/s), acknowledged bytes for TCP,\n"
+			"echoed datagrams for UDP\n"
+			"loss: Retransmitted segments (TCP) or datagrams without echo (UDP) (%)\n"
+			"jitter: RTT variation (ms), smoothed by the kernel for TCP, interarrival jitter\n"
+			"of the echoes (RFC 3550) for UDP\n"
+			"rtt: Round trip time (ms), smoothed by the kernel for TCP, mean of the echoes for UDP\n\n"
+			"Measures the throughput to a responder started with promoris -R on SERVER, no iperf3\n"
+			"is required. Data is sent continuously by one thread per stream, a sample is taken\n"
+			"every INTERVAL of ProMoRIS. UDP loss includes lost echoes.\n\n"
+			"Options and defaults:\n"
+			"SERVER = localhost -- host running promoris -R\n"
+			"PORT = 5301 -- port of the responder\n"
+			"PROTOCOL = tcp -- tcp or udp\n"
+			"SIZE = 131072 (tcp), 1400 (udp) -- bytes per send call or datagram\n"
+			"STREAMS = 1 -- number of parallel connections\n"
+			"RATE = 0 (tcp), 10000000 (udp) -- bit/s per stream, 0 = unlimited\n"
+			"SENDMODE = zerocopy -- tcp: zerocopy sends from a memfd with sendfile, copy uses send";
+}
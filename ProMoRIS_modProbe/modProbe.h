@@ -0,0 +1,98 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODPROBE_H
+#define MODPROBE_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "../ProMoRIS/module.h"
+
+// state of one parallel stream of the probe
+typedef struct probe_stream_t {
+	int fd;
+	// id of the echo source in the event loop (UDP)
+	int source;
+	// sends the data as fast as RATE allows
+	std::thread sender;
+	// bytes sent, only written by the sender thread
+	std::atomic<uint64_t> sent_bytes;
+	// bytes sent at the last sample
+	uint64_t last_sent_bytes;
+	// UDP: next expected sequence number and echoes since the last sample
+	uint64_t expected_seq;
+	uint64_t lost;
+	uint64_t echoed;
+	uint64_t echoed_bytes;
+	double rtt_sum_ms;
+	double last_rtt_ms;
+	// interarrival jitter of the echoes (RFC 3550)
+	double jitter_ms;
+	// TCP: counters of TCP_INFO at the last sample
+	uint64_t last_acked;
+	uint32_t last_retrans;
+	uint32_t last_segs_out;
+} probe_stream_t;
+
+class modProbe : public module {
+public:
+	void setParameters(param_t sparam);
+	int startMon();
+	int stopMon();
+	bool running();
+	sampleBuffer * getBuffer();
+	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
+	std::vector<int> getColMaxSize();
+	bool batched();
+	sampleBuffer * getTargetBuffer(int target_i);
+	modProbe();
+	virtual ~modProbe();
+private:
+	sampleBuffer values;
+	param_t param;
+	std::atomic<bool> stopmon;
+	std::vector<std::unique_ptr<probe_stream_t>> streams;
+	bool udp;
+	// size of a TCP send call or a UDP datagram in bytes
+	size_t message_size;
+	// bit/s of every stream, 0 = unlimited
+	int64_t rate;
+	// TCP: send from a memfd with sendfile instead of copying from user space
+	bool zerocopy;
+	int memfd;
+	std::vector<char> payload;
+	// id of the sampling timer in the event loop
+	int timer;
+	// time of the last sample
+	int64_t last_ns;
+	// last reported RTT, kept while no echoes arrive
+	double last_rtt_ms;
+	int connectStream(const std::string& server, const std::string& port);
+	void sendTcp(probe_stream_t* stream);
+	void sendUdp(probe_stream_t* stream, uint32_t stream_i);
+	void receiveEchoes(probe_stream_t* stream);
+	void sample();
+};
+
+#endif /* MODPROBE_H */
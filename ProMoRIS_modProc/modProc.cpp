@@ -0,0 +1,348 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "modProc.h"
+#include <iostream>
+#include <stdio.h>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+// read a procfs file from the beginning through a persistent file descriptor
+static ssize_t preadProc(int fd, char* buffer, size_t size) {
+	ssize_t n = pread(fd, buffer, size - 1, 0);
+	if (n >= 0) buffer[n] = '\0';
+	return n;
+}
+
+// value of a "Key:  value" line of /proc/<pid>/status, key must include the leading newline
+static int64_t statusValue(const char* buffer, const char* key) {
+	const char* p = strstr(buffer, key);
+	if (p == nullptr) return 0;
+	return strtoll(p + strlen(key), nullptr, 10);
+}
+
+modProc::modProc() : values(1), stopmon(true), timer(-1), page_kib(4), memtotal_kib(0),
+read_stat(true), read_statm(true), read_status(true) {
+}
+
+modProc::~modProc() {
+	stopMon();
+}
+
+int modProc::openProc(proc_target_t& target) {
+	std::string dir = "/proc/" + target.pid + "/";
+	if (read_stat) target.fd_stat = open((dir + "stat").c_str(), O_RDONLY | O_CLOEXEC);
+	if (read_statm) target.fd_statm = open((dir + "statm").c_str(), O_RDONLY | O_CLOEXEC);
+	if (read_status) target.fd_status = open((dir + "status").c_str(), O_RDONLY | O_CLOEXEC);
+	if ((read_stat && target.fd_stat < 0) || (read_statm && target.fd_statm < 0) ||
+			(read_status && target.fd_status < 0)) {
+		std::cerr << "modProc: could not open " << dir << ": " << strerror(errno) << std::endl;
+		closeProc(target);
+		return 1;
+	}
+	return 0;
+}
+
+void modProc::closeProc(proc_target_t& target) {
+	if (target.fd_stat >= 0) close(target.fd_stat);
+	if (target.fd_statm >= 0) close(target.fd_statm);
+	if (target.fd_status >= 0) close(target.fd_status);
+	target.fd_stat = target.fd_statm = target.fd_status = -1;
+}
+
+// read the files of stat, statm and status needed for the requested columns
+// returns false if the process does not exist anymore
+bool modProc::readProc(const proc_target_t& target, proc_reading_t& reading) {
+	char buffer[4096];
+	char* p;
+
+	// stat: the command name in field 2 may contain spaces and parentheses,
+	// so start parsing after the last ')'
+	if (read_stat) {
+		if (preadProc(target.fd_stat, buffer, sizeof (buffer)) <= 0) return false;
+		p = strrchr(buffer, ')');
+		if (p == nullptr) return false;
+		// skip ") " and the state (field 3)
+		p += 4;
+		for (int field = 4; field <= 20; ++field) {
+			long long value = strtoll(p, &p, 10);
+			switch (field) {
+				case 10: reading.minflt = value;
+					break;
+				case 12: reading.majflt = value;
+					break;
+				case 14: reading.utime = value;
+					break;
+				case 15: reading.stime = value;
+					break;
+				case 20: reading.threads = value;
+					break;
+			}
+		}
+	}
+
+	// statm: sizes in pages
+	if (read_statm) {
+		if (preadProc(target.fd_statm, buffer, sizeof (buffer)) <= 0) return false;
+		p = buffer;
+		reading.virt = strtoll(p, &p, 10) * page_kib;
+		reading.res = strtoll(p, &p, 10) * page_kib;
+		reading.shr = strtoll(p, &p, 10) * page_kib;
+	}
+
+	// status: values not available in stat or statm, the most expensive file
+	if (read_status) {
+		if (preadProc(target.fd_status, buffer, sizeof (buffer)) <= 0) return false;
+		reading.swap = statusValue(buffer, "\nVmSwap:");
+		reading.hwm = statusValue(buffer, "\nVmHWM:");
+		reading.vctx = statusValue(buffer, "\nvoluntary_ctxt_switches:");
+		reading.nvctx = statusValue(buffer, "\nnonvoluntary_ctxt_switches:");
+	}
+
+	return true;
+}
+
+// read all targets in one pass, called by the timer of the event loop
+void modProc::sample() {
+
+	int64_t now_ns = sampleTime();
+
+	// CPU usage in % of one CPU from the tick deltas since the last reading
+	double cpu_factor = 100.0 / (ticks_per_second * ((now_ns - last_ns) / 1e9));
+
+	proc_reading_t current = proc_reading_t();
+	for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+		proc_target_t& target = targets[target_i];
+		if (target.terminated) continue;
+		// time stamp right before reading, so targets read later in the pass are not backdated
+		int64_t timestamp = sampleTime();
+		if (!readProc(target, current)) {
+			target.terminated = true;
+			closeProc(target);
+			--targets_left;
+			continue;
+		}
+		const proc_reading_t& last = target.last;
+
+		sample_t* sample = values[target_i].claim();
+		sample->time = timestamp;
+		sample->fields[1].i = current.virt;
+		sample->fields[2].i = current.res;
+		sample->fields[3].i = current.shr;
+		sample->fields[4].d = ((current.utime - last.utime) + (current.stime - last.stime)) * cpu_factor;
+		sample->fields[5].d = memtotal_kib > 0 ? 100.0 * current.res / memtotal_kib : 0.0;
+		sample->fields[6].d = (current.utime - last.utime) * cpu_factor;
+		sample->fields[7].d = (current.stime - last.stime) * cpu_factor;
+		sample->fields[8].i = current.threads;
+		sample->fields[9].i = current.minflt;
+		sample->fields[10].i = current.majflt;
+		sample->fields[11].i = current.vctx;
+		sample->fields[12].i = current.nvctx;
+		sample->fields[13].i = current.swap;
+		sample->fields[14].i = current.hwm;
+		values[target_i].publish();
+
+		target.last = current;
+	}
+
+	last_ns = now_ns;
+
+	// stop when the last target terminated
+	if (targets_left == 0) {
+		param.reactor->remove(timer);
+		timer = -1;
+		stopmon = true;
+	}
+
+}
+
+void modProc::setParameters(param_t sparam) {
+	param = sparam;
+	if (param.targets.empty()) param.targets.push_back(param.pid_struct);
+
+	// only read the files of the requested columns
+	// 1-3, 5: statm; 4, 6-10: stat; 11-14: status
+	read_stat = read_statm = read_status = param.columns.empty();
+	for (int col_i : param.columns) {
+		if ((col_i >= 1 && col_i <= 3) || col_i == 5) read_statm = true;
+		else if (col_i == 4 || (col_i >= 6 && col_i <= 10)) read_stat = true;
+		else if (col_i >= 11) read_status = true;
+	}
+	// at least one file is read to notice the termination of the targets
+	if (!read_statm && !read_status) read_stat = true;
+
+	targets.clear();
+	for (auto pid : param.targets) {
+		proc_target_t target = proc_target_t();
+		target.pid = std::to_string(pid);
+		target.fd_stat = target.fd_statm = target.fd_status = -1;
+		target.terminated = false;
+		targets.push_back(target);
+	}
+	values = std::vector<sampleBuffer>(targets.size());
+	for (auto &buffer : values) buffer.resize(param.buffer_size);
+}
+
+int modProc::startMon() {
+	// sampling interval could be passed as first -o parameter, checked before anything is opened
+	long long option_us = 0;
+	if (param.options.size() > 0) {
+		const char* option = param.options[0].c_str();
+		char* end;
+		errno = 0;
+		option_us = strtoll(option, &end, 10);
+		if (end == option || *end != '\0' || errno == ERANGE || option_us < 1) {
+			std::cerr << "modProc: invalid interval " << option << std::endl;
+			return 1;
+		}
+	}
+
+	for (auto &target : targets) {
+		if (openProc(target) != 0) {
+			for (auto &opened : targets) closeProc(opened);
+			return 1;
+		}
+	}
+
+	page_kib = sysconf(_SC_PAGESIZE) / 1024;
+
+	// total memory for pmem, only read once
+	FILE* meminfo = fopen("/proc/meminfo", "r");
+	if (meminfo != nullptr) {
+		long long memtotal;
+		if (fscanf(meminfo, "MemTotal: %lld kB", &memtotal) == 1) memtotal_kib = memtotal;
+		fclose(meminfo);
+	}
+
+	int64_t interval_ns;
+	if (param.options.size() > 0) interval_ns = option_us * 1000LL;
+	else if (param.interval_micro > 0) interval_ns = param.interval_micro * 1000LL;
+	else interval_ns = param.interval * 1000000000LL;
+	if (interval_ns < 1000) interval_ns = 1000;
+
+	ticks_per_second = sysconf(_SC_CLK_TCK);
+
+	// first reading only serves as a base for the CPU usage
+	targets_left = 0;
+	for (auto &target : targets) {
+		target.terminated = !readProc(target, target.last);
+		if (!target.terminated) ++targets_left;
+	}
+	if (targets_left == 0) return 1;
+	last_ns = sampleTime();
+
+	// the timer of the event loop runs on absolute deadlines, so reading does not add to the interval
+	timer = param.reactor->addTimer(last_ns + interval_ns, interval_ns, [this](uint64_t expirations) {
+		sample();
+	});
+	if (timer < 0) {
+		std::cerr << "modProc: could not create timer" << std::endl;
+		return 1;
+	}
+	stopmon = false;
+
+	return 0;
+}
+
+int modProc::stopMon() {
+	stopmon = true;
+	if (timer >= 0) param.reactor->remove(timer);
+	timer = -1;
+	for (auto &target : targets) closeProc(target);
+	return 0;
+}
+
+bool modProc::running() {
+	return !stopmon;
+}
+
+sampleBuffer * modProc::getBuffer() {
+	return &values[0];
+}
+
+bool modProc::batched() {
+	return true;
+}
+
+sampleBuffer * modProc::getTargetBuffer(int target_i) {
+	return &values[target_i];
+}
+
+bool modProc::projection() {
+	return true;
+}
+
+std::vector<std::string> modProc::getLabels() {
+	return {"time", "virt", "res", "shr", "pcpu", "pmem", "usr", "sys", "threads",
+		"minflt", "majflt", "vctx", "nvctx", "swap", "hwm"};
+}
+
+std::vector<field_type_t> modProc::getColTypes() {
+	return {FIELD_TIME, FIELD_INT64, FIELD_INT64, FIELD_INT64, FIELD_DOUBLE, FIELD_DOUBLE,
+		FIELD_DOUBLE, FIELD_DOUBLE, FIELD_INT64, FIELD_INT64, FIELD_INT64, FIELD_INT64,
+		FIELD_INT64, FIELD_INT64, FIELD_INT64};
+}
+
+std::vector<int> modProc::getColMaxSize() {
+	return {10, 15, 15, 15, 7, 5, 7, 7, 7, 12, 10, 12, 12, 10, 15};
+}
+
+extern "C" module* createMod() {
+	return new modProc;
+}
+
+extern "C" void destroyMod(module* p) {
+	delete p;
+}
+
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
+extern "C" const char* getHelp() {
+	return "Module usage:\n"
+			"-m MODPROC [-p PREFIX] [-c time] [-c virt] [-c res] [-c shr] "
+			"[-c pcpu] [-c pmem] [-c usr] [-c sys] [-c threads] [-c minflt] [-c majflt] "
+			"[-c vctx] [-c nvctx] [-c swap] [-c hwm] [-o SAMPLE_MICRO]\n\n"
+			"Columns:\n"
+			"time: UNIX timestamp when snapshot was taken\n"
+			"virt: Virtual memory usage (KiB)\n"
+			"res: Resident memory usage (KiB)\n"
+			"shr: Shared memory usage (KiB)\n"
+			"pcpu: CPU usage since the last snapshot (% of one CPU)\n"
+			"pmem: Resident memory usage (%)\n"
+			"usr: User CPU usage since the last snapshot (% of one CPU)\n"
+			"sys: System CPU usage since the last snapshot (% of one CPU)\n"
+			"threads: Number of threads\n"
+			"minflt: Minor page faults since process start\n"
+			"majflt: Major page faults since process start\n"
+			"vctx: Voluntary context switches since process start\n"
+			"nvctx: Involuntary context switches since process start\n"
+			"swap: Swapped out memory (KiB)\n"
+			"hwm: Peak resident memory usage (KiB)\n\n"
+			"Reads /proc/PID/stat, statm and status directly, no external tool is required.\n"
+			"All targets are sampled in one pass by the event loop of ProMoRIS.\n"
+			"CPU usage is computed from clock ticks (usually 100 per second), so very short\n"
+			"sampling intervals give coarse CPU values.\n\n"
+			"Options and defaults:\n"
+			"SAMPLE_MICRO -- sampling interval in microseconds (default: the ProMoRIS interval)";
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODPROC_H
+#define MODPROC_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "../ProMoRIS/module.h"
+
+// values read from /proc/<pid>/stat, statm and status in one pass
+typedef struct proc_reading_t {
+	int64_t utime;
+	int64_t stime;
+	int64_t minflt;
+	int64_t majflt;
+	int64_t threads;
+	int64_t virt;
+	int64_t res;
+	int64_t shr;
+	int64_t swap;
+	int64_t hwm;
+	int64_t vctx;
+	int64_t nvctx;
+} proc_reading_t;
+
+// state of one monitored process
+typedef struct proc_target_t {
+	std::string pid;
+	// persistent file descriptors, read again with pread for every sample
+	int fd_stat;
+	int fd_statm;
+	int fd_status;
+	// last reading, base for the CPU usage
+	proc_reading_t last;
+	// process does not exist anymore
+	bool terminated;
+} proc_target_t;
+
+class modProc : public module {
+public:
+	void setParameters(param_t sparam);
+	int startMon();
+	int stopMon();
+	bool running();
+	sampleBuffer * getBuffer();
+	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
+	std::vector<int> getColMaxSize();
+	bool batched();
+	sampleBuffer * getTargetBuffer(int target_i);
+	bool projection();
+	modProc();
+	virtual ~modProc();
+private:
+	// one buffer per target
+	std::vector<sampleBuffer> values;
+	std::vector<proc_target_t> targets;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// id of the sampling timer in the event loop
+	int timer;
+	// targets which still exist
+	size_t targets_left;
+	// time of the last reading, base for the CPU usage
+	int64_t last_ns;
+	double ticks_per_second;
+	// page size and total memory in KiB
+	int64_t page_kib;
+	int64_t memtotal_kib;
+	// files needed for the requested columns
+	bool read_stat;
+	bool read_statm;
+	bool read_status;
+	int openProc(proc_target_t& target);
+	void closeProc(proc_target_t& target);
+	bool readProc(const proc_target_t& target, proc_reading_t& reading);
+	void sample();
+};
+
+#endif /* MODPROC_H */
@@ -0,0 +1,342 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "modSockdiag.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/tcp.h>
+
+// a dump of all TCP sockets can be large
+#define SOCKDIAG_RCVBUF (1 << 20)
+
+// all TCP states except listening sockets, which do not transfer data
+#define SOCKDIAG_STATES (0xfff & ~(1 << 10))
+
+typedef struct sockdiag_request_t {
+	nlmsghdr n;
+	inet_diag_req_v2 r;
+} sockdiag_request_t;
+
+modSockdiag::modSockdiag() : values(1), stopmon(true), nl_fd(-1), timer(-1), targets_left(0), last_ns(0) {
+}
+
+modSockdiag::~modSockdiag() {
+	stopMon();
+}
+
+// map the socket inodes of the targets to the targets (links "socket:[INODE]" in /proc/PID/fd)
+void modSockdiag::scanInodes() {
+	inodes.clear();
+	char link[64];
+	for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+		sockdiag_target_t& target = targets[target_i];
+		if (target.terminated) continue;
+		DIR* dir = opendir(target.fd_dir.c_str());
+		if (dir == nullptr) {
+			target.terminated = true;
+			--targets_left;
+			continue;
+		}
+		int dir_fd = dirfd(dir);
+		struct dirent* entry;
+		while ((entry = readdir(dir)) != nullptr) {
+			if (entry->d_name[0] == '.') continue;
+			ssize_t n = readlinkat(dir_fd, entry->d_name, link, sizeof (link) - 1);
+			if (n < 9 || strncmp(link, "socket:[", 8) != 0) continue;
+			link[n] = '\0';
+			inodes[strtoul(link + 8, nullptr, 10)] = target_i;
+		}
+		closedir(dir);
+	}
+}
+
+// add the counters of a socket of a target to the sums of the target
+void modSockdiag::addSocket(uint32_t inode, const sockdiag_socket_t& socket, uint32_t rtt) {
+	auto owner = inodes.find(inode);
+	if (owner == inodes.end()) return;
+	sockdiag_target_t& target = targets[owner->second];
+
+	// only the traffic since the last pass counts, new sockets count completely
+	sockdiag_socket_t last = {0, 0, 0};
+	auto previous = last_sockets.find(inode);
+	if (previous != last_sockets.end()) last = previous->second;
+	target.sent += socket.bytes_acked - std::min(last.bytes_acked, socket.bytes_acked);
+	target.received += socket.bytes_received - std::min(last.bytes_received, socket.bytes_received);
+	target.retrans += socket.total_retrans - std::min(last.total_retrans, socket.total_retrans);
+	target.rtt_sum += rtt;
+	++target.sockets;
+	sockets[inode] = socket;
+}
+
+// dump the TCP sockets of an address family with their tcp_info
+// returns false if the kernel could not be queried
+bool modSockdiag::dump(int family) {
+	sockdiag_request_t req;
+	memset(&req, 0, sizeof (req));
+	req.n.nlmsg_len = sizeof (req);
+	req.n.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+	req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.r.sdiag_family = family;
+	req.r.sdiag_protocol = IPPROTO_TCP;
+	req.r.idiag_states = SOCKDIAG_STATES;
+	req.r.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+
+	sockaddr_nl kernel;
+	memset(&kernel, 0, sizeof (kernel));
+	kernel.nl_family = AF_NETLINK;
+	if (sendto(nl_fd, &req, sizeof (req), 0, reinterpret_cast<sockaddr*> (&kernel), sizeof (kernel)) < 0) {
+		std::cerr << "modSockdiag: could not send request: " << strerror(errno) << std::endl;
+		return false;
+	}
+
+	alignas(nlmsghdr) char buffer[65536];
+	while (true) {
+		ssize_t n = recv(nl_fd, buffer, sizeof (buffer), 0);
+		if (n < 0) {
+			if (errno == EINTR) continue;
+			std::cerr << "modSockdiag: no reply from the kernel: " << strerror(errno) << std::endl;
+			return false;
+		}
+		for (nlmsghdr* msg = reinterpret_cast<nlmsghdr*> (buffer); NLMSG_OK(msg, n); msg = NLMSG_NEXT(msg, n)) {
+			if (msg->nlmsg_type == NLMSG_DONE) return true;
+			if (msg->nlmsg_type == NLMSG_ERROR) {
+				int error = -reinterpret_cast<nlmsgerr*> (NLMSG_DATA(msg))->error;
+				std::cerr << "modSockdiag: sock_diag request failed: " << strerror(error) << std::endl;
+				return false;
+			}
+			if (msg->nlmsg_type != SOCK_DIAG_BY_FAMILY) continue;
+
+			inet_diag_msg* diag = reinterpret_cast<inet_diag_msg*> (NLMSG_DATA(msg));
+			// skip sockets of other processes before looking at the attributes
+			if (inodes.find(diag->idiag_inode) == inodes.end()) continue;
+
+			int len = msg->nlmsg_len - NLMSG_LENGTH(sizeof (*diag));
+			for (rtattr* attr = reinterpret_cast<rtattr*> (diag + 1); RTA_OK(attr, len); attr = RTA_NEXT(attr, len)) {
+				if (attr->rta_type != INET_DIAG_INFO) continue;
+				// the struct grows with new kernels, older kernels send a shorter one
+				tcp_info info;
+				memset(&info, 0, sizeof (info));
+				memcpy(&info, RTA_DATA(attr), std::min<size_t> (RTA_PAYLOAD(attr), sizeof (info)));
+				sockdiag_socket_t socket = {info.tcpi_bytes_acked, info.tcpi_bytes_received, info.tcpi_total_retrans};
+				addSocket(diag->idiag_inode, socket, info.tcpi_rtt);
+			}
+		}
+	}
+}
+
+// account the sockets of all targets in one pass, called by the timer of the event loop
+void modSockdiag::sample() {
+
+	// time stamps of the samples and base of the rates
+	int64_t now_ns = sampleTime();
+
+	for (auto &target : targets) {
+		target.sent = target.received = target.retrans = target.rtt_sum = 0;
+		target.sockets = 0;
+	}
+	scanInodes();
+	sockets.clear();
+	if (!dump(AF_INET) || !dump(AF_INET6)) {
+		param.reactor->remove(timer);
+		timer = -1;
+		stopmon = true;
+		return;
+	}
+	// sockets closed since the last pass are forgotten
+	last_sockets.swap(sockets);
+
+	// KiB/s
+	double factor = 1e9 / 1024.0 / (now_ns - last_ns);
+
+	for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+		const sockdiag_target_t& target = targets[target_i];
+		if (target.terminated) continue;
+
+		sample_t* sample = values[target_i].claim();
+		sample->time = now_ns;
+		sample->fields[1].d = target.sent * factor;
+		sample->fields[2].d = target.received * factor;
+		sample->fields[3].d = target.sockets > 0 ? target.rtt_sum / 1000.0 / target.sockets : 0.0;
+		sample->fields[4].i = target.retrans;
+		sample->fields[5].i = target.sockets;
+		values[target_i].publish();
+	}
+
+	last_ns = now_ns;
+
+	// stop when the last target terminated
+	if (targets_left == 0) {
+		param.reactor->remove(timer);
+		timer = -1;
+		stopmon = true;
+	}
+
+}
+
+void modSockdiag::setParameters(param_t sparam) {
+	param = sparam;
+	if (param.targets.empty()) param.targets.push_back(param.pid_struct);
+
+	targets.clear();
+	for (auto pid : param.targets) {
+		sockdiag_target_t target;
+		target.fd_dir = "/proc/" + std::to_string(pid) + "/fd";
+		target.sent = target.received = target.retrans = target.rtt_sum = 0;
+		target.sockets = 0;
+		target.terminated = false;
+		targets.push_back(target);
+	}
+	values = std::vector<sampleBuffer>(targets.size());
+	for (auto &buffer : values) buffer.resize(param.buffer_size);
+}
+
+int modSockdiag::startMon() {
+	// sampling interval could be passed as first -o parameter, checked before anything is opened
+	long long option_us = 0;
+	if (param.options.size() > 0) {
+		const char* option = param.options[0].c_str();
+		char* end;
+		errno = 0;
+		option_us = strtoll(option, &end, 10);
+		if (end == option || *end != '\0' || errno == ERANGE || option_us < 1) {
+			std::cerr << "modSockdiag: invalid interval " << option << std::endl;
+			return 1;
+		}
+	}
+
+	nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+	if (nl_fd < 0) {
+		std::cerr << "modSockdiag: could not open netlink socket: " << strerror(errno) << std::endl;
+		return 1;
+	}
+	int rcvbuf = SOCKDIAG_RCVBUF;
+	setsockopt(nl_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof (rcvbuf));
+	// never block the event loop for long if the kernel does not answer
+	timeval timeout = {1, 0};
+	setsockopt(nl_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+	// first pass only serves as a base for the rates
+	targets_left = targets.size();
+	scanInodes();
+	if (!dump(AF_INET) || !dump(AF_INET6)) {
+		stopMon();
+		return 1;
+	}
+	last_sockets.swap(sockets);
+	last_ns = sampleTime();
+
+	int64_t interval_ns;
+	if (param.options.size() > 0) interval_ns = option_us * 1000LL;
+	else if (param.interval_micro > 0) interval_ns = param.interval_micro * 1000LL;
+	else interval_ns = param.interval * 1000000000LL;
+	if (interval_ns < 1000) interval_ns = 1000;
+
+	timer = param.reactor->addTimer(last_ns + interval_ns, interval_ns, [this](uint64_t expirations) {
+		sample();
+	});
+	if (timer < 0) {
+		std::cerr << "modSockdiag: could not create timer" << std::endl;
+		stopMon();
+		return 1;
+	}
+	stopmon = false;
+
+	return 0;
+}
+
+int modSockdiag::stopMon() {
+	stopmon = true;
+	if (timer >= 0) param.reactor->remove(timer);
+	timer = -1;
+	if (nl_fd >= 0) close(nl_fd);
+	nl_fd = -1;
+	return 0;
+}
+
+bool modSockdiag::running() {
+	return !stopmon;
+}
+
+sampleBuffer * modSockdiag::getBuffer() {
+	return &values[0];
+}
+
+bool modSockdiag::batched() {
+	return true;
+}
+
+sampleBuffer * modSockdiag::getTargetBuffer(int target_i) {
+	return &values[target_i];
+}
+
+std::vector<std::string> modSockdiag::getLabels() {
+	return {"time", "sent", "received", "rtt", "retrans", "sockets"};
+}
+
+std::vector<field_type_t> modSockdiag::getColTypes() {
+	return {FIELD_TIME, FIELD_DOUBLE, FIELD_DOUBLE, FIELD_DOUBLE, FIELD_INT64, FIELD_INT64};
+}
+
+std::vector<int> modSockdiag::getColMaxSize() {
+	return {10, 10, 10, 8, 8, 7};
+}
+
+extern "C" module* createMod() {
+	return new modSockdiag;
+}
+
+extern "C" void destroyMod(module* p) {
+	delete p;
+}
+
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
+extern "C" const char* getHelp() {
+	return "Module usage:\n"
+			"-m MODSOCKDIAG [-p PREFIX] [-c time] [-c sent] [-c received] [-c rtt] "
+			"[-c retrans] [-c sockets] [-o SAMPLE_MICRO]\n\n"
+			"Columns:\n"
+			"time: UNIX timestamp when snapshot was taken\n"
+			"sent: Sending rate since the last snapshot (KiB/s, acknowledged bytes)\n"
+			"received: Receiving rate since the last snapshot (KiB/s)\n"
+			"rtt: Mean smoothed round trip time of the sockets (ms)\n"
+			"retrans: Retransmitted segments since the last snapshot\n"
+			"sockets: Number of TCP sockets of the process\n\n"
+			"Reads the tcp_info of all TCP sockets (IPv4 and IPv6) via NETLINK_SOCK_DIAG and assigns\n"
+			"them to the process by their inodes in /proc/PID/fd. No packet capture is needed, so\n"
+			"short sampling intervals are cheap. Only TCP is accounted, and traffic of sockets closed\n"
+			"between two snapshots is lost. Monitoring processes of other users requires root.\n"
+			"Replaces MODNETHOGS.\n\n"
+			"Options and defaults:\n"
+			"SAMPLE_MICRO -- sampling interval in microseconds (default: the ProMoRIS interval)";
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODSOCKDIAG_H
+#define MODSOCKDIAG_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <unordered_map>
+#include "../ProMoRIS/module.h"
+
+// counters of one TCP socket from tcp_info
+typedef struct sockdiag_socket_t {
+	uint64_t bytes_acked;
+	uint64_t bytes_received;
+	uint32_t total_retrans;
+} sockdiag_socket_t;
+
+// sums of the sockets of one target in the current pass
+typedef struct sockdiag_target_t {
+	std::string fd_dir;
+	// bytes and retransmits since the last pass
+	uint64_t sent;
+	uint64_t received;
+	uint64_t retrans;
+	// sum of the smoothed round trip times (us) and number of sockets
+	uint64_t rtt_sum;
+	int64_t sockets;
+	// process does not exist anymore
+	bool terminated;
+} sockdiag_target_t;
+
+class modSockdiag : public module {
+public:
+	void setParameters(param_t sparam);
+	int startMon();
+	int stopMon();
+	bool running();
+	sampleBuffer * getBuffer();
+	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
+	std::vector<int> getColMaxSize();
+	bool batched();
+	sampleBuffer * getTargetBuffer(int target_i);
+	modSockdiag();
+	virtual ~modSockdiag();
+private:
+	// one buffer per target
+	std::vector<sampleBuffer> values;
+	std::vector<sockdiag_target_t> targets;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// NETLINK_SOCK_DIAG socket
+	int nl_fd;
+	// id of the sampling timer in the event loop
+	int timer;
+	// targets which still exist
+	size_t targets_left;
+	// time of the last pass, base for the rates
+	int64_t last_ns;
+	// socket inode -> index of the target owning it, rebuilt every pass
+	std::unordered_map<uint32_t, size_t> inodes;
+	// socket inode -> counters of the last and the current pass
+	std::unordered_map<uint32_t, sockdiag_socket_t> last_sockets;
+	std::unordered_map<uint32_t, sockdiag_socket_t> sockets;
+	void scanInodes();
+	bool dump(int family);
+	void addSocket(uint32_t inode, const sockdiag_socket_t& socket, uint32_t rtt);
+	void sample();
+};
+
+#endif /* MODSOCKDIAG_H */
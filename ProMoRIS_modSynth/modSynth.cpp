@@ -0,0 +1,176 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "modSynth.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+// expensive synthetic metric: xorshift steps which cannot be optimized away
+static int64_t synthWork(uint64_t& state, int64_t iterations) {
+	uint64_t x = state;
+	for (int64_t i = 0; i < iterations; ++i) {
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+	}
+	state = x;
+	return static_cast<int64_t> (x >> 44);
+}
+
+modSynth::modSynth() : stopmon(true), timer(-1), interval_ns(0), work(200000), project(true), state(88172645463325252ULL) {
+	for (int i = 0; i < SYNTH_COLUMNS; ++i) acquire[i] = true;
+}
+
+modSynth::~modSynth() {
+	stopMon();
+}
+
+// acquire the columns and measure the time needed, called by the timer of the event loop
+void modSynth::sample() {
+	sample_t* sample = values.claim();
+	int64_t start_ns = sampleTime();
+	for (int i = 0; i < SYNTH_COLUMNS; ++i) {
+		if (acquire[i]) sample->fields[SYNTH_FIRST_COLUMN + i].i = synthWork(state, work);
+	}
+	int64_t cost_ns = sampleTime() - start_ns;
+	sample->time = start_ns;
+	sample->fields[1].i = cost_ns;
+	sample->fields[2].d = 100.0 * cost_ns / interval_ns;
+	values.publish();
+}
+
+void modSynth::setParameters(param_t sparam) {
+	param = sparam;
+	values.resize(param.buffer_size);
+}
+
+int modSynth::startMon() {
+
+	// work per column could be passed as first -o parameter
+	if (param.options.size() > 0) {
+		const char* option = param.options[0].c_str();
+		char* end;
+		errno = 0;
+		work = strtoll(option, &end, 10);
+		if (end == option || *end != '\0' || errno == ERANGE) {
+			std::cerr << "modSynth: invalid work " << option << std::endl;
+			return 1;
+		}
+	}
+	if (work < 0) work = 0;
+	// projection could be switched off with the second
+	project = !(param.options.size() > 1 && param.options[1] == "off");
+
+	for (int i = 0; i < SYNTH_COLUMNS; ++i) acquire[i] = !project || param.columns.empty();
+	if (project) {
+		for (int col_i : param.columns) {
+			if (col_i >= SYNTH_FIRST_COLUMN && col_i < SYNTH_FIRST_COLUMN + SYNTH_COLUMNS) {
+				acquire[col_i - SYNTH_FIRST_COLUMN] = true;
+			}
+		}
+	}
+
+	interval_ns = param.interval_micro > 0 ? param.interval_micro * 1000LL : param.interval * 1000000000LL;
+	timer = param.reactor->addTimer(sampleTime() + interval_ns, interval_ns, [this](uint64_t expirations) {
+		sample();
+	});
+	if (timer < 0) {
+		std::cerr << "modSynth: could not create timer" << std::endl;
+		return 1;
+	}
+	stopmon = false;
+	return 0;
+}
+
+int modSynth::stopMon() {
+	stopmon = true;
+	if (timer >= 0) param.reactor->remove(timer);
+	timer = -1;
+	return 0;
+}
+
+bool modSynth::running() {
+	return !stopmon;
+}
+
+sampleBuffer * modSynth::getBuffer() {
+	return &values;
+}
+
+// the values do not depend on the targets, all targets share the samples
+bool modSynth::batched() {
+	return true;
+}
+
+sampleBuffer * modSynth::getTargetBuffer(int target_i) {
+	return &values;
+}
+
+bool modSynth::projection() {
+	return project;
+}
+
+std::vector<std::string> modSynth::getLabels() {
+	std::vector<std::string> labels = {"time", "cost", "load"};
+	for (int i = 0; i < SYNTH_COLUMNS; ++i) labels.push_back("c" + std::to_string(i));
+	return labels;
+}
+
+std::vector<field_type_t> modSynth::getColTypes() {
+	std::vector<field_type_t> types = {FIELD_TIME, FIELD_INT64, FIELD_DOUBLE};
+	types.insert(types.end(), SYNTH_COLUMNS, FIELD_INT64);
+	return types;
+}
+
+std::vector<int> modSynth::getColMaxSize() {
+	std::vector<int> sizes = {10, 12, 7};
+	sizes.insert(sizes.end(), SYNTH_COLUMNS, 7);
+	return sizes;
+}
+
+extern "C" module* createMod() {
+	return new modSynth;
+}
+
+extern "C" void destroyMod(module* p) {
+	delete p;
+}
+
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
+extern "C" const char* getHelp() {
+	return "Module usage:\n"
+			"-m MODSYNTH [-p PREFIX] [-c time] [-c cost] [-c load] [-c c0] ... [-c c11] "
+			"[-o WORK [-o PROJECTION]]\n\n"
+			"Columns:\n"
+			"time: UNIX timestamp when snapshot was taken\n"
+			"cost: Time needed for acquiring the sample (ns)\n"
+			"load: cost in % of the sampling interval\n"
+			"c0 - c11: Synthetic metrics, each one costs WORK iterations of a random number generator\n\n"
+			"Benchmark for the column projection of ProMoRIS: only the synthetic columns requested\n"
+			"with -c are acquired. Compare the cost column with and without PROJECTION, e.g.\n"
+			"promoris -m ./modSynth.so -c time -c cost -c c0 -I 100000 PROGRAM\n"
+			"promoris -m ./modSynth.so -c time -c cost -c c0 -o 200000 -o off -I 100000 PROGRAM\n\n"
+			"Options and defaults:\n"
+			"WORK = 200000 -- iterations per synthetic column and sample\n"
+			"PROJECTION = on -- off: acquire all columns like a module without projection support";
+}
@@ -0,0 +1,67 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODSYNTH_H
+#define MODSYNTH_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "../ProMoRIS/module.h"
+
+// number of synthetic columns c0, c1, ...
+#define SYNTH_COLUMNS 12
+// index of the first synthetic column (after time, cost and load)
+#define SYNTH_FIRST_COLUMN 3
+
+class modSynth : public module {
+public:
+	void setParameters(param_t sparam);
+	int startMon();
+	int stopMon();
+	bool running();
+	sampleBuffer * getBuffer();
+	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
+	std::vector<int> getColMaxSize();
+	bool batched();
+	sampleBuffer * getTargetBuffer(int target_i);
+	bool projection();
+	modSynth();
+	virtual ~modSynth();
+private:
+	sampleBuffer values;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// id of the sampling timer in the event loop
+	int timer;
+	int64_t interval_ns;
+	// iterations of the synthetic work per column
+	int64_t work;
+	// acquire only the requested columns
+	bool project;
+	// synthetic columns to be acquired
+	bool acquire[SYNTH_COLUMNS];
+	// state of the synthetic work, carried over between the samples
+	uint64_t state;
+	void sample();
+};
+
+#endif /* MODSYNTH_H */
@@ -0,0 +1,466 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "modTaskstats.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+
+// netlink messages are small, but a pass sends one request per target
+#define TASKSTATS_RCVBUF (1 << 20)
+
+// attributes of generic netlink messages
+#define GENLMSG_DATA(n) ((char*) NLMSG_DATA(n) + GENL_HDRLEN)
+#define NLA_DATA(na) ((char*) (na) + NLA_HDRLEN)
+
+typedef struct taskstats_msg_t {
+	nlmsghdr n;
+	genlmsghdr g;
+	char buffer[256];
+} taskstats_msg_t;
+
+// send a generic netlink request with a single attribute
+static bool sendRequest(int fd, uint16_t type, uint8_t cmd, uint32_t seq,
+		uint16_t attr_type, const void* attr_data, uint16_t attr_len) {
+	taskstats_msg_t msg;
+	memset(&msg, 0, sizeof (msg));
+	msg.n.nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+	msg.n.nlmsg_type = type;
+	msg.n.nlmsg_flags = NLM_F_REQUEST;
+	msg.n.nlmsg_seq = seq;
+	msg.g.cmd = cmd;
+	msg.g.version = 1;
+
+	nlattr* na = reinterpret_cast<nlattr*> (GENLMSG_DATA(&msg.n));
+	na->nla_type = attr_type;
+	na->nla_len = NLA_HDRLEN + attr_len;
+	memcpy(NLA_DATA(na), attr_data, attr_len);
+	msg.n.nlmsg_len += NLA_ALIGN(na->nla_len);
+
+	sockaddr_nl kernel;
+	memset(&kernel, 0, sizeof (kernel));
+	kernel.nl_family = AF_NETLINK;
+	return sendto(fd, &msg, msg.n.nlmsg_len, 0, reinterpret_cast<sockaddr*> (&kernel),
+			sizeof (kernel)) == static_cast<ssize_t> (msg.n.nlmsg_len);
+}
+
+// first attribute of type type in [data, data + len), nullptr if there is none
+static nlattr* findAttr(char* data, int len, uint16_t type) {
+	while (len >= static_cast<int> (NLA_HDRLEN)) {
+		nlattr* na = reinterpret_cast<nlattr*> (data);
+		if (na->nla_len < NLA_HDRLEN || na->nla_len > len) return nullptr;
+		if ((na->nla_type & NLA_TYPE_MASK) == type) return na;
+		len -= NLA_ALIGN(na->nla_len);
+		data += NLA_ALIGN(na->nla_len);
+	}
+	return nullptr;
+}
+
+modTaskstats::modTaskstats() : values(1), stopmon(true), nl_fd(-1), family_id(0), seq(0),
+timer(-1), reader(-1), targets_left(0), pending(0), collecting(false), last_ns(0), pass_ns(0) {
+}
+
+modTaskstats::~modTaskstats() {
+	stopMon();
+}
+
+// open the netlink socket and resolve the id of the TASKSTATS family
+int modTaskstats::openNetlink() {
+	nl_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+	if (nl_fd < 0) {
+		std::cerr << "modTaskstats: could not open netlink socket: " << strerror(errno) << std::endl;
+		return 1;
+	}
+	int rcvbuf = TASKSTATS_RCVBUF;
+	setsockopt(nl_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof (rcvbuf));
+	// the queries of startMon wait at most 1 s if the kernel does not answer,
+	// the event loop never waits (MSG_DONTWAIT)
+	timeval timeout = {1, 0};
+	setsockopt(nl_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+
+	if (!sendRequest(nl_fd, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 0, CTRL_ATTR_FAMILY_NAME,
+			TASKSTATS_GENL_NAME, sizeof (TASKSTATS_GENL_NAME))) {
+		std::cerr << "modTaskstats: could not query the taskstats family: " << strerror(errno) << std::endl;
+		return 1;
+	}
+	taskstats_msg_t reply;
+	ssize_t n = recv(nl_fd, &reply, sizeof (reply), 0);
+	if (n < 0 || !NLMSG_OK(&reply.n, n) || reply.n.nlmsg_type == NLMSG_ERROR) {
+		std::cerr << "modTaskstats: taskstats is not supported by the kernel" << std::endl;
+		return 1;
+	}
+	nlattr* na = findAttr(GENLMSG_DATA(&reply.n), NLMSG_PAYLOAD(&reply.n, GENL_HDRLEN), CTRL_ATTR_FAMILY_ID);
+	if (na == nullptr) {
+		std::cerr << "modTaskstats: taskstats is not supported by the kernel" << std::endl;
+		return 1;
+	}
+	family_id = *reinterpret_cast<uint16_t*> (NLA_DATA(na));
+	return 0;
+}
+
+// bytes read from and written to storage by all threads
+// (taskstats only accounts them per thread, not per thread group)
+void modTaskstats::readIo(taskstats_target_t& target) {
+	char buffer[1024];
+	ssize_t n = pread(target.fd_io, buffer, sizeof (buffer) - 1, 0);
+	if (n <= 0) return;
+	buffer[n] = '\0';
+	const char* p = strstr(buffer, "\nread_bytes:");
+	if (p != nullptr) target.current.read_bytes = strtoll(p + 12, nullptr, 10);
+	p = strstr(buffer, "\nwrite_bytes:");
+	if (p != nullptr) target.current.write_bytes = strtoll(p + 13, nullptr, 10);
+}
+
+// send the requests of a pass for all targets, the replies are collected by receive()
+// returns false on errors which affect all targets
+bool modTaskstats::request() {
+	seq += targets.size();
+	// terminated targets get no request, so only the replies of the requests sent are awaited
+	pending = 0;
+	for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+		taskstats_target_t& target = targets[target_i];
+		target.replied = false;
+		if (target.terminated) continue;
+		uint32_t tgid = target.pid;
+		if (!sendRequest(nl_fd, family_id, TASKSTATS_CMD_GET, seq + target_i,
+				TASKSTATS_CMD_ATTR_TGID, &tgid, sizeof (tgid))) {
+			std::cerr << "modTaskstats: could not send request: " << strerror(errno) << std::endl;
+			return false;
+		}
+		++pending;
+	}
+	return true;
+}
+
+// read the replies of the current pass until all arrived or no more are available
+// (MSG_DONTWAIT in the event loop), returns false on errors which affect all targets
+bool modTaskstats::receive(int flags) {
+	char buffer[4096];
+	while (pending > 0) {
+		ssize_t n = recv(nl_fd, buffer, sizeof (buffer), flags);
+		if (n < 0) {
+			if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return true;
+			std::cerr << "modTaskstats: no reply from the kernel: " << strerror(errno) << std::endl;
+			return false;
+		}
+		// late replies of a previous pass are skipped
+		nlmsghdr* msg = reinterpret_cast<nlmsghdr*> (buffer);
+		if (!NLMSG_OK(msg, n) || msg->nlmsg_seq < seq || msg->nlmsg_seq >= seq + targets.size()) continue;
+		taskstats_target_t& target = targets[msg->nlmsg_seq - seq];
+		--pending;
+
+		if (msg->nlmsg_type == NLMSG_ERROR) {
+			int error = -reinterpret_cast<nlmsgerr*> (NLMSG_DATA(msg))->error;
+			if (error == ESRCH) {
+				target.terminated = true;
+				continue;
+			}
+			std::cerr << "modTaskstats: taskstats request failed: " << strerror(error);
+			if (error == EPERM) std::cerr << " (CAP_NET_ADMIN is required)";
+			std::cerr << std::endl;
+			return false;
+		}
+
+		// the stats are nested in TASKSTATS_TYPE_AGGR_TGID
+		nlattr* aggr = findAttr(GENLMSG_DATA(msg), NLMSG_PAYLOAD(msg, GENL_HDRLEN), TASKSTATS_TYPE_AGGR_TGID);
+		if (aggr == nullptr) continue;
+		nlattr* na = findAttr(NLA_DATA(aggr), aggr->nla_len - NLA_HDRLEN, TASKSTATS_TYPE_STATS);
+		if (na == nullptr) continue;
+
+		// the struct grows with new kernels, older kernels send a shorter one
+		taskstats stats;
+		memset(&stats, 0, sizeof (stats));
+		memcpy(&stats, NLA_DATA(na), std::min<size_t> (na->nla_len - NLA_HDRLEN, sizeof (stats)));
+
+		target.current.cpu_run = stats.cpu_run_real_total;
+		target.current.cpu_delay = stats.cpu_delay_total;
+		target.current.blkio_delay = stats.blkio_delay_total;
+		target.current.swapin_delay = stats.swapin_delay_total;
+		target.current.vctx = stats.nvcsw;
+		target.current.nvctx = stats.nivcsw;
+		readIo(target);
+		target.replied = true;
+	}
+	return true;
+}
+
+// start a pass, called by the timer of the event loop
+void modTaskstats::sample() {
+	// replies which did not arrive within an interval are not waited for any longer
+	if (collecting) publish();
+	if (stopmon) return;
+
+	// time stamps of the samples and base of the rates
+	pass_ns = sampleTime();
+	if (!request()) {
+		halt();
+		return;
+	}
+	collecting = true;
+	if (pending == 0) publish();
+}
+
+// replies are available on the netlink socket, called by the event loop
+void modTaskstats::replies() {
+	if (!receive(MSG_DONTWAIT)) {
+		halt();
+		return;
+	}
+	if (collecting && pending == 0) publish();
+}
+
+// publish the samples of the targets which replied in the current pass
+void modTaskstats::publish() {
+	collecting = false;
+
+	// times in % of the time since the last pass
+	double factor = 100.0 / (pass_ns - last_ns);
+
+	for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+		taskstats_target_t& target = targets[target_i];
+		if (target.terminated && target.fd_io >= 0) {
+			close(target.fd_io);
+			target.fd_io = -1;
+			--targets_left;
+		}
+		if (!target.replied) continue;
+		const taskstats_reading_t& last = target.last;
+		const taskstats_reading_t& current = target.current;
+
+		sample_t* sample = values[target_i].claim();
+		sample->time = pass_ns;
+		sample->fields[1].d = (current.cpu_run - last.cpu_run) * factor;
+		sample->fields[2].d = (current.cpu_delay - last.cpu_delay) * factor;
+		sample->fields[3].d = (current.blkio_delay - last.blkio_delay) * factor;
+		sample->fields[4].d = (current.swapin_delay - last.swapin_delay) * factor;
+		sample->fields[5].i = current.read_bytes;
+		sample->fields[6].i = current.write_bytes;
+		sample->fields[7].i = current.vctx;
+		sample->fields[8].i = current.nvctx;
+		values[target_i].publish();
+
+		target.last = current;
+	}
+
+	last_ns = pass_ns;
+
+	// stop when the last target terminated
+	if (targets_left == 0) halt();
+}
+
+// stop sampling from a callback, the sockets are closed by stopMon
+void modTaskstats::halt() {
+	if (timer >= 0) param.reactor->remove(timer);
+	timer = -1;
+	if (reader >= 0) param.reactor->remove(reader);
+	reader = -1;
+	collecting = false;
+	stopmon = true;
+}
+
+void modTaskstats::setParameters(param_t sparam) {
+	param = sparam;
+	if (param.targets.empty()) param.targets.push_back(param.pid_struct);
+
+	targets.clear();
+	for (auto pid : param.targets) {
+		taskstats_target_t target;
+		memset(&target, 0, sizeof (target));
+		target.pid = pid;
+		target.fd_io = -1;
+		targets.push_back(target);
+	}
+	values = std::vector<sampleBuffer>(targets.size());
+	for (auto &buffer : values) buffer.resize(param.buffer_size);
+}
+
+int modTaskstats::startMon() {
+	// sampling interval could be passed as first -o parameter, checked before anything is opened
+	long long option_us = 0;
+	if (param.options.size() > 0) {
+		const char* option = param.options[0].c_str();
+		char* end;
+		errno = 0;
+		option_us = strtoll(option, &end, 10);
+		if (end == option || *end != '\0' || errno == ERANGE || option_us < 1) {
+			std::cerr << "modTaskstats: invalid interval " << option << std::endl;
+			return 1;
+		}
+	}
+
+	if (openNetlink() != 0) {
+		stopMon();
+		return 1;
+	}
+
+	// targets which cannot be opened are not monitored, only the opened ones are left
+	targets_left = 0;
+	for (auto &target : targets) {
+		std::string path = "/proc/" + std::to_string(target.pid) + "/io";
+		target.fd_io = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (target.fd_io >= 0) {
+			++targets_left;
+			continue;
+		}
+		// a process of another user is not terminated, but cannot be monitored
+		if (errno == EACCES || errno == EPERM) {
+			std::cerr << "modTaskstats: cannot monitor process " << target.pid << ": " << strerror(errno) << std::endl;
+		}
+		target.terminated = true;
+	}
+
+	// the delay columns stay 0 without delay accounting
+	char delayacct = '1';
+	int fd = open("/proc/sys/kernel/task_delayacct", O_RDONLY | O_CLOEXEC);
+	if (fd >= 0) {
+		if (read(fd, &delayacct, 1) != 1) delayacct = '1';
+		close(fd);
+	}
+	if (delayacct == '0') {
+		std::cerr << "modTaskstats: delay accounting is disabled, the delay columns will be 0 "
+				"(enable it with sysctl kernel.task_delayacct=1)" << std::endl;
+	}
+
+	// first pass only serves as a base for the percentages, it is waited for
+	// to report missing permissions before the monitoring starts
+	last_ns = sampleTime();
+	if (!request() || !receive(0)) {
+		stopMon();
+		return 1;
+	}
+	if (pending > 0) {
+		std::cerr << "modTaskstats: no reply from the kernel" << std::endl;
+		stopMon();
+		return 1;
+	}
+	for (auto &target : targets) target.last = target.current;
+
+	reader = param.reactor->addReadable(nl_fd, [this]() {
+		replies();
+	});
+	if (reader < 0) {
+		std::cerr << "modTaskstats: could not watch the netlink socket" << std::endl;
+		stopMon();
+		return 1;
+	}
+
+	int64_t interval_ns;
+	if (param.options.size() > 0) interval_ns = option_us * 1000LL;
+	else if (param.interval_micro > 0) interval_ns = param.interval_micro * 1000LL;
+	else interval_ns = param.interval * 1000000000LL;
+	if (interval_ns < 1000) interval_ns = 1000;
+
+	timer = param.reactor->addTimer(last_ns + interval_ns, interval_ns, [this](uint64_t expirations) {
+		sample();
+	});
+	if (timer < 0) {
+		std::cerr << "modTaskstats: could not create timer" << std::endl;
+		stopMon();
+		return 1;
+	}
+	stopmon = false;
+
+	return 0;
+}
+
+int modTaskstats::stopMon() {
+	halt();
+	for (auto &target : targets) {
+		if (target.fd_io >= 0) close(target.fd_io);
+		target.fd_io = -1;
+	}
+	if (nl_fd >= 0) close(nl_fd);
+	nl_fd = -1;
+	return 0;
+}
+
+bool modTaskstats::running() {
+	return !stopmon;
+}
+
+sampleBuffer * modTaskstats::getBuffer() {
+	return &values[0];
+}
+
+bool modTaskstats::batched() {
+	return true;
+}
+
+sampleBuffer * modTaskstats::getTargetBuffer(int target_i) {
+	return &values[target_i];
+}
+
+std::vector<std::string> modTaskstats::getLabels() {
+	return {"time", "pcpu", "cpudelay", "iodelay", "swapdelay", "rbytes", "wbytes", "vctx", "nvctx"};
+}
+
+std::vector<field_type_t> modTaskstats::getColTypes() {
+	return {FIELD_TIME, FIELD_DOUBLE, FIELD_DOUBLE, FIELD_DOUBLE, FIELD_DOUBLE,
+		FIELD_INT64, FIELD_INT64, FIELD_INT64, FIELD_INT64};
+}
+
+std::vector<int> modTaskstats::getColMaxSize() {
+	return {10, 7, 7, 7, 7, 15, 15, 12, 12};
+}
+
+extern "C" module* createMod() {
+	return new modTaskstats;
+}
+
+extern "C" void destroyMod(module* p) {
+	delete p;
+}
+
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
+extern "C" const char* getHelp() {
+	return "Module usage:\n"
+			"-m MODTASKSTATS [-p PREFIX] [-c time] [-c pcpu] [-c cpudelay] [-c iodelay] "
+			"[-c swapdelay] [-c rbytes] [-c wbytes] [-c vctx] [-c nvctx] [-o SAMPLE_MICRO]\n\n"
+			"Columns:\n"
+			"time: UNIX timestamp when snapshot was taken\n"
+			"pcpu: CPU run time since the last snapshot (% of one CPU)\n"
+			"cpudelay: Time spent waiting on a run queue since the last snapshot (% of the time)\n"
+			"iodelay: Time spent waiting for block I/O since the last snapshot (% of the time)\n"
+			"swapdelay: Time spent waiting for swap-in since the last snapshot (% of the time)\n"
+			"rbytes: Bytes read from storage since process start\n"
+			"wbytes: Bytes written to storage since process start\n"
+			"vctx: Voluntary context switches since process start\n"
+			"nvctx: Involuntary context switches since process start\n\n"
+			"Queries the taskstats interface of the kernel over generic netlink, one request per\n"
+			"target and snapshot, all threads of a process are summed up. rbytes and wbytes are read\n"
+			"from /proc/PID/io, because taskstats only accounts them per thread.\n"
+			"The delays are summed up over all threads, so they can exceed 100 % for multi-threaded\n"
+			"processes.\n\n"
+			"Please note that taskstats requires CAP_NET_ADMIN, so ProMoRIS usually has to run as root.\n"
+			"The delay columns need delay accounting (sysctl kernel.task_delayacct=1 or the\n"
+			"delayacct boot parameter), otherwise they stay 0.\n\n"
+			"Options and defaults:\n"
+			"SAMPLE_MICRO -- sampling interval in microseconds (default: the ProMoRIS interval)";
+}
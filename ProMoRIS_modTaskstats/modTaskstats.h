@@ -0,0 +1,102 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MODTASKSTATS_H
+#define MODTASKSTATS_H
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <atomic>
+#include "../ProMoRIS/module.h"
+
+// counters of one process taken from taskstats (nanoseconds) and /proc/<pid>/io (bytes)
+typedef struct taskstats_reading_t {
+	int64_t cpu_run;
+	int64_t cpu_delay;
+	int64_t blkio_delay;
+	int64_t swapin_delay;
+	int64_t vctx;
+	int64_t nvctx;
+	int64_t read_bytes;
+	int64_t write_bytes;
+} taskstats_reading_t;
+
+// state of one monitored process
+typedef struct taskstats_target_t {
+	pid_t pid;
+	// /proc/<pid>/io, read again with pread for every sample
+	int fd_io;
+	// last reading, base for the CPU and delay percentages
+	taskstats_reading_t last;
+	// reading of the current pass, filled by the reply
+	taskstats_reading_t current;
+	bool replied;
+	// process does not exist anymore
+	bool terminated;
+} taskstats_target_t;
+
+class modTaskstats : public module {
+public:
+	void setParameters(param_t sparam);
+	int startMon();
+	int stopMon();
+	bool running();
+	sampleBuffer * getBuffer();
+	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
+	std::vector<int> getColMaxSize();
+	bool batched();
+	sampleBuffer * getTargetBuffer(int target_i);
+	modTaskstats();
+	virtual ~modTaskstats();
+private:
+	// one buffer per target
+	std::vector<sampleBuffer> values;
+	std::vector<taskstats_target_t> targets;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// generic netlink socket and id of the TASKSTATS family
+	int nl_fd;
+	uint16_t family_id;
+	// sequence number of the first request of the current pass
+	uint32_t seq;
+	// ids of the sampling timer and of the netlink socket in the event loop
+	int timer;
+	int reader;
+	// targets which still exist
+	size_t targets_left;
+	// replies still awaited in the current pass, and whether the pass is not published yet
+	size_t pending;
+	bool collecting;
+	// time of the last pass, base for the percentages
+	int64_t last_ns;
+	// time of the current pass
+	int64_t pass_ns;
+	int openNetlink();
+	bool request();
+	bool receive(int flags);
+	void readIo(taskstats_target_t& target);
+	void sample();
+	void replies();
+	void publish();
+	void halt();
+};
+
+#endif /* MODTASKSTATS_H */
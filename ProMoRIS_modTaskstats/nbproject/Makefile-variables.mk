@@ -0,0 +1,35 @@
+#
+# Generated - do not edit!
+#
+# NOCDDL
+#
+CND_BASEDIR=`pwd`
+CND_BUILDDIR=build
+CND_DISTDIR=dist
+# Debug configuration
+CND_PLATFORM_Debug=GNU-Linux
+CND_ARTIFACT_DIR_Debug=dist/Debug/GNU-Linux
+CND_ARTIFACT_NAME_Debug=libProMoRIS_modTaskstats.so
+CND_ARTIFACT_PATH_Debug=dist/Debug/GNU-Linux/libProMoRIS_modTaskstats.so
+CND_PACKAGE_DIR_Debug=dist/Debug/GNU-Linux/package
+CND_PACKAGE_NAME_Debug=libProMoRISmodTaskstats.so.tar
+CND_PACKAGE_PATH_Debug=dist/Debug/GNU-Linux/package/libProMoRISmodTaskstats.so.tar
+# Release configuration
+CND_PLATFORM_Release=GNU-Linux
+CND_ARTIFACT_DIR_Release=dist/Release/GNU-Linux
+CND_ARTIFACT_NAME_Release=libProMoRIS_modTaskstats.so
+CND_ARTIFACT_PATH_Release=dist/Release/GNU-Linux/libProMoRIS_modTaskstats.so
+CND_PACKAGE_DIR_Release=dist/Release/GNU-Linux/package
+CND_PACKAGE_NAME_Release=libProMoRISmodTaskstats.so.tar
+CND_PACKAGE_PATH_Release=dist/Release/GNU-Linux/package/libProMoRISmodTaskstats.so.tar
+#
+# include compiler specific variables
+#
+# dmake command
+ROOT:sh = test -f nbproject/private/Makefile-variables.mk || \
+	(mkdir -p nbproject/private && touch nbproject/private/Makefile-variables.mk)
+#
+# gmake command
+.PHONY: $(shell test -f nbproject/private/Makefile-variables.mk || (mkdir -p nbproject/private && touch nbproject/private/Makefile-variables.mk))
+#
+include nbproject/private/Makefile-variables.mk
@@ -22,152 +22,180 @@
 #include <sstream>
 #include <stdio.h>
 #include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <signal.h>
+#include <sys/wait.h>
 
-// definitions
-param_t modTop::param;
-bool modTop::stopmon;
-std::thread modTop::t1;
-std::vector<std::vector<std::string>> modTop::values;
-std::mutex modTop::values_m;
-
-const std::vector<std::string> modTop::explodeTop(const std::string& line) {
-	std::string b = "";
-	std::vector<std::string> v;
-
-	for(auto currentChar : line) {
-		if(currentChar != ' ' && currentChar != '\n') b += currentChar;
-		else if(currentChar == ' ' && b != "") {
-			v.push_back(b);
-			b = "";
-		}
-	}
-	if (b != "") v.push_back(b);
-
-	return v;
-}
-
-int modTop::runMon() {
-
-	// file handle to read command with popen
-	FILE *fp;
-	// one line of the top output
-	char line[1000];
-	// string array of the relevant values from the current line
-	std::string current_values[3];
-	// shell command to execute
-	std::string cmd;
-	// shell command as C char* array
-	const char *cmdc;
-	// popen/pclose status
-	int status;
-	// space to save the values from the current line
-	std::vector<std::string> topvalues;
-
-	// start top and open pipe
-	cmd = "COLUMNS=998 LINES=50 LC_NUMERIC=en_US top -b -d " + 
-			std::to_string(param.interval) + " -p " + param.pid;
-	cmdc = cmd.c_str();
-	fp = popen(cmdc, "r");
-
-	if (fp == NULL) {
-		std::cerr << "modTop: Opening command failed" << std::endl;
-		return 1;
-	}
-	
-	// open tracefile if option is set
-	std::ofstream tracefile;
-	bool trace = false;
-	if (param.options.size() > 0) {
-		trace = true;
-		tracefile.open(param.options[0]);
-		if (!tracefile.is_open()) {
-			std::cerr << "modTop: trace file could not be opened" << std::endl;
-			return 1;
-		}
-	}
+// top accepts at most 20 PIDs
+#define TOP_MAX_PIDS 20
 
-	int lineCount = 0;
-
-	// read and analyze the relevant lines of the top output
-	while (fgets(line, 1000, fp)) {
-		
-		// write to tracefile
-		if (trace) tracefile << line;
-		
-		if (lineCount == 7) {
-
-			// split the line into single values
-			topvalues = explodeTop(line);
-			
-			lineCount = -1;
-			
-			std::stringstream timeGen;
-			timeGen << time(nullptr);
-
-			// write current timestamp and relevant values to values array
-			std::lock_guard<std::mutex> values_guard(values_m);
-			values.push_back(std::vector<std::string> {timeGen.str(),
-					topvalues[4], topvalues[5], topvalues[6], 
-					topvalues[8], topvalues[9]});
-			
-		}
-		else ++lineCount;
-		
-		if (stopmon == true) break;
-	}
-	
-	stopmon = true;
-	
-	if (trace) tracefile.close();
+modTop::modTop() : values(1), stopmon(true), top_fd(-1), top_pid(0), source(-1) {
+}
 
-	status = pclose(fp);
-	
-	if (status == -1) {
-		std::cerr << "modTop: Error closing pipe" << std::endl;
-		return 1;
-	}
+modTop::~modTop() {
+	stopMon();
+}
 
-	return 0;
+// parse one line of the top output
+void modTop::parseLine(const char* line) {
+
+	// write to tracefile
+	if (tracefile.isOpen()) tracefile.record(line);
+
+	parser.parseLine(line);
 
 }
 
 void modTop::setParameters(param_t sparam) {
 	param = sparam;
+	if (param.targets.empty()) param.targets.push_back(param.pid_struct);
+	values = std::vector<sampleBuffer>(param.targets.size());
+	for (auto &buffer : values) buffer.resize(param.buffer_size);
+	parser = topParser(&param.targets, &values);
 
 }
 
 int modTop::startMon() {
-	stopmon = false;
-	// start monitoring thread (runMon)
+	if (param.targets.size() > TOP_MAX_PIDS) {
+		std::cerr << "modTop: top can monitor at most " << TOP_MAX_PIDS << " processes, "
+				"please use modProc for more targets" << std::endl;
+		return 1;
+	}
 
-	t1 = std::thread(runMon);
+	// replay the tracefile instead of running top
+	if (param.replay_speed >= 0) {
+		if (param.options.size() == 0) {
+			std::cerr << "modTop: replay requires TRACEFILE" << std::endl;
+			return 1;
+		}
+		// snapshots of traces without time stamps are INTERVAL apart like in the conversion
+		int64_t interval_ns = param.interval_micro > 0 ? param.interval_micro * 1000LL : param.interval * SAMPLE_TIME_PER_SECOND;
+		parser.reset();
+		stopmon = false;
+		if (!replay.start(param.options[0], param.replay_speed, param.reactor, [this](const char* line) {
+				parser.parseLine(line);
+			}, [this]() {
+				stopmon = true;
+			}, "top - ", interval_ns)) {
+			std::cerr << "modTop: trace file could not be read" << std::endl;
+			stopmon = true;
+			return 1;
+		}
+		return 0;
+	}
+
+	// open tracefile if option is set, the format could be passed as second -o parameter
+	if (param.options.size() > 0) {
+		bool timed = false;
+		if (param.options.size() > 1 && !traceRecorder::parseFormat(param.options[1], timed)) {
+			std::cerr << "modTop: unknown trace format " << param.options[1] << std::endl;
+			return 1;
+		}
+		if (!tracefile.open(param.options[0], timed)) {
+			std::cerr << "modTop: trace file could not be opened" << std::endl;
+			return 1;
+		}
+	}
+
+	// start top for all targets and open pipe
+	std::string pids;
+	for (auto pid : param.targets) {
+		if (!pids.empty()) pids += ",";
+		pids += std::to_string(pid);
+	}
+	std::string cmd = "COLUMNS=998 LINES=50 LC_NUMERIC=en_US top -b -d " + 
+			std::to_string(param.interval) + " -p " + pids;
+	top_fd = spawnCommand(cmd, top_pid);
+	if (top_fd < 0) {
+		std::cerr << "modTop: Opening command failed" << std::endl;
+		return 1;
+	}
+
+	// the lines are parsed by the event loop of ProMoRIS
+	parser.reset();
+	stopmon = false;
+	source = param.reactor->addLines(top_fd, [this](const char* line) {
+		parseLine(line);
+	}, [this]() {
+		source = -1;
+		stopmon = true;
+	});
 
 	return 0;
 }
 
 int modTop::stopMon() {
 	stopmon = true;
-	t1.join();
+	if (source >= 0) param.reactor->remove(source);
+	source = -1;
+	if (top_fd >= 0) {
+		close(top_fd);
+		kill(-top_pid, SIGTERM);
+		waitpid(top_pid, nullptr, 0);
+		top_fd = -1;
+	}
+	replay.stop();
+	tracefile.close();
 	return 0;
 
 }
 
+bool modTop::convertTrace() {
+	if (param.options.size() == 0) {
+		std::cerr << "modTop: conversion requires TRACEFILE" << std::endl;
+		return false;
+	}
+	traceFile trace;
+	if (!trace.open(param.options[0])) {
+		std::cerr << "modTop: trace file could not be read" << std::endl;
+		return false;
+	}
+
+	// at most one sample per snapshot and target
+	size_t snapshots = trace.count("top - ");
+	for (auto &buffer : values) buffer.resize(snapshots + 1);
+
+	// snapshots of traces without time stamps are INTERVAL apart, starting at the UNIX epoch
+	int64_t interval_ns = param.interval_micro > 0 ? param.interval_micro * 1000LL : param.interval * SAMPLE_TIME_PER_SECOND;
+	int64_t snapshot = 0;
+	const char* line;
+	int64_t time;
+	parser.reset();
+	while (trace.next(line, time)) {
+		if (time < 0) {
+			if (strncmp(line, "top - ", 6) == 0) ++snapshot;
+			time = std::max(snapshot - 1, (int64_t) 0) * interval_ns;
+		}
+		parser.parseLine(line, time);
+	}
+	return true;
+}
+
 bool modTop::running() {
 	return !stopmon;
 }
 
-std::vector<std::vector<std::string>> * modTop::getValuesPtr() {
-	return &values;
+sampleBuffer * modTop::getBuffer() {
+	return &values[0];
+}
+
+bool modTop::batched() {
+	return true;
 }
 
-std::mutex * modTop::getValuesMPtr() {
-	return &values_m;
+sampleBuffer * modTop::getTargetBuffer(int target_i) {
+	return &values[target_i];
 }
 
 std::vector<std::string> modTop::getLabels() {
 	return {"time", "virt", "res", "shr", "pcpu", "pmem"};
 }
 
+std::vector<field_type_t> modTop::getColTypes() {
+	return {FIELD_TIME, FIELD_INT64, FIELD_INT64, FIELD_INT64, FIELD_DOUBLE, FIELD_DOUBLE};
+}
+
 std::vector<int> modTop::getColMaxSize() {
 	return {10, 15, 15, 15, 5, 5};
 }
@@ -180,10 +208,14 @@ extern "C" void destroyMod(module* p) {
 	delete p;
 }
 
+extern "C" int getApiVersion() {
+	return MODULE_API_VERSION;
+}
+
 extern "C" const char* getHelp() {
 	return "Module usage:\n"
 			"-m MODTOP [-p PREFIX] [-c time] [-c virt] [-c res] [-c shr] "
-			"[-c pcpu] [-c pmem] [-o TRACEFILE]\n\n"
+			"[-c pcpu] [-c pmem] [-o TRACEFILE [-o TRACEFORMAT]]\n\n"
 			"Columns:\n"
 			"time: UNIX timestamp when snapshot was taken\n"
 			"virt: Virtual memory usage (KiB)\n"
@@ -192,5 +224,9 @@ extern "C" const char* getHelp() {
 			"pcpu: CPU usage (%)\n"
 			"pmem: Resident memory usage (%)\n\n"
 			"Options and defaults:\n"
-			"TRACEFILE -- if set, writes the raw batch output of top to TRACEFILE";
+			"TRACEFILE -- if set, writes the raw batch output of top to TRACEFILE,\n"
+			"	with promoris -r the trace is replayed instead of running top, promoris --convert converts it\n"
+			"TRACEFORMAT = raw -- raw: the output of top unchanged, timed: a #promoris-trace header and\n"
+			"	OFFSET<TAB>LINE lines with the time each line was received (ns), so -r keeps the original timing\n\n"
+			"All targets (at most 20) are monitored by a single top process.";
 }
@@ -24,10 +24,13 @@
 #include <string>
 #include <vector>
 #include <tuple>
-#include <thread>
+#include <atomic>
 #include <mutex>
 #include <array>
+#include <fstream>
 #include "../ProMoRIS/module.h"
+#include "../ProMoRIS/trace.h"
+#include "topparser.h"
 
 class modTop : public module {
 public:
@@ -35,20 +38,31 @@ public:
 	int startMon();
 	int stopMon();
 	bool running();
-	std::vector<std::vector<std::string>> * getValuesPtr();
-	std::mutex * getValuesMPtr();
+	sampleBuffer * getBuffer();
 	std::vector<std::string> getLabels();
+	std::vector<field_type_t> getColTypes();
 	std::vector<int> getColMaxSize();
-	modTop() {}
-	virtual ~modTop() {}
+	bool batched();
+	sampleBuffer * getTargetBuffer(int target_i);
+	bool convertTrace();
+	modTop();
+	virtual ~modTop();
 private:
-	static std::vector<std::vector<std::string>> values;
-	static std::mutex values_m;
-	static param_t param;
-	static bool stopmon;
-	static std::thread t1;
-	static const std::vector<std::string> explodeTop(const std::string& line);
-	static int runMon();
+	// one buffer per target
+	std::vector<sampleBuffer> values;
+	param_t param;
+	std::atomic<bool> stopmon;
+	// top process and its stdout
+	int top_fd;
+	pid_t top_pid;
+	// id of the pipe in the event loop
+	int source;
+	// write the raw output of top to tracefile
+	traceRecorder tracefile;
+	// replay of the tracefile (promoris -r)
+	traceReplay replay;
+	topParser parser;
+	void parseLine(const char* line);
 };
 
 #endif /* MODTOP_H */
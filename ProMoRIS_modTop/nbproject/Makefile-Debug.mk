@@ -35,7 +35,9 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/modTop.o
+	${OBJECTDIR}/_ext/ProMoRIS/trace.o \
+	${OBJECTDIR}/modTop.o \
+	${OBJECTDIR}/topparser.o
 
 
 # C Compiler Flags
@@ -67,6 +69,16 @@ ${OBJECTDIR}/modTop.o: modTop.cpp
 	${RM} "$@.d"
 	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/modTop.o modTop.cpp
 
+${OBJECTDIR}/topparser.o: topparser.cpp
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/topparser.o topparser.cpp
+
+${OBJECTDIR}/_ext/ProMoRIS/trace.o: ../ProMoRIS/trace.cpp
+	${MKDIR} -p ${OBJECTDIR}/_ext/ProMoRIS
+	${RM} "$@.d"
+	$(COMPILE.cc) -g -std=c++14 -fPIC  -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/_ext/ProMoRIS/trace.o ../ProMoRIS/trace.cpp
+
 # Subprojects
 .build-subprojects:
 
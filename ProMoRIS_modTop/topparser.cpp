@@ -0,0 +1,106 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "topparser.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+const std::vector<std::string> topParser::explodeTop(const std::string& line) {
+	std::string b = "";
+	std::vector<std::string> v;
+
+	for(auto currentChar : line) {
+		if(currentChar != ' ' && currentChar != '\n') b += currentChar;
+		else if(currentChar == ' ' && b != "") {
+			v.push_back(b);
+			b = "";
+		}
+	}
+	if (b != "") v.push_back(b);
+
+	return v;
+}
+
+int topParser::splitTop(const char* line, const char** tokens, int max) {
+	int n = 0;
+	while (n < max) {
+		while (*line == ' ') ++line;
+		if (*line == '\0' || *line == '\n') break;
+		tokens[n++] = line;
+		while (*line != ' ' && *line != '\0' && *line != '\n') ++line;
+	}
+	return n;
+}
+
+int64_t topParser::parseTopMem(const std::string& value) {
+	return parseTopMem(value.c_str());
+}
+
+// convert a memory value of top to KiB
+// top switches to a unit suffix (m, g, t, ...) when the value does not fit into the column
+int64_t topParser::parseTopMem(const char* value) {
+	char* suffix;
+	double mem = strtod(value, &suffix);
+	switch (*suffix) {
+		case 'e': mem *= 1024.0; // fall through
+		case 'p': mem *= 1024.0; // fall through
+		case 't': mem *= 1024.0; // fall through
+		case 'g': mem *= 1024.0; // fall through
+		case 'm': mem *= 1024.0; // fall through
+		default: break;
+	}
+	return static_cast<int64_t> (mem);
+}
+
+void topParser::parseLine(const char* line, int64_t time) {
+
+	// split the line into single values, without copies
+	const char* topvalues[TOP_PROCESS_FIELDS];
+	int n = splitTop(line, topvalues, TOP_PROCESS_FIELDS);
+
+	// the process lines follow the header line starting with PID until an empty line
+	if (n == 0) {
+		process_lines = false;
+	} else if (!process_lines) {
+		if (strncmp(topvalues[0], "PID", 3) == 0 && (topvalues[0][3] == ' ' || topvalues[0][3] == '\0' || topvalues[0][3] == '\n')) {
+			process_lines = true;
+			timestamp = time >= 0 ? time : sampleTime();
+		}
+	} else if (n >= TOP_PROCESS_FIELDS) {
+
+		// buffer of the target of this line
+		auto target = std::find(targets->begin(), targets->end(), atoi(topvalues[0]));
+		if (target == targets->end()) return;
+		sampleBuffer& buffer = (*buffers)[target - targets->begin()];
+
+		sample_t* sample = buffer.claim();
+		sample->time = timestamp;
+		sample->fields[1].i = parseTopMem(topvalues[4]);
+		sample->fields[2].i = parseTopMem(topvalues[5]);
+		sample->fields[3].i = parseTopMem(topvalues[6]);
+		sample->fields[4].d = strtod(topvalues[8], nullptr);
+		sample->fields[5].d = strtod(topvalues[9], nullptr);
+
+		// publish current timestamp and relevant values
+		buffer.publish();
+
+	}
+
+}
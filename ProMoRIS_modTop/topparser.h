@@ -0,0 +1,62 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOPPARSER_H
+#define TOPPARSER_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+#include "../ProMoRIS/module.h"
+
+// fields of a process line used by the parser
+#define TOP_PROCESS_FIELDS 10
+
+/*
+ * Parser of the batch output of top: the process lines of a snapshot follow the
+ * header line starting with PID until an empty line. One sample per snapshot
+ * and target is published, with the time stamp of the header line.
+ * Kept apart from modTop, so promoris-bench can drive it without top.
+ */
+class topParser {
+public:
+	topParser() : targets(nullptr), buffers(nullptr), process_lines(false), timestamp(0) {}
+	// the samples of targets[i] are published to buffers[i]
+	topParser(const std::vector<pid_t>* targets, std::vector<sampleBuffer>* buffers) :
+	targets(targets), buffers(buffers), process_lines(false), timestamp(0) {}
+	// parse one line of the top output received at time (sample_t::time), -1 for now
+	void parseLine(const char* line, int64_t time = -1);
+	// start of a new output, the next lines belong to the summary of a snapshot
+	void reset() {
+		process_lines = false;
+	}
+	static const std::vector<std::string> explodeTop(const std::string& line);
+	// like explodeTop, but the tokens point into line (at most max, ended by a space or the end of line)
+	static int splitTop(const char* line, const char** tokens, int max);
+	static int64_t parseTopMem(const std::string& value);
+	static int64_t parseTopMem(const char* value);
+private:
+	const std::vector<pid_t>* targets;
+	std::vector<sampleBuffer>* buffers;
+	// currently reading the process lines, time stamp of the current snapshot
+	bool process_lines;
+	int64_t timestamp;
+};
+
+#endif /* TOPPARSER_H */
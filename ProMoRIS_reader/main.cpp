@@ -0,0 +1,195 @@
+/*
+ * This file is part of ProMoRIS
+ *   - A Process Monitoring and Resource Information System.
+ * Copyright (C) 2017 J. Flaig
+ *
+ * ProMoRIS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ProMoRIS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ProMoRIS.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#include "../ProMoRIS/binlog.h"
+
+static const char* typeName(field_type_t type) {
+	switch (type) {
+		case FIELD_TIME: return "time";
+		case FIELD_INT64: return "int64";
+		case FIELD_DOUBLE: return "double";
+		case FIELD_STRING: return "string";
+	}
+	return "unknown";
+}
+
+// UNIX time stamp in seconds, with as many decimal places as the log has units per second
+static void appendTime(std::string& line, int64_t time, int64_t time_per_second) {
+	char buffer[32];
+	int digits = 0;
+	for (int64_t unit = time_per_second; unit >= 10; unit /= 10) ++digits;
+	if (digits == 0) {
+		snprintf(buffer, sizeof (buffer), "%lld", static_cast<long long> (time / time_per_second));
+	} else {
+		int64_t seconds = time / time_per_second;
+		int64_t fraction = time % time_per_second;
+		if (fraction < 0) {
+			--seconds;
+			fraction += time_per_second;
+		}
+		snprintf(buffer, sizeof (buffer), "%lld.%0*lld", static_cast<long long> (seconds), digits,
+				static_cast<long long> (fraction));
+	}
+	line += buffer;
+}
+
+/*
+ *
+ */
+int main(int argc, char** argv) {
+
+	// print help
+	if (argc <= 1 || strcmp(argv[1], "-h") == 0) {
+		std::cout << "Usage:\n"
+				"promoris-read LOGFILE [-l] [-s START] [-e END] [-c PREFIX:COLUMN]*\n\n"
+				"Prints the rows of a binary log written by promoris -O binary as tab-separated text.\n\n"
+				"Options explained:\n"
+				"-l -- list the columns and blocks of LOGFILE instead of printing rows\n"
+				"-s START -- only print rows with a time stamp not before START (seconds)\n"
+				"-e END -- only print rows with a time stamp not after END (seconds)\n"
+				"-c PREFIX:COLUMN -- only print the column COLUMN of the module with PREFIX, "
+				"may be passed several times (default: all columns)"
+				<< std::endl;
+		return 0;
+	}
+
+	int arg_mode = 0;
+	bool list = false;
+	const char* start_s = nullptr;
+	const char* end_s = nullptr;
+	std::vector<std::string> selected;
+	for (int i = 2; i < argc; ++i) {
+		if (arg_mode == 1) {
+			start_s = argv[i];
+			arg_mode = 0;
+		} else if (arg_mode == 2) {
+			end_s = argv[i];
+			arg_mode = 0;
+		} else if (arg_mode == 3) {
+			selected.push_back(argv[i]);
+			arg_mode = 0;
+		} else if (strcmp(argv[i], "-l") == 0) {
+			list = true;
+		} else if (strcmp(argv[i], "-s") == 0) {
+			arg_mode = 1;
+		} else if (strcmp(argv[i], "-e") == 0) {
+			arg_mode = 2;
+		} else if (strcmp(argv[i], "-c") == 0) {
+			arg_mode = 3;
+		} else {
+			std::cerr << "Unknown option " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	binlogReader reader;
+	std::string error;
+	if (!reader.open(argv[1], error)) {
+		std::cerr << "Cannot read " << argv[1] << ": " << error << std::endl;
+		return 1;
+	}
+	if (reader.recovered()) {
+		std::cerr << "Index missing, recovered " << reader.blockCount() << " blocks from the block headers" << std::endl;
+	}
+
+	const std::vector<binlog_column_t>& columns = reader.columns();
+
+	if (list) {
+		std::cout << "Columns:" << std::endl;
+		for (auto &column : columns) {
+			std::cout << column.prefix << ":" << column.label << "\t" << typeName(column.type) << std::endl;
+		}
+		std::cout << "Blocks: " << reader.blockCount() << std::endl;
+		for (size_t block_i = 0; block_i < reader.blockCount(); ++block_i) {
+			const binlog_index_entry_t& info = reader.blockInfo(block_i);
+			std::cout << info.offset << "\t" << info.rows << " rows\t" << info.first_time << "\t" << info.last_time << std::endl;
+		}
+		return 0;
+	}
+
+	// column subset
+	std::vector<uint32_t> column_indices;
+	for (uint32_t col_i = 0; col_i < columns.size(); ++col_i) {
+		if (selected.empty()) {
+			column_indices.push_back(col_i);
+			continue;
+		}
+		for (auto &name : selected) {
+			if (name == columns[col_i].prefix + ":" + columns[col_i].label) column_indices.push_back(col_i);
+		}
+	}
+
+	// time range in units of the log
+	int64_t start = std::numeric_limits<int64_t>::min();
+	int64_t end = std::numeric_limits<int64_t>::max();
+	if (start_s != nullptr) start = static_cast<int64_t> (atof(start_s) * reader.timePerSecond());
+	if (end_s != nullptr) end = static_cast<int64_t> (atof(end_s) * reader.timePerSecond());
+
+	std::string line = "time";
+	for (auto col_i : column_indices) {
+		line += '\t';
+		line += columns[col_i].prefix + ":" + columns[col_i].label;
+	}
+	line += '\n';
+	fwrite(line.data(), 1, line.size(), stdout);
+
+	// only the blocks in the time range are touched
+	char buffer[32];
+	for (size_t block_i = reader.findBlock(start); block_i < reader.blockCount(); ++block_i) {
+		if (reader.blockInfo(block_i).first_time > end) break;
+		binlog_block_t block = reader.block(block_i);
+		for (uint32_t row = 0; row < block.rows; ++row) {
+			if (block.times[row] < start || block.times[row] > end) continue;
+			line.clear();
+			appendTime(line, block.times[row], reader.timePerSecond());
+			for (auto col_i : column_indices) {
+				line += '\t';
+				if (!block.present(col_i, row)) continue;
+				switch (columns[col_i].type) {
+					case FIELD_TIME:
+						appendTime(line, block.value(col_i, row).i, reader.timePerSecond());
+						break;
+					case FIELD_INT64:
+						snprintf(buffer, sizeof (buffer), "%lld", static_cast<long long> (block.value(col_i, row).i));
+						line += buffer;
+						break;
+					case FIELD_DOUBLE:
+						snprintf(buffer, sizeof (buffer), "%.2f", block.value(col_i, row).d);
+						line += buffer;
+						break;
+					case FIELD_STRING:
+						line += block.string(col_i, row);
+						break;
+				}
+			}
+			line += '\n';
+			fwrite(line.data(), 1, line.size(), stdout);
+		}
+	}
+
+	return 0;
+
+}
@@ -0,0 +1,239 @@
+/*
+ * ResourceUtilizer - A small benchmark tool for testing ProMoRIS.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ResourceUtilizer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ResourceUtilizer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ResourceUtilizer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "generators.h"
+#include "workload.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// idle generators check their rate this often
+#define IDLE_NS 10000000LL
+// blocking socket calls return this often to check for stopping
+#define SOCKET_TIMEOUT_US 100000
+
+bool ratePacer::wait(double rate, double amount) {
+	int64_t now = monotonicNs();
+	if (!(rate > 0)) {
+		next_ns = 0;
+		sleepUntilNs(now + IDLE_NS);
+		return false;
+	}
+	if (next_ns == 0 || now - next_ns > PACER_MAX_LAG_NS) next_ns = now;
+	sleepUntilNs(next_ns);
+	next_ns += static_cast<int64_t> (amount * 1000000000.0 / rate);
+	return true;
+}
+
+// NETWORK
+
+static void setTimeouts(int fd) {
+	timeval timeout;
+	timeout.tv_sec = 0;
+	timeout.tv_usec = SOCKET_TIMEOUT_US;
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof (timeout));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof (timeout));
+}
+
+netLoad::netLoad(bool udp, size_t message_size) : use_udp(udp), message_size(message_size), send_fd(-1), receive_fd(-1),
+rate(0.0), stopping(false), sent_bytes(0), received_bytes(0) {
+	sockaddr_in address;
+	memset(&address, 0, sizeof (address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	socklen_t length = sizeof (address);
+
+	// the receiving side gets an ephemeral port on the loopback interface
+	int type = udp ? SOCK_DGRAM : SOCK_STREAM;
+	int listen_fd = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+	int connect_fd = socket(AF_INET, type | SOCK_CLOEXEC, 0);
+	if (listen_fd < 0 || connect_fd < 0 ||
+			bind(listen_fd, reinterpret_cast<sockaddr*> (&address), sizeof (address)) != 0 ||
+			getsockname(listen_fd, reinterpret_cast<sockaddr*> (&address), &length) != 0 ||
+			(!udp && listen(listen_fd, 1) != 0) ||
+			connect(connect_fd, reinterpret_cast<sockaddr*> (&address), sizeof (address)) != 0) {
+		if (listen_fd >= 0) close(listen_fd);
+		if (connect_fd >= 0) close(connect_fd);
+		return;
+	}
+	if (udp) {
+		receive_fd = listen_fd;
+		// room for bursts, so datagrams are only lost when the receiver is really too slow
+		int buffer_size = 4 * 1048576;
+		setsockopt(receive_fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof (buffer_size));
+	} else {
+		receive_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+		close(listen_fd);
+		if (receive_fd < 0) {
+			close(connect_fd);
+			return;
+		}
+	}
+	send_fd = connect_fd;
+	setTimeouts(send_fd);
+	setTimeouts(receive_fd);
+	sender = std::thread(&netLoad::sendLoop, this);
+	receiver = std::thread(&netLoad::receiveLoop, this);
+}
+
+netLoad::~netLoad() {
+	stopping = true;
+	if (sender.joinable()) sender.join();
+	if (receiver.joinable()) receiver.join();
+	if (send_fd >= 0) close(send_fd);
+	if (receive_fd >= 0) close(receive_fd);
+}
+
+void netLoad::sendLoop() {
+	std::vector<char> message(message_size, 'r');
+	ratePacer pacer;
+	while (!stopping) {
+		if (!pacer.wait(rate, message_size)) continue;
+		ssize_t n = ::send(send_fd, message.data(), message_size, MSG_NOSIGNAL);
+		if (n > 0) sent_bytes += n;
+	}
+}
+
+void netLoad::receiveLoop() {
+	std::vector<char> buffer(std::max<size_t>(message_size, 65536));
+	while (!stopping) {
+		ssize_t n = recv(receive_fd, buffer.data(), buffer.size(), 0);
+		if (n > 0) received_bytes += n;
+		else if (n == 0 && !use_udp) break;
+	}
+}
+
+// DISK
+
+// create a file in dir which is unlinked at once, opened twice (for writing and reading)
+static int createFile(const std::string& dir, int flags, int& second_fd, std::string& error) {
+	std::string path = dir + "/resourceutilizer.XXXXXX";
+	int fd = mkostemp(&path[0], O_CLOEXEC);
+	if (fd < 0) {
+		error = "cannot create a file in " + dir + ": " + strerror(errno);
+		return -1;
+	}
+	close(fd);
+	fd = open(path.c_str(), O_RDWR | O_CLOEXEC | flags);
+	second_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | flags);
+	if (fd < 0 || second_fd < 0) {
+		error = "cannot open a file in " + dir + ((flags & O_DIRECT) != 0 ? " with O_DIRECT: " : ": ") + strerror(errno);
+		if (fd >= 0) close(fd);
+		if (second_fd >= 0) close(second_fd);
+		fd = -1;
+	}
+	unlink(path.c_str());
+	return fd;
+}
+
+diskLoad::diskLoad(const std::string& dir, bool direct, size_t block_size) : directory(dir), use_direct(direct),
+block_size(block_size), read_fd(-1), write_rate(0.0), read_rate(0.0), stopping(false), written_bytes(0), read_bytes(0) {
+	write_fd = createFile(dir, direct ? O_DIRECT : 0, read_fd, error_text);
+	if (write_fd < 0) return;
+	writer = std::thread(&diskLoad::writeLoop, this);
+	reader = std::thread(&diskLoad::readLoop, this);
+}
+
+diskLoad::~diskLoad() {
+	stopping = true;
+	if (writer.joinable()) writer.join();
+	if (reader.joinable()) reader.join();
+	if (write_fd >= 0) close(write_fd);
+	if (read_fd >= 0) close(read_fd);
+}
+
+// buffer aligned for O_DIRECT
+static char* alignedBuffer(size_t size) {
+	void* buffer = nullptr;
+	if (posix_memalign(&buffer, 4096, size) != 0) return nullptr;
+	memset(buffer, 'r', size);
+	return static_cast<char*> (buffer);
+}
+
+void diskLoad::writeLoop() {
+	char* buffer = alignedBuffer(block_size);
+	if (buffer == nullptr) return;
+	ratePacer pacer;
+	off_t offset = 0;
+	while (!stopping) {
+		if (!pacer.wait(write_rate, block_size)) continue;
+		ssize_t n = ::pwrite(write_fd, buffer, block_size, offset);
+		if (n <= 0) continue;
+		written_bytes += n;
+		offset += n;
+		if (offset + static_cast<off_t> (block_size) > DISK_FILE_BYTES) offset = 0;
+	}
+	free(buffer);
+}
+
+void diskLoad::readLoop() {
+	char* buffer = alignedBuffer(block_size);
+	if (buffer == nullptr) return;
+	ratePacer pacer;
+	off_t offset = 0;
+	while (!stopping) {
+		// only the part of the file which was written already
+		off_t extent = std::min<uint64_t>(written_bytes, DISK_FILE_BYTES) / block_size * block_size;
+		if (extent == 0) {
+			pacer.wait(0, 0);
+			continue;
+		}
+		if (!pacer.wait(read_rate, block_size)) continue;
+		if (offset >= extent) offset = 0;
+		if (!use_direct) posix_fadvise(read_fd, offset, block_size, POSIX_FADV_DONTNEED);
+		ssize_t n = ::pread(read_fd, buffer, block_size, offset);
+		if (n <= 0) continue;
+		read_bytes += n;
+		offset += n;
+	}
+	free(buffer);
+}
+
+// FSYNC
+
+fsyncLoad::fsyncLoad(const std::string& dir) : directory(dir), rate(0.0), stopping(false), sync_count(0) {
+	int second_fd;
+	std::string error;
+	fd = createFile(dir, 0, second_fd, error);
+	if (fd < 0) return;
+	close(second_fd);
+	syncer = std::thread(&fsyncLoad::syncLoop, this);
+}
+
+fsyncLoad::~fsyncLoad() {
+	stopping = true;
+	if (syncer.joinable()) syncer.join();
+	if (fd >= 0) close(fd);
+}
+
+void fsyncLoad::syncLoop() {
+	char buffer[FSYNC_BYTES];
+	memset(buffer, 'r', sizeof (buffer));
+	ratePacer pacer;
+	while (!stopping) {
+		if (!pacer.wait(rate, 1)) continue;
+		if (::pwrite(fd, buffer, sizeof (buffer), 0) > 0 && fsync(fd) == 0) ++sync_count;
+	}
+}
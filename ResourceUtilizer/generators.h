@@ -0,0 +1,176 @@
+/*
+ * ResourceUtilizer - A small benchmark tool for testing ProMoRIS.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ResourceUtilizer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ResourceUtilizer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ResourceUtilizer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// a generator which falls behind its rate by more than this restarts pacing instead of bursting
+#define PACER_MAX_LAG_NS 100000000LL
+// size of the file the disk load writes to and reads from (cyclically)
+#define DISK_FILE_BYTES (256LL * 1048576LL)
+// bytes written before every fsync of the fsync storm
+#define FSYNC_BYTES 4096
+
+/*
+ * Paces the operations of a generator thread to a rate in units (e.g. bytes) per second.
+ * Falling behind (a slow disk or a busy core) is not caught up with bursts,
+ * the achieved rate is what the generators count.
+ */
+class ratePacer {
+public:
+	ratePacer() : next_ns(0) {}
+	// wait until an operation of amount units may start at rate units per second
+	// returns false after waiting a moment if rate is 0
+	bool wait(double rate, double amount);
+private:
+	int64_t next_ns;
+};
+
+/*
+ * Loopback network load: a sender thread sends messages of message_size bytes over TCP or UDP
+ * at a target rate to a receiver thread of the same process.
+ */
+class netLoad {
+public:
+	netLoad(bool udp, size_t message_size);
+	~netLoad();
+	// false if the sockets could not be set up
+	bool ok() const {
+		return send_fd >= 0;
+	}
+	bool udp() const {
+		return use_udp;
+	}
+	size_t messageSize() const {
+		return message_size;
+	}
+	void set(double bits_per_second) {
+		rate = bits_per_second / 8.0;
+	}
+	uint64_t sent() const {
+		return sent_bytes;
+	}
+	uint64_t received() const {
+		return received_bytes;
+	}
+private:
+	bool use_udp;
+	size_t message_size;
+	int send_fd;
+	int receive_fd;
+	// bytes per second
+	std::atomic<double> rate;
+	std::atomic<bool> stopping;
+	std::atomic<uint64_t> sent_bytes;
+	std::atomic<uint64_t> received_bytes;
+	std::thread sender;
+	std::thread receiver;
+	void sendLoop();
+	void receiveLoop();
+};
+
+/*
+ * Disk load: a writer thread writes blocks to a file at a target rate, a reader thread reads
+ * the written part back at its own rate. The file is unlinked right after it was created.
+ * With direct I/O (O_DIRECT) the page cache is bypassed, buffered reads drop the cached
+ * pages first (posix_fadvise), so they reach the disk as well.
+ */
+class diskLoad {
+public:
+	// block_size must be a multiple of 4096 for direct I/O
+	diskLoad(const std::string& dir, bool direct, size_t block_size);
+	~diskLoad();
+	// false and error set if the file could not be created
+	bool ok() const {
+		return write_fd >= 0;
+	}
+	const std::string& error() const {
+		return error_text;
+	}
+	const std::string& dir() const {
+		return directory;
+	}
+	bool direct() const {
+		return use_direct;
+	}
+	size_t blockSize() const {
+		return block_size;
+	}
+	// bytes per second
+	void set(double write_rate, double read_rate) {
+		this->write_rate = write_rate;
+		this->read_rate = read_rate;
+	}
+	uint64_t written() const {
+		return written_bytes;
+	}
+	uint64_t read() const {
+		return read_bytes;
+	}
+private:
+	std::string directory;
+	bool use_direct;
+	size_t block_size;
+	int write_fd;
+	int read_fd;
+	std::string error_text;
+	std::atomic<double> write_rate;
+	std::atomic<double> read_rate;
+	std::atomic<bool> stopping;
+	std::atomic<uint64_t> written_bytes;
+	std::atomic<uint64_t> read_bytes;
+	std::thread writer;
+	std::thread reader;
+	void writeLoop();
+	void readLoop();
+};
+
+// fsync storm: FSYNC_BYTES are written to a file and synced at a target rate
+class fsyncLoad {
+public:
+	fsyncLoad(const std::string& dir);
+	~fsyncLoad();
+	bool ok() const {
+		return fd >= 0;
+	}
+	const std::string& dir() const {
+		return directory;
+	}
+	void set(double per_second) {
+		rate = per_second;
+	}
+	uint64_t syncs() const {
+		return sync_count;
+	}
+private:
+	std::string directory;
+	int fd;
+	std::atomic<double> rate;
+	std::atomic<bool> stopping;
+	std::atomic<uint64_t> sync_count;
+	std::thread syncer;
+	void syncLoop();
+};
+
+#endif /* GENERATORS_H */
@@ -18,27 +18,18 @@
 
 #include <cstdlib>
 #include <iostream>
+#include <fstream>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <cstring>
+#include "workload.h"
 #include <unistd.h>
 #include <spawn.h>
 #include <sys/wait.h>
 
 using namespace std;
 
-std::string randomString(size_t length) {
-	auto getRandomChar = []() -> char {
-		const char characters[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-		const size_t clength = (sizeof (characters) - 1);
-		return characters[ rand() % clength ];
-	};
-	std::string ret(length, 0);
-	std::generate_n(ret.begin(), length, getRandomChar);
-	return ret;
-}
-
 /*
  * 
  */
@@ -48,14 +39,44 @@ int main(int argc, char** argv) {
 	if (argc <= 1 || strcmp(argv[1], "-h") == 0) {
 		std::cout << "Usage:\n"
 				"resourceutilizer [-i ITERATIONS] [-s SLEEPTIME] [-c MULTIPLIER] "
-				"[-m MEMORY] [-v] [-n NAME]\n\n"
+				"[-m MEMORY] [-v] [-n NAME]\n"
+				"resourceutilizer -p PROFILE [-g TIMELINE] [-r RATES] [-i ITERATIONS] [-v] [-n NAME]\n\n"
 				"Options explained:\n"
 				"-i ITERATIONS -- run ITERATIONS iterations (instead of unlimited)\n"
 				"-s SLEEPTIME -- sleep for SLEEPTIME seconds between 2 iterations (default 0)\n"
 				"-c MULTIPLIER -- enable CPU test with multiplier MULTIPLIER\n"
 				"-m MEMORY -- enable memory test with MEMORY MB to write to memory\n"
 				"-v -- verbose mode (print start and end of iterations, tests and sleep)\n"
-				"-n NAME -- name this instance and use it in verbose output (only useful together with -v)"
+				"-n NAME -- name this instance and use it in verbose output (only useful together with -v)\n"
+				"-p PROFILE -- run the workload profile in file PROFILE (once, or ITERATIONS times)\n"
+				"-g TIMELINE -- write the ground truth of the profile to TIMELINE (CSV, one line per phase)\n"
+				"-r RATES -- write the achieved CPU load, rates and memory to RATES every second (CSV)\n\n"
+				"Profiles:\n"
+				"One phase per line, '#' starts a comment:\n"
+				"DURATION [name=NAME] [cpu=PERCENT] [threads=THREADS] [rss=MB] [ramp]\n"
+				"	[net=MBIT] [proto=tcp|udp] [msg=BYTES] [write=MB] [read=MB] [io=buffered|direct] [block=KB]\n"
+				"	[fsync=SYNCS] [dir=DIR]\n"
+				"DURATION -- length of the phase in seconds (e.g. 2.5), phases start on exact deadlines\n"
+				"PERCENT -- CPU load in % of one core, spread evenly over THREADS threads with a 10 ms duty cycle\n"
+				"THREADS -- number of busy threads (default: as few as PERCENT needs)\n"
+				"MB -- anonymous memory resident at the end of the phase (exact to a page)\n"
+				"ramp -- change the memory linearly over the phase instead of at its start\n"
+				"MBIT -- loopback network load in Mbit/s, sent and received by threads of ResourceUtilizer\n"
+				"tcp|udp -- protocol of the network load (default tcp)\n"
+				"BYTES -- bytes per send call or datagram (default 65536 for tcp, 1400 for udp)\n"
+				"MB -- (write, read) disk load in MB/s on a temporary file in DIR, reads use the part already written\n"
+				"buffered|direct -- buffered I/O (reads drop the cached pages first) or O_DIRECT (default buffered)\n"
+				"KB -- size of the disk writes and reads, a multiple of 4 (default 1024)\n"
+				"SYNCS -- fsync storm: 4 KB writes followed by fsync, SYNCS times per second\n"
+				"DIR -- directory of the temporary files (default .), they are unlinked right after creation\n"
+				"All loads of a phase run at the same time. Rates which cannot be reached are not caught up later.\n"
+				"Settings which are not given are taken over from the previous phase.\n"
+				"Example:\n"
+				"5 name=idle\n"
+				"10 name=busy cpu=150 rss=256 ramp\n"
+				"5 name=plateau cpu=50 net=100 write=20 fsync=50\n"
+				"The timeline contains the start and end (UNIX time, comparable with ProMoRIS), the targets and\n"
+				"the achieved CPU load (CPU time of the whole process), rates and resident memory of every phase."
 				<< std::endl;
 		return 0;
 	}
@@ -67,6 +88,9 @@ int main(int argc, char** argv) {
 	long mem_mb = 0;
 	bool verbose = false;
 	const char* iname = "ru";
+	const char* profile_file = nullptr;
+	const char* timeline_file = nullptr;
+	const char* rates_file = nullptr;
 	for (int i = 1; i < argc; ++i) {
 		if (arg_mode == 1) {
 			iterations = atoi(argv[i]);
@@ -80,6 +104,15 @@ int main(int argc, char** argv) {
 		} else if (arg_mode == 4) {
 			mem_mb = atoi(argv[i]);
 			arg_mode = 0;
+		} else if (arg_mode == 5) {
+			profile_file = argv[i];
+			arg_mode = 0;
+		} else if (arg_mode == 6) {
+			timeline_file = argv[i];
+			arg_mode = 0;
+		} else if (arg_mode == 7) {
+			rates_file = argv[i];
+			arg_mode = 0;
 		} else if (arg_mode == 9) {
 			iname = argv[i];
 			arg_mode = 0;
@@ -96,7 +129,46 @@ int main(int argc, char** argv) {
 			arg_mode = 0;
 		} else if (strcmp(argv[i], "-n") == 0) {
 			arg_mode = 9;
+		} else if (strcmp(argv[i], "-p") == 0) {
+			arg_mode = 5;
+		} else if (strcmp(argv[i], "-g") == 0) {
+			arg_mode = 6;
+		} else if (strcmp(argv[i], "-r") == 0) {
+			arg_mode = 7;
+		}
+	}
+
+	// workload profile
+	if (profile_file != nullptr) {
+		std::ifstream profile(profile_file);
+		if (!profile) {
+			std::cerr << "Could not open profile " << profile_file << std::endl;
+			return 1;
+		}
+		std::vector<phase_t> phases;
+		std::string error;
+		if (!parseProfile(profile, phases, error)) {
+			std::cerr << "Invalid profile " << profile_file << ": " << error << std::endl;
+			return 1;
+		}
+		std::ofstream timeline;
+		if (timeline_file != nullptr) {
+			timeline.open(timeline_file);
+			if (!timeline) {
+				std::cerr << "Could not open timeline " << timeline_file << std::endl;
+				return 1;
+			}
 		}
+		std::ofstream rates;
+		if (rates_file != nullptr) {
+			rates.open(rates_file);
+			if (!rates) {
+				std::cerr << "Could not open rates log " << rates_file << std::endl;
+				return 1;
+			}
+		}
+		return runProfile(phases, iterations < 0 ? 1 : iterations, timeline_file != nullptr ? &timeline : nullptr,
+				rates_file != nullptr ? &rates : nullptr, verbose, iname);
 	}
 
 	for (long il = iterations; il != 0; --il) {
@@ -111,13 +183,11 @@ int main(int argc, char** argv) {
 			if (verbose) std::cout << iname << ": Done with CPU test" << std::endl;
 		}
 
-		// cpu + memory
+		// memory, resident until the end of the test
 		if (mem_mb > 0) {
 			if (verbose) std::cout << iname << ": Starting memory test" << std::endl;
-			std::vector<std::string> testmem;
-			for (long i = 0; i < mem_mb; ++i) {
-				testmem.push_back(randomString(1048576));
-			}
+			memoryLoad testmem(mem_mb * 1048576);
+			testmem.set(mem_mb * 1048576);
 			if (verbose) std::cout << iname << ": Done with memory test" << std::endl;
 		}
 
@@ -0,0 +1,408 @@
+/*
+ * ResourceUtilizer - A small benchmark tool for testing ProMoRIS.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ResourceUtilizer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ResourceUtilizer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ResourceUtilizer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "workload.h"
+#include "generators.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static int64_t clockNs(clockid_t clock) {
+	timespec ts;
+	clock_gettime(clock, &ts);
+	return static_cast<int64_t> (ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t monotonicNs() {
+	return clockNs(CLOCK_MONOTONIC);
+}
+
+int64_t threadCpuNs() {
+	return clockNs(CLOCK_THREAD_CPUTIME_ID);
+}
+
+int64_t processCpuNs() {
+	return clockNs(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void sleepUntilNs(int64_t time) {
+	timespec ts;
+	ts.tv_sec = time / 1000000000LL;
+	ts.tv_nsec = time % 1000000000LL;
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR);
+}
+
+std::string wallTime(int64_t time) {
+	// measured once like in ProMoRIS, so the time stamps of both can be compared
+	static const int64_t offset = clockNs(CLOCK_REALTIME) - monotonicNs();
+	int64_t wall_us = (time + offset) / 1000;
+	char text[32];
+	snprintf(text, sizeof (text), "%lld.%06lld", static_cast<long long> (wall_us / 1000000), static_cast<long long> (wall_us % 1000000));
+	return text;
+}
+
+bool parseProfile(std::istream& in, std::vector<phase_t>& phases, std::string& error) {
+	// values which are not given are taken over from the previous phase
+	phase_t current = {"", 0, 0.0, 0, 0, false, 0.0, false, 0, 0.0, 0.0, false, 1048576, 0.0, "."};
+	bool message_size_given = false;
+	bool threads_given = false;
+	std::string line;
+	for (int line_i = 1; std::getline(in, line); ++line_i) {
+		line = line.substr(0, line.find('#'));
+		std::istringstream tokens(line);
+		std::string token;
+		if (!(tokens >> token)) continue;
+
+		std::string where = "line " + std::to_string(line_i) + ": ";
+		char* end;
+		double duration = strtod(token.c_str(), &end);
+		if (*end != '\0' || !(duration > 0)) {
+			error = where + "invalid duration " + token;
+			return false;
+		}
+		current.duration_ns = static_cast<int64_t> (duration * 1000000000.0);
+		current.name = "phase" + std::to_string(phases.size());
+		current.ramp = false;
+		bool cpu_given = false;
+
+		while (tokens >> token) {
+			size_t equals = token.find('=');
+			std::string key = token.substr(0, equals);
+			std::string value = equals == std::string::npos ? "" : token.substr(equals + 1);
+			double number = strtod(value.c_str(), &end);
+			bool numeric = !value.empty() && *end == '\0' && number >= 0;
+			if (key == "ramp" && value.empty()) {
+				current.ramp = true;
+			} else if (key == "name" && !value.empty()) {
+				current.name = value;
+			} else if (key == "cpu" && numeric) {
+				current.cpu_percent = number;
+				cpu_given = true;
+			} else if (key == "threads" && numeric && number >= 1 && number == std::floor(number)) {
+				current.threads = static_cast<int> (number);
+				threads_given = true;
+			} else if (key == "rss" && numeric) {
+				current.rss_bytes = static_cast<size_t> (number * 1048576.0);
+			} else if (key == "net" && numeric) {
+				current.net_bps = number * 1000000.0;
+			} else if (key == "proto" && (value == "tcp" || value == "udp")) {
+				current.net_udp = value == "udp";
+			} else if (key == "msg" && numeric && number >= 1 && number <= 65507) {
+				current.message_size = static_cast<size_t> (number);
+				message_size_given = true;
+			} else if (key == "write" && numeric) {
+				current.write_rate = number * 1048576.0;
+			} else if (key == "read" && numeric) {
+				current.read_rate = number * 1048576.0;
+			} else if (key == "io" && (value == "direct" || value == "buffered")) {
+				current.direct_io = value == "direct";
+			} else if (key == "block" && numeric && number >= 4 && std::fmod(number, 4.0) == 0.0) {
+				current.block_size = static_cast<size_t> (number) * 1024;
+			} else if (key == "fsync" && numeric) {
+				current.fsync_rate = number;
+			} else if (key == "dir" && !value.empty()) {
+				current.dir = value;
+			} else {
+				error = where + "invalid setting " + token;
+				return false;
+			}
+		}
+
+		// without a message size, one suiting the protocol
+		if (!message_size_given) current.message_size = current.net_udp ? 1400 : 65536;
+		// without a number of threads, as many as needed
+		if (!threads_given && (cpu_given || phases.empty())) current.threads = std::max(1, static_cast<int> (std::ceil(current.cpu_percent / 100.0)));
+		if (current.cpu_percent > 100.0 * current.threads) {
+			char text[64];
+			snprintf(text, sizeof (text), "cpu=%g needs more than %d threads", current.cpu_percent, current.threads);
+			error = where + text;
+			return false;
+		}
+		phases.push_back(current);
+	}
+	if (phases.empty()) {
+		error = "no phases";
+		return false;
+	}
+	return true;
+}
+
+// CPU
+
+cpuLoad::cpuLoad(int max_threads) : duty(0.0), active(0), stopping(false) {
+	for (int thread_i = 0; thread_i < max_threads; ++thread_i) {
+		workers.push_back(std::thread(&cpuLoad::run, this, thread_i));
+	}
+}
+
+cpuLoad::~cpuLoad() {
+	stopping = true;
+	for (auto &worker : workers) worker.join();
+}
+
+void cpuLoad::set(double percent, int threads) {
+	threads = std::min(threads, static_cast<int> (workers.size()));
+	duty = threads > 0 ? std::min(1.0, percent / 100.0 / threads) : 0.0;
+	active = threads;
+}
+
+void cpuLoad::run(int thread_i) {
+	uint64_t state = 88172645463325252ULL + thread_i;
+	volatile uint64_t sink;
+	int64_t period_start = monotonicNs();
+	while (!stopping) {
+		int64_t busy_ns = static_cast<int64_t> ((thread_i < active ? duty.load() : 0.0) * DUTY_PERIOD_NS);
+		int64_t cpu_start = threadCpuNs();
+		while (busy_ns > 0 && threadCpuNs() - cpu_start < busy_ns) {
+			for (int i = 0; i < 1000; ++i) {
+				state ^= state << 13;
+				state ^= state >> 7;
+				state ^= state << 17;
+			}
+		}
+		sink = state;
+
+		period_start += DUTY_PERIOD_NS;
+		// behind by more than a period (e.g. the cores are busy), start a new period instead of catching up
+		int64_t now = monotonicNs();
+		if (period_start < now - DUTY_PERIOD_NS) period_start = now;
+		sleepUntilNs(period_start);
+	}
+	(void) sink;
+}
+
+// MEMORY
+
+memoryLoad::memoryLoad(size_t max_bytes) : region(nullptr), touched(0) {
+	page_size = sysconf(_SC_PAGESIZE);
+	capacity = (max_bytes + page_size - 1) / page_size * page_size;
+	if (capacity == 0) return;
+	void* p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (p == MAP_FAILED) {
+		std::cerr << "Could not reserve " << capacity << " bytes: " << strerror(errno) << std::endl;
+		capacity = 0;
+		return;
+	}
+	region = static_cast<char*> (p);
+	madvise(region, capacity, MADV_NOHUGEPAGE);
+}
+
+memoryLoad::~memoryLoad() {
+	if (region != nullptr) munmap(region, capacity);
+}
+
+void memoryLoad::set(size_t bytes) {
+	bytes = std::min((bytes + page_size - 1) / page_size * page_size, capacity);
+	if (bytes > touched) {
+		// a single write makes a page resident
+		for (size_t offset = touched; offset < bytes; offset += page_size) region[offset] = 1;
+	} else if (bytes < touched) {
+		madvise(region + bytes, touched - bytes, MADV_DONTNEED);
+	}
+	touched = bytes;
+}
+
+size_t processRss() {
+	std::ifstream statm("/proc/self/statm");
+	size_t size = 0, resident = 0;
+	statm >> size >> resident;
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+// PROFILE
+
+// achieved totals of all generators
+typedef struct totals_t {
+	int64_t time;
+	int64_t cpu_ns;
+	uint64_t net_sent;
+	uint64_t net_received;
+	uint64_t written;
+	uint64_t read;
+	uint64_t syncs;
+} totals_t;
+
+/*
+ * Generators of a profile: created when a phase needs them, recreated when
+ * their setup (protocol, message size, I/O mode, block size, directory) changes.
+ */
+class generatorSet {
+public:
+	// false if a generator could not be set up
+	bool apply(const phase_t& phase) {
+		if (phase.net_bps > 0 && (!net || net->udp() != phase.net_udp || net->messageSize() != phase.message_size)) {
+			if (net) {
+				retired.net_sent += net->sent();
+				retired.net_received += net->received();
+			}
+			net.reset(new netLoad(phase.net_udp, phase.message_size));
+			if (!net->ok()) {
+				std::cerr << "Could not set up the loopback network load" << std::endl;
+				return false;
+			}
+		}
+		if ((phase.write_rate > 0 || phase.read_rate > 0) && (!disk || disk->dir() != phase.dir ||
+				disk->direct() != phase.direct_io || disk->blockSize() != phase.block_size)) {
+			if (disk) {
+				retired.written += disk->written();
+				retired.read += disk->read();
+			}
+			disk.reset(new diskLoad(phase.dir, phase.direct_io, phase.block_size));
+			if (!disk->ok()) {
+				std::cerr << "Could not set up the disk load: " << disk->error() << std::endl;
+				return false;
+			}
+		}
+		if (phase.fsync_rate > 0 && (!sync || sync->dir() != phase.dir)) {
+			if (sync) retired.syncs += sync->syncs();
+			sync.reset(new fsyncLoad(phase.dir));
+			if (!sync->ok()) {
+				std::cerr << "Could not set up the fsync load in " << phase.dir << std::endl;
+				return false;
+			}
+		}
+		if (net) net->set(phase.net_bps);
+		if (disk) disk->set(phase.write_rate, phase.read_rate);
+		if (sync) sync->set(phase.fsync_rate);
+		return true;
+	}
+
+	totals_t totals() const {
+		totals_t current = retired;
+		current.time = monotonicNs();
+		current.cpu_ns = processCpuNs();
+		if (net) {
+			current.net_sent += net->sent();
+			current.net_received += net->received();
+		}
+		if (disk) {
+			current.written += disk->written();
+			current.read += disk->read();
+		}
+		if (sync) current.syncs += sync->syncs();
+		return current;
+	}
+private:
+	std::unique_ptr<netLoad> net;
+	std::unique_ptr<diskLoad> disk;
+	std::unique_ptr<fsyncLoad> sync;
+	// totals of the generators which were replaced
+	totals_t retired = {0, 0, 0, 0, 0, 0, 0};
+};
+
+// rates between two totals: CPU in %, network in Mbit/s, disk in MB/s, fsyncs per second,
+// followed by the resident memory of the workload and the process in MB
+static std::string formatRates(const totals_t& from, const totals_t& to, const memoryLoad& memory) {
+	double seconds = (to.time - from.time) / 1000000000.0;
+	char text[200];
+	snprintf(text, sizeof (text), "%.2f,%.3f,%.3f,%.3f,%.3f,%.1f,%.3f,%.3f",
+			100.0 * (to.cpu_ns - from.cpu_ns) / 1000000000.0 / seconds,
+			(to.net_sent - from.net_sent) * 8.0 / 1000000.0 / seconds,
+			(to.net_received - from.net_received) * 8.0 / 1000000.0 / seconds,
+			(to.written - from.written) / 1048576.0 / seconds,
+			(to.read - from.read) / 1048576.0 / seconds,
+			(to.syncs - from.syncs) / seconds,
+			memory.resident() / 1048576.0, processRss() / 1048576.0);
+	return text;
+}
+
+int runProfile(const std::vector<phase_t>& phases, long iterations, std::ostream* timeline, std::ostream* rates,
+		bool verbose, const char* iname) {
+	int max_threads = 0;
+	size_t max_rss = 0;
+	for (auto &phase : phases) {
+		max_threads = std::max(max_threads, phase.threads);
+		max_rss = std::max(max_rss, phase.rss_bytes);
+	}
+	cpuLoad cpu(max_threads);
+	memoryLoad memory(max_rss);
+	generatorSet generators;
+
+	static const char* achieved_header = "cpu_achieved,net_sent_mbit,net_received_mbit,write_mb,read_mb,fsyncs";
+	if (timeline != nullptr) {
+		*timeline << "iteration,phase,name,start,end,cpu_target,threads,rss_target_start_mb,rss_target_end_mb,ramp,"
+				"net_target_mbit,write_target_mb,read_target_mb,fsync_target," << achieved_header <<
+				",rss_workload_mb,rss_process_mb" << std::endl;
+	}
+	if (rates != nullptr) *rates << "time," << achieved_header << ",rss_workload_mb,rss_process_mb" << std::endl;
+
+	// the phases follow each other on absolute deadlines, so they do not drift
+	int64_t phase_start = monotonicNs();
+	totals_t rates_from = generators.totals();
+	int64_t next_rates = phase_start + RATES_INTERVAL_NS;
+	for (long il = iterations, iteration = 0; il != 0; --il, ++iteration) {
+		for (size_t phase_i = 0; phase_i < phases.size(); ++phase_i) {
+			const phase_t& phase = phases[phase_i];
+			int64_t phase_end = phase_start + phase.duration_ns;
+			double rss_from = memory.resident();
+
+			totals_t phase_from = generators.totals();
+			cpu.set(phase.cpu_percent, phase.threads);
+			if (!generators.apply(phase)) return 1;
+			if (!phase.ramp) memory.set(phase.rss_bytes);
+			if (verbose) std::cout << iname << ": Starting phase " << phase.name << std::endl;
+
+			// wake up for the steps of ramps and the lines of the rates log
+			for (int64_t now = monotonicNs(); now < phase_end; now = monotonicNs()) {
+				int64_t wake = phase_end;
+				if (phase.ramp) {
+					double progress = static_cast<double> (now - phase_start) / phase.duration_ns;
+					memory.set(static_cast<size_t> (rss_from + (phase.rss_bytes - rss_from) * progress));
+					wake = std::min<int64_t>(wake, now + RAMP_STEP_NS);
+				}
+				if (rates != nullptr) {
+					if (now >= next_rates) {
+						totals_t rates_to = generators.totals();
+						*rates << wallTime(rates_to.time) << "," << formatRates(rates_from, rates_to, memory) << std::endl;
+						rates_from = rates_to;
+						next_rates += RATES_INTERVAL_NS;
+					}
+					wake = std::min(wake, next_rates);
+				}
+				sleepUntilNs(wake);
+			}
+			memory.set(phase.rss_bytes);
+
+			totals_t phase_to = generators.totals();
+			if (timeline != nullptr) {
+				char targets[256];
+				snprintf(targets, sizeof (targets), "%.2f,%d,%.3f,%.3f,%d,%.3f,%.3f,%.3f,%.1f",
+						phase.cpu_percent, phase.threads, (phase.ramp ? rss_from : phase.rss_bytes) / 1048576.0,
+						phase.rss_bytes / 1048576.0, phase.ramp ? 1 : 0, phase.net_bps / 1000000.0,
+						phase.write_rate / 1048576.0, phase.read_rate / 1048576.0, phase.fsync_rate);
+				*timeline << iteration << "," << phase_i << "," << phase.name << "," << wallTime(phase_from.time) << ","
+						<< wallTime(phase_to.time) << "," << targets << "," << formatRates(phase_from, phase_to, memory) << std::endl;
+			}
+			phase_start = phase_end;
+		}
+	}
+
+	cpu.set(0.0, 0);
+	memory.set(0);
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * ResourceUtilizer - A small benchmark tool for testing ProMoRIS.
+ * Copyright (C) 2017 J. Flaig
+ * 
+ * ResourceUtilizer is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * ResourceUtilizer is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with ResourceUtilizer.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// period of the duty cycle of the CPU load threads
+#define DUTY_PERIOD_NS 10000000LL
+// memory ramps are adjusted in steps of this length
+#define RAMP_STEP_NS 10000000LL
+// interval of the lines of the rates log
+#define RATES_INTERVAL_NS 1000000000LL
+
+// current time of CLOCK_MONOTONIC in nanoseconds
+int64_t monotonicNs();
+// sleep until time (CLOCK_MONOTONIC in nanoseconds)
+void sleepUntilNs(int64_t time);
+// CPU time of the calling thread or of the process in nanoseconds
+int64_t threadCpuNs();
+int64_t processCpuNs();
+// UNIX time in seconds with 6 decimal places of a CLOCK_MONOTONIC time stamp
+std::string wallTime(int64_t time);
+
+// one phase of a workload profile
+typedef struct phase_t {
+	std::string name;
+	int64_t duration_ns;
+	// CPU load in % of one core, spread evenly over threads
+	double cpu_percent;
+	int threads;
+	// anonymous memory resident at the end of the phase
+	size_t rss_bytes;
+	// memory changes linearly over the phase instead of at its start
+	bool ramp;
+	// loopback network load in bit/s
+	double net_bps;
+	bool net_udp;
+	size_t message_size;
+	// disk load in bytes per second
+	double write_rate;
+	double read_rate;
+	bool direct_io;
+	size_t block_size;
+	// fsyncs per second
+	double fsync_rate;
+	// directory of the files of the disk and fsync load
+	std::string dir;
+} phase_t;
+
+// parse a profile, one phase per line: DURATION (KEY=VALUE | ramp)*, see the help of main
+// returns false and sets error for invalid lines
+bool parseProfile(std::istream& in, std::vector<phase_t>& phases, std::string& error);
+
+/*
+ * CPU load with a given duty cycle: every thread is busy for duty * DUTY_PERIOD_NS of
+ * CPU time in each period and sleeps for the rest of it. The busy time is measured
+ * as CPU time of the thread, so the load stays right when the threads have to share cores.
+ */
+class cpuLoad {
+public:
+	cpuLoad(int max_threads);
+	~cpuLoad();
+	// total load in % of one core, spread over the first threads threads (at most 100 % each)
+	void set(double percent, int threads);
+private:
+	std::vector<std::thread> workers;
+	std::atomic<double> duty;
+	std::atomic<int> active;
+	std::atomic<bool> stopping;
+	void run(int thread_i);
+};
+
+/*
+ * Anonymous memory with an exact resident size: a region is reserved once, pages are
+ * made resident by writing to them and released again with madvise(MADV_DONTNEED).
+ * Transparent huge pages are disabled for the region, so the size is exact to a page.
+ */
+class memoryLoad {
+public:
+	memoryLoad(size_t max_bytes);
+	~memoryLoad();
+	// resident bytes of the region (rounded up to pages)
+	void set(size_t bytes);
+	size_t resident() const {
+		return touched;
+	}
+private:
+	char* region;
+	size_t capacity;
+	size_t touched;
+	size_t page_size;
+};
+
+// resident set size of the process in bytes (/proc/self/statm)
+size_t processRss();
+
+// run the phases of a profile iterations times (-1: unlimited)
+// one line per phase is written to timeline (if not nullptr) with the targets and the achieved values,
+// the achieved values are also written to rates every RATES_INTERVAL_NS (if not nullptr)
+int runProfile(const std::vector<phase_t>& phases, long iterations, std::ostream* timeline, std::ostream* rates,
+		bool verbose, const char* iname);
+
+#endif /* WORKLOAD_H */
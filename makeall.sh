@@ -7,6 +7,20 @@ cd ../ProMoRIS_modNethogs
 make
 cd ../ProMoRIS_modTop
 make
+cd ../ProMoRIS_modProc
+make
+cd ../ProMoRIS_modTaskstats
+make
+cd ../ProMoRIS_modSockdiag
+make
+cd ../ProMoRIS_modProbe
+make
+cd ../ProMoRIS_modSynth
+make
+cd ../ProMoRIS_reader
+make
+cd ../ProMoRIS_bench
+make
 cd ../ResourceUtilizer
 make
 cd ..
@@ -15,4 +29,11 @@ cp ProMoRIS/dist/Debug/GNU-Linux/promoris dist/promoris
 cp ProMoRIS_modIperf3/dist/Debug/GNU-Linux/libProMoRIS_modIperf3.so dist/modIperf3.so
 cp ProMoRIS_modNethogs/dist/Debug/GNU-Linux/libProMoRIS_modNethogs.so dist/modNethogs.so
 cp ProMoRIS_modTop/dist/Debug/GNU-Linux/libProMoRIS_modTop.so dist/modTop.so
+cp ProMoRIS_modProc/dist/Debug/GNU-Linux/libProMoRIS_modProc.so dist/modProc.so
+cp ProMoRIS_modTaskstats/dist/Debug/GNU-Linux/libProMoRIS_modTaskstats.so dist/modTaskstats.so
+cp ProMoRIS_modSockdiag/dist/Debug/GNU-Linux/libProMoRIS_modSockdiag.so dist/modSockdiag.so
+cp ProMoRIS_modProbe/dist/Debug/GNU-Linux/libProMoRIS_modProbe.so dist/modProbe.so
+cp ProMoRIS_modSynth/dist/Debug/GNU-Linux/libProMoRIS_modSynth.so dist/modSynth.so
+cp ProMoRIS_reader/dist/Debug/GNU-Linux/promoris-read dist/promoris-read
+cp ProMoRIS_bench/dist/Debug/GNU-Linux/promoris-bench dist/promoris-bench
 cp ResourceUtilizer/dist/Debug/GNU-Linux/resourceutilizer dist/resourceutilizer